@@ -0,0 +1,62 @@
+// Belt update cost against belt tile count. Rows of straight belts heading
+// east, each ending in a chest, loaded to half density so every line is
+// both moving and delivering an item into the chest each few ticks: the
+// worst case for ECSWorld::updateBelts short of every line being a single
+// tile. Reports ms per 60 Hz tick.
+//
+// usage: BeltBench [ticks] [line length]
+
+#include "game/ECS/ecs.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+static double elapsedMs(std::chrono::steady_clock::time_point t0) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+// Lines of belts heading east, a chest at the end of each line
+static void buildFactory(ECSWorld& world, int tiles, int lineLength) {
+    int made = 0;
+    for (int row = 0; made < tiles; row++) {
+        for (int x = 0; x < lineLength && made < tiles; x++, made++)
+            (void)world.createBelt(static_cast<float>(x), static_cast<float>(row), Direction::East);
+        (void)world.createBuilding("models/chest.gltf", static_cast<float>(lineLength), static_cast<float>(row));
+    }
+}
+
+// Two items per tile, half of the line's capacity
+static void loadBelts(ECSWorld& world) {
+    const ItemId ore = ItemRegistry::intern("iron_ore");
+    world.forEach<CBelt>([&](entt::entity e, CBelt&) {
+        (void)world.insertOnBelt(e, ore);
+    });
+    world.updateBelts(0.25f);
+    world.forEach<CBelt>([&](entt::entity e, CBelt&) {
+        (void)world.insertOnBelt(e, ore);
+    });
+}
+
+int main(int argc, char* argv[]) {
+    const int   ticks      = argc > 1 ? std::atoi(argv[1]) : 120;
+    const int   lineLength = argc > 2 ? std::atoi(argv[2]) : 32;
+    const float dt         = 1.0f / ECSWorld::TICKS_PER_SECOND;
+
+    std::printf("%10s %10s %10s %14s\n", "tiles", "lines", "items", "ms/tick");
+
+    for (int tiles : { 1000, 10000, 100000, 1000000 }) {
+        ECSWorld world;
+        buildFactory(world, tiles, lineLength);
+        loadBelts(world);
+        const size_t items = world.transportLines().itemCount();
+
+        const auto t0 = std::chrono::steady_clock::now();
+        for (int t = 0; t < ticks; t++)
+            world.updateBelts(dt);
+        const double ms = elapsedMs(t0) / ticks;
+
+        std::printf("%10d %10zu %10zu %14.3f\n", tiles, world.transportLines().lineCount(), items, ms);
+    }
+    return 0;
+}
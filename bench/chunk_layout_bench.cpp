@@ -0,0 +1,151 @@
+// Compares Chunk (planar / palette storage) against the previous
+// array-of-structs layout (Tile tiles[32][32]) for memory and scan speed.
+// Pass "full" as third argument to force Full storage on every chunk.
+
+#include "game/world/chunk.h"
+
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+// =====================
+// REFERENCE AOS LAYOUT
+// =====================
+struct AosChunk {
+    ChunkPos pos;
+    Tile     tiles[CHUNK_SIZE][CHUNK_SIZE];
+    bool     dirty     = true;
+    bool     generated = false;
+};
+
+static const TileType SAMPLE_TYPES[] = {
+    TileType::DEEP_WATER, TileType::WATER, TileType::GRASS, TileType::GRASS_ALT,
+    TileType::GRASSY_ROCKS, TileType::IRON_ORE, TileType::COPPER_ORE,
+};
+
+// =====================
+// HELPERS
+// =====================
+template<typename Fn>
+static double timeMs(int reps, Fn&& fn) {
+    fn(); // warm-up
+    const auto t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < reps; i++)
+        fn();
+    const auto t1 = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(t1 - t0).count() / reps;
+}
+
+static void report(const char* name, double aosMs, double soaMs) {
+    std::printf("%-22s AoS %8.3f ms   Chunk %8.3f ms   x%.2f\n", name, aosMs, soaMs, aosMs / soaMs);
+}
+
+// =====================
+// MAIN
+// =====================
+int main(int argc, char* argv[]) {
+    const int chunkCount = argc > 1 ? std::atoi(argv[1]) : 2048;
+    const int reps       = argc > 2 ? std::atoi(argv[2]) : 20;
+    const bool forceFull = argc > 3 && std::string(argv[3]) == "full";
+
+    std::vector<std::unique_ptr<AosChunk>> aos(chunkCount);
+    std::vector<std::unique_ptr<Chunk>>    soa(chunkCount);
+
+    std::mt19937 rng(1337);
+    std::uniform_int_distribution<int>    typeDist(0, std::size(SAMPLE_TYPES) - 1);
+    std::uniform_real_distribution<float> elevDist(-1.0f, 1.0f);
+
+    for (int c = 0; c < chunkCount; c++) {
+        aos[c] = std::make_unique<AosChunk>();
+        soa[c] = std::make_unique<Chunk>();
+        for (int y = 0; y < CHUNK_SIZE; y++)
+            for (int x = 0; x < CHUNK_SIZE; x++) {
+                Tile t;
+                t.type      = SAMPLE_TYPES[typeDist(rng)];
+                t.flags     = Tile::defaultFlags(t.type);
+                t.resource  = t.hasResource() ? 64 : 0;
+                t.elevation = elevDist(rng);
+                aos[c]->tiles[y][x] = t;
+                soa[c]->setTile(x, y, t);
+            }
+        if (forceFull)
+            soa[c]->makeFull();
+    }
+
+    size_t chunkBytes = 0;
+    for (const auto& c : soa)
+        chunkBytes += c->memoryUsage();
+
+    std::printf("chunks: %d, reps: %d, storage: %s\n", chunkCount, reps, forceFull ? "full" : "compact");
+    std::printf("sizeof(Tile) %zu, AoS chunk %zu bytes, Chunk %zu bytes on average (%.1f%%)\n",
+                sizeof(Tile), sizeof(AosChunk), chunkBytes / chunkCount,
+                100.0 * chunkBytes / (double(sizeof(AosChunk)) * chunkCount));
+    std::printf("resident for %d chunks: AoS %.2f MB, Chunk %.2f MB\n\n", chunkCount,
+                chunkCount * sizeof(AosChunk) / 1048576.0, chunkBytes / 1048576.0);
+
+    volatile int64_t sink = 0;
+
+    // Renderer::uploadChunk style: read the type of every tile
+    const double aosType = timeMs(reps, [&] {
+        int64_t n = 0;
+        for (const auto& c : aos)
+            for (int y = 0; y < CHUNK_SIZE; y++)
+                for (int x = 0; x < CHUNK_SIZE; x++)
+                    n += static_cast<int>(c->tiles[y][x].type);
+        sink = sink + n;
+    });
+    const double soaType = timeMs(reps, [&] {
+        int64_t n = 0;
+        TileType types[CHUNK_AREA];
+        for (const auto& c : soa) {
+            c->unpackTypes(types);
+            for (TileType t : types)
+                n += static_cast<int>(t);
+        }
+        sink = sink + n;
+    });
+    report("type scan", aosType, soaType);
+
+    // Flag query: how many resource tiles are loaded
+    const double aosFlag = timeMs(reps, [&] {
+        int64_t n = 0;
+        for (const auto& c : aos)
+            for (int y = 0; y < CHUNK_SIZE; y++)
+                for (int x = 0; x < CHUNK_SIZE; x++)
+                    n += c->tiles[y][x].hasResource();
+        sink = sink + n;
+    });
+    const double soaFlag = timeMs(reps, [&] {
+        int64_t n = 0;
+        for (const auto& c : soa)
+            n += c->countFlag(TILE_RESOURCE);
+        sink = sink + n;
+    });
+    report("flag query", aosFlag, soaFlag);
+
+    // Full tile reads through getTile
+    const double aosFull = timeMs(reps, [&] {
+        double e = 0.0;
+        for (const auto& c : aos)
+            for (int y = 0; y < CHUNK_SIZE; y++)
+                for (int x = 0; x < CHUNK_SIZE; x++)
+                    e += c->tiles[y][x].elevation + c->tiles[y][x].resource;
+        sink = sink + static_cast<int64_t>(e);
+    });
+    const double soaFull = timeMs(reps, [&] {
+        double e = 0.0;
+        for (const auto& c : soa)
+            for (int y = 0; y < CHUNK_SIZE; y++)
+                for (int x = 0; x < CHUNK_SIZE; x++) {
+                    const Tile t = c->getTile(x, y);
+                    e += t.elevation + t.resource;
+                }
+        sink = sink + static_cast<int64_t>(e);
+    });
+    report("full tile read", aosFull, soaFull);
+
+    return 0;
+}
@@ -0,0 +1,52 @@
+// Resident chunk memory on a standard seed: compact storage (single value
+// / palette / full, as produced by the generator) against every chunk in
+// Full storage and against the old 8 KB array-of-structs chunk.
+
+#include "game/world/worldgen.h"
+
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+int main(int argc, char* argv[]) {
+    const int32_t seed   = argc > 1 ? std::atoi(argv[1]) : 1337;
+    const int     radius = argc > 2 ? std::atoi(argv[2]) : 16;
+    const int     side   = radius * 2 + 1;
+    const int     count  = side * side;
+
+    // Old layout: Tile tiles[32][32] (8 bytes per tile) + header
+    constexpr size_t AOS_CHUNK_BYTES = sizeof(ChunkPos) + sizeof(Tile) * CHUNK_AREA + 4;
+
+    WorldGen worldGen(seed);
+
+    std::vector<std::unique_ptr<Chunk>> chunks(count);
+    std::vector<Chunk*>                 targets(count);
+    for (int i = 0; i < count; i++) {
+        chunks[i]  = std::make_unique<Chunk>();
+        targets[i] = chunks[i].get();
+    }
+    worldGen.generateRegion(ChunkPos(-radius, -radius), side, side, targets);
+
+    size_t compactBytes = 0;
+    int    modes[3]     = {};
+    int    bitsHist[9]  = {};
+    for (const auto& c : chunks) {
+        compactBytes += c->memoryUsage();
+        modes[static_cast<int>(c->storageMode())]++;
+        bitsHist[c->indexBits()]++;
+    }
+
+    size_t fullBytes = 0;
+    for (const auto& c : chunks) {
+        c->makeFull();
+        fullBytes += c->memoryUsage();
+    }
+
+    std::printf("seed %d, %d chunks (%dx%d around origin)\n", seed, count, side, side);
+    std::printf("storage   : single %d, palette %d (1-bit %d, 2-bit %d, 4-bit %d, 8-bit %d), full %d\n",
+                modes[0], modes[1], bitsHist[1], bitsHist[2], bitsHist[4], bitsHist[8], modes[2]);
+    std::printf("AoS       : %8.2f MB (%zu bytes/chunk)\n", count * AOS_CHUNK_BYTES / 1048576.0, AOS_CHUNK_BYTES);
+    std::printf("full      : %8.2f MB (%zu bytes/chunk)\n", fullBytes / 1048576.0, fullBytes / count);
+    std::printf("compact   : %8.2f MB (%zu bytes/chunk)\n", compactBytes / 1048576.0, compactBytes / count);
+    return 0;
+}
@@ -0,0 +1,257 @@
+// Headless factory throughput. Runs Simulation (chunk streaming + every
+// ECS system) without a window on synthetic factories built from a
+// scenario file, at each entity count the scenario lists. A factory is a
+// grid of identical cells: a belt chain fed with the recipe's first input
+// every few ticks, ending in a smelter, optionally powered by a pole and a
+// generator of its own. Ticks run back to back, unthrottled. Reports
+// ticks/sec, per-system timings and peak RSS (process wide, so it grows
+// with the largest factory so far).
+//
+// usage: FactoryBench [--scenario FILE] [--entities N] [--ticks N] [--serial] [--workers N]
+
+#include "game/simulation.h"
+
+#include "nlohmann/json.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+    #ifndef WIN32_LEAN_AND_MEAN
+        #define WIN32_LEAN_AND_MEAN
+    #endif
+    #ifndef NOMINMAX
+        #define NOMINMAX
+    #endif
+    #include <windows.h>
+    #include <psapi.h>
+#else
+    #include <sys/resource.h>
+#endif
+
+// =====================
+// HELPERS
+// =====================
+
+static double elapsedMs(std::chrono::steady_clock::time_point t0) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+static size_t peakRssBytes() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS pmc{};
+    GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc));
+    return pmc.PeakWorkingSetSize;
+#elif defined(__APPLE__)
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return static_cast<size_t>(usage.ru_maxrss);           // bytes on macOS
+#else
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return static_cast<size_t>(usage.ru_maxrss) * 1024;    // KiB on Linux
+#endif
+}
+
+// =====================
+// SCENARIO
+// =====================
+
+struct Scenario {
+    std::string name        = "unnamed";
+    std::string recipe      = "smelt_iron";
+    int         warmupTicks = 1200;   // first items reach the smelters after beltLength / beltSpeed seconds
+    int         ticks       = 600;
+
+    // One cell of the factory
+    int   beltLength   = 16;
+    float beltSpeed    = 1.0f;
+    int   feedInterval = 30;      // ticks between two items put on the first belt
+    bool  powered      = true;
+    float demandKW     = 90.0f;
+    float generatorKW  = 100.0f;
+
+    std::vector<int> entities = { 1000 };
+
+    int entitiesPerCell() const { return beltLength + 1 + (powered ? 2 : 0); }
+};
+
+static bool loadScenario(const std::string& path, Scenario& out) {
+    std::ifstream file(path);
+    if (!file.is_open()) return false;
+
+    try {
+        const auto root = nlohmann::json::parse(file);
+        out.name        = root.value("name", out.name);
+        out.recipe      = root.value("recipe", out.recipe);
+        out.warmupTicks = root.value("warmupTicks", out.warmupTicks);
+        out.ticks       = root.value("ticks", out.ticks);
+
+        const auto cell  = root.value("cell", nlohmann::json::object());
+        out.beltLength   = cell.value("beltLength", out.beltLength);
+        out.beltSpeed    = cell.value("beltSpeed", out.beltSpeed);
+        out.feedInterval = cell.value("feedInterval", out.feedInterval);
+        out.powered      = cell.value("powered", out.powered);
+        out.demandKW     = cell.value("demandKW", out.demandKW);
+        out.generatorKW  = cell.value("generatorKW", out.generatorKW);
+
+        if (root.contains("entities"))
+            out.entities = root.at("entities").get<std::vector<int>>();
+    } catch (const std::exception& e) {
+        std::fprintf(stderr, "%s: %s\n", path.c_str(), e.what());
+        return false;
+    }
+    return out.beltLength > 0 && out.feedInterval > 0 && out.ticks > 0 && !out.entities.empty();
+}
+
+// =====================
+// FACTORY
+// =====================
+
+struct Factory {
+    int                       cells = 0;
+    float                     centerX = 0.0f, centerY = 0.0f;
+    std::vector<entt::entity> feeds;      // first belt of each cell
+    std::vector<entt::entity> smelters;
+};
+
+// Cells in a roughly square grid. Poles of a column are wired together,
+// columns are too far apart to connect
+static Factory buildFactory(ECSWorld& world, const Scenario& scenario, int entities) {
+    Factory factory;
+    factory.cells = std::max(1, entities / scenario.entitiesPerCell());
+
+    const int cellW = scenario.beltLength + 3;   // belts, smelter, generator, gap
+    const int cellH = 3;                         // belt row, power row, gap
+    const int cols  = std::max(1, static_cast<int>(std::ceil(std::sqrt(double(factory.cells) * cellH / cellW))));
+    const int rows  = (factory.cells + cols - 1) / cols;
+    factory.centerX = cols * cellW * 0.5f;
+    factory.centerY = rows * cellH * 0.5f;
+
+    factory.feeds.reserve(factory.cells);
+    factory.smelters.reserve(factory.cells);
+
+    for (int i = 0; i < factory.cells; i++) {
+        const float x0 = static_cast<float>((i % cols) * cellW);
+        const float y0 = static_cast<float>((i / cols) * cellH);
+
+        for (int x = 0; x < scenario.beltLength; x++) {
+            const auto belt = world.createBelt(x0 + x, y0, Direction::East, scenario.beltSpeed);
+            if (x == 0) factory.feeds.push_back(belt);
+        }
+
+        const float sx      = x0 + scenario.beltLength;
+        const auto  smelter = world.createBuilding("models/smelter.gltf", sx, y0, scenario.recipe);
+        factory.smelters.push_back(smelter);
+
+        if (scenario.powered) {
+            (void)world.createPole(sx, y0 + 1);
+            const auto generator = world.createBuilding("models/generator.gltf", sx + 1, y0 + 1);
+            world.addPowerProducer(generator, scenario.generatorKW);
+            world.addPowerConsumer(smelter, scenario.demandKW);
+        }
+    }
+    return factory;
+}
+
+// =====================
+// MAIN
+// =====================
+
+int main(int argc, char* argv[]) {
+    std::string scenarioPath = "bench/scenarios/smelter_chains.json";
+    int         entities     = 0;     // 0: the scenario's list
+    int         ticks        = 0;     // 0: the scenario's count
+    int         workers      = 0;
+    bool        serial       = false;
+
+    for (int i = 1; i < argc; i++) {
+        const bool hasValue = i + 1 < argc;
+        if (!std::strcmp(argv[i], "--scenario") && hasValue)      scenarioPath = argv[++i];
+        else if (!std::strcmp(argv[i], "--entities") && hasValue) entities     = std::atoi(argv[++i]);
+        else if (!std::strcmp(argv[i], "--ticks") && hasValue)    ticks        = std::atoi(argv[++i]);
+        else if (!std::strcmp(argv[i], "--workers") && hasValue)  workers      = std::atoi(argv[++i]);
+        else if (!std::strcmp(argv[i], "--serial"))               serial       = true;
+        else {
+            std::fprintf(stderr, "usage: FactoryBench [--scenario FILE] [--entities N] [--ticks N] [--serial]"
+                                 " [--workers N]\n");
+            return 2;
+        }
+    }
+
+    Scenario scenario;
+    if (!loadScenario(scenarioPath, scenario)) {
+        std::fprintf(stderr, "cannot load scenario %s\n", scenarioPath.c_str());
+        return 1;
+    }
+    if (entities > 0) scenario.entities = { entities };
+    if (ticks > 0) scenario.ticks = ticks;
+
+    // Recipes are read from assets/ under the working directory
+    FileManager::SetBasePath(std::filesystem::current_path().string());
+
+    std::printf("scenario  : %s, %d ticks after %d warmup, %s systems\n", scenario.name.c_str(), scenario.ticks,
+                scenario.warmupTicks, serial ? "serial" : "parallel");
+
+    for (int target : scenario.entities) {
+        Simulation simulation{ ChunkManagerConfig{} };   // no persistence
+        simulation.init();
+
+        ECSWorld&      world  = simulation.getWorld();
+        const RecipeId recipe = RecipeDB::find(scenario.recipe);
+        if (recipe == INVALID_RECIPE || RecipeDB::get(recipe).inputs.empty()) {
+            std::fprintf(stderr, "recipe %s not found or without inputs\n", scenario.recipe.c_str());
+            return 1;
+        }
+        world.scheduler().setDeterministic(serial);
+        world.scheduler().setWorkerCount(workers);
+
+        const auto    tb      = std::chrono::steady_clock::now();
+        const Factory factory = buildFactory(world, scenario, target);
+        const double  buildMs = elapsedMs(tb);
+
+        // Sources: one item on the first belt of every cell each feedInterval ticks
+        const ItemId input    = RecipeDB::get(recipe).inputs.front().item;
+        uint64_t     feedTick = 0;
+        world.addSystem("feed", SystemAccess{}.write<CBelt>(), [&](ECSWorld& w, float) {
+            if (feedTick++ % scenario.feedInterval != 0) return;
+            for (const entt::entity belt : factory.feeds)
+                (void)w.insertOnBelt(belt, input);
+        });
+
+        simulation.handle({ InputEvent::Type::Focus, factory.centerX, factory.centerY });
+        for (int t = 0; t < scenario.warmupTicks; t++)
+            simulation.tick();
+
+        const auto   t0 = std::chrono::steady_clock::now();
+        for (int t = 0; t < scenario.ticks; t++)
+            simulation.tick();
+        const double ms = elapsedMs(t0);
+
+        size_t produced = 0;
+        if (!RecipeDB::get(recipe).outputs.empty()) {
+            const ItemId output = RecipeDB::get(recipe).outputs.front().item;
+            for (const entt::entity smelter : factory.smelters)
+                produced += world.get<CInventory>(smelter).count(output);
+        }
+
+        const int made = factory.cells * scenario.entitiesPerCell();
+        std::printf("\nentities  : %d (%d cells), built in %.1f ms\n", made, factory.cells, buildMs);
+        std::printf("throughput: %.1f ticks/s, %.3f ms/tick (%.1fx real time)\n", scenario.ticks * 1000.0 / ms,
+                    ms / scenario.ticks, scenario.ticks * 1000.0 / ms / ECSWorld::TICKS_PER_SECOND);
+        std::printf("state     : %zu belt items, %zu produced, %zu power networks\n",
+                    world.transportLines().itemCount(), produced, world.powerGrid().networkCount());
+        std::printf("peak rss  : %.1f MB\n", peakRssBytes() / (1024.0 * 1024.0));
+        world.scheduler().printTimings(std::cout);
+    }
+    return 0;
+}
@@ -0,0 +1,76 @@
+// Compares the two chunk load paths: regenerating from noise versus
+// reading a persisted chunk back from a region file.
+
+#include "game/world/worldgen.h"
+#include "game/world/regionfile.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <vector>
+
+static double elapsedMs(std::chrono::steady_clock::time_point t0) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+static bool samePlanes(const Chunk& a, const Chunk& b) {
+    for (int i = 0; i < CHUNK_AREA; i++)
+        if (!(a.getCell(i) == b.getCell(i))) return false;
+    return std::memcmp(a.elevations().data(), b.elevations().data(), CHUNK_AREA * sizeof(int16_t)) == 0;
+}
+
+int main(int argc, char* argv[]) {
+    const int         grid = argc > 1 ? std::atoi(argv[1]) : RegionStore::REGION_SIZE;
+    const std::string dir  = argc > 2 ? argv[2] : "region_bench_tmp";
+    const int         count = grid * grid;
+
+    std::filesystem::remove_all(dir);
+
+    WorldGen worldGen(1337);
+    std::vector<std::unique_ptr<Chunk>> generated(count);
+
+    // --- Path 1: generate from noise (single-chunk path, as for a lone missing chunk) ---
+    auto t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < count; i++) {
+        generated[i] = std::make_unique<Chunk>(ChunkPos(i % grid, i / grid));
+        worldGen.generateChunk(*generated[i]);
+    }
+    const double genMs = elapsedMs(t0);
+
+    // --- Persist ---
+    size_t diskBytes = 0;
+    {
+        RegionStore store(dir);
+        t0 = std::chrono::steady_clock::now();
+        for (const auto& chunk : generated)
+            store.save(*chunk);
+        const double saveMs = elapsedMs(t0);
+        std::printf("save      : %8.2f ms  (%6.2f us/chunk)\n", saveMs, saveMs * 1000.0 / count);
+    }
+    for (const auto& entry : std::filesystem::directory_iterator(dir))
+        diskBytes += entry.file_size();
+
+    // --- Path 2: load from region files (fresh store, cold mappings) ---
+    Chunk loaded;
+    int   mismatches = 0;
+    RegionStore store(dir);
+    t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < count; i++) {
+        if (!store.load(generated[i]->pos, loaded) || !samePlanes(loaded, *generated[i]))
+            mismatches++;
+    }
+    const double loadMs = elapsedMs(t0);
+
+    std::printf("chunks    : %d (%dx%d)\n", count, grid, grid);
+    std::printf("generate  : %8.2f ms  (%6.2f us/chunk)\n", genMs, genMs * 1000.0 / count);
+    std::printf("load      : %8.2f ms  (%6.2f us/chunk)  x%.1f faster\n", loadMs, loadMs * 1000.0 / count,
+                genMs / loadMs);
+    std::printf("on disk   : %zu bytes (%.0f bytes/chunk, full planes %zu)\n", diskBytes,
+                double(diskBytes) / count, sizeof(int8_t) * CHUNK_AREA * 3 + sizeof(int16_t) * CHUNK_AREA);
+    std::printf("mismatch  : %d\n", mismatches);
+
+    std::filesystem::remove_all(dir);
+    return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,286 @@
+// World snapshot save / load. Builds a factory of the requested size (belt
+// chains into powered smelters, as FactoryBench's default scenario), runs
+// it until items and crafts are in flight, then times a save into memory
+// and ECSWorld::load into a fresh world. The save is timed in its two
+// halves, capture and write, and the RLE packing of snapshot files too.
+// The pause of a background save (Simulation::saveAsync) is the capture,
+// or with --fork (SaveMethod::Fork, POSIX) the fork. The loaded world is
+// checked against the original (per-component digests, belt items, power
+// networks), then both run on in lockstep and are checked again. Exits
+// non-zero if a check fails, save / load takes longer than the target, or
+// the pause is longer than a tick.
+//
+// usage: SnapshotBench [--entities N] [--ticks N] [--target-ms MS] [--pause-ms MS] [--fork]
+
+#include "game/ECS/snapshot.h"
+#include "utils/compression.h"
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+    #include <sys/wait.h>
+    #include <unistd.h>
+#endif
+
+// =====================
+// HELPERS
+// =====================
+
+static double elapsedMs(std::chrono::steady_clock::time_point t0) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+static uint64_t mix(uint64_t h, uint64_t v) {
+    // splitmix64 finalizer over the running value
+    uint64_t z = h ^ (v + 0x9E3779B97F4A7C15ull + (h << 6) + (h >> 2));
+    z          = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z          = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+static uint64_t bits(float f) {
+    return std::bit_cast<uint32_t>(f);
+}
+
+// =====================
+// FACTORY
+// =====================
+
+struct Factory {
+    std::vector<entt::entity> feeds;   // first belt of each cell
+    ItemId                    input = INVALID_ITEM;
+};
+
+// Cells of 16 belts, a smelter, a pole and a generator in a roughly square grid
+static Factory buildFactory(ECSWorld& world, int entities) {
+    constexpr int BELTS = 16;
+    constexpr int CELL  = BELTS + 3;
+    const int     cells = std::max(1, entities / CELL);
+    const int     cols  = std::max(1, static_cast<int>(std::ceil(std::sqrt(double(cells) * 3 / CELL))));
+
+    Factory factory;
+    factory.input = RecipeDB::get(RecipeDB::find("smelt_iron")).inputs.front().item;
+    factory.feeds.reserve(cells);
+
+    for (int i = 0; i < cells; i++) {
+        const float x0 = static_cast<float>((i % cols) * CELL);
+        const float y0 = static_cast<float>((i / cols) * 3);
+
+        for (int x = 0; x < BELTS; x++) {
+            const auto belt = world.createBelt(x0 + x, y0, Direction::East);
+            if (x == 0) factory.feeds.push_back(belt);
+        }
+        const auto smelter = world.createBuilding("models/smelter.gltf", x0 + BELTS, y0, "smelt_iron");
+        world.raw().emplace<TPlayerOwned>(smelter);
+        (void)world.createPole(x0 + BELTS, y0 + 1);
+        const auto generator = world.createBuilding("models/generator.gltf", x0 + BELTS + 1, y0 + 1);
+        world.addPowerProducer(generator, 100.0f);
+        world.addPowerConsumer(smelter, 90.0f);
+    }
+    return factory;
+}
+
+// Same order as Simulation::init, plus the feed
+static void tick(ECSWorld& world, const Factory& factory) {
+    constexpr float DT = 1.0f / ECSWorld::TICKS_PER_SECOND;
+    if (world.tick() % 30 == 0)
+        for (const entt::entity belt : factory.feeds)
+            (void)world.insertOnBelt(belt, factory.input);
+    world.updatePower();
+    world.updateCrafters(DT);
+    world.updateBelts(DT);
+}
+
+// =====================
+// VERIFICATION
+// =====================
+
+// Order independent: entities may come back in another storage order
+struct Digest {
+    size_t   entities = 0, belts = 0, crafters = 0, inventories = 0, owned = 0;
+    size_t   lines = 0, items = 0, poles = 0, networks = 0;
+    uint64_t tick  = 0;
+    uint64_t hash  = 0;
+
+    bool operator==(const Digest&) const = default;
+};
+
+static Digest digest(const ECSWorld& world) {
+    const entt::registry& reg = world.raw();
+    Digest                d;
+    d.tick = world.tick();
+
+    auto add = [&](entt::entity e, uint64_t tag, uint64_t value) {
+        d.hash += mix(mix(tag, entt::to_integral(e)), value);
+    };
+
+    for (auto [e, pos] : reg.view<const CPosition>().each()) {
+        d.entities++;
+        add(e, 1, bits(pos.x) << 32 | bits(pos.y));
+    }
+    for (auto [e, belt] : reg.view<const CBelt>().each()) {
+        d.belts++;
+        add(e, 2, uint64_t(belt.direction) << 40 | uint64_t(belt.line) << 8 | (bits(belt.speed) & 0xFF));
+    }
+    for (auto [e, crafter] : reg.view<const CCrafter>().each()) {
+        d.crafters++;
+        add(e, 3, mix(mix(crafter.startTick, crafter.finishTick), uint64_t(crafter.state) << 32 | bits(crafter.speed)));
+    }
+    for (auto [e, inv] : reg.view<const CInventory>().each()) {
+        d.inventories++;
+        uint64_t h = inv.maxSlots;
+        for (const ItemStack& stack : inv.slots()) h = mix(h, uint64_t(stack.item) << 32 | uint32_t(stack.count));
+        add(e, 4, h);
+    }
+    for (auto [e, consumer] : reg.view<const CPowerConsumer>().each())
+        add(e, 5, bits(consumer.satisfaction) << 32 | bits(consumer.demandKW));
+    for (const entt::entity e : reg.view<const TPlayerOwned>()) {
+        d.owned++;
+        add(e, 6, 1);
+    }
+
+    world.transportLines().forEachItem([&](ItemId item, float x, float y) {
+        d.hash += mix(mix(7, item), bits(x) << 32 | bits(y));
+    });
+    d.lines    = world.transportLines().lineCount();
+    d.items    = world.transportLines().itemCount();
+    d.poles    = world.powerGrid().poleCount();
+    d.networks = world.powerGrid().networkCount();
+    return d;
+}
+
+static bool check(const char* what, const Digest& a, const Digest& b) {
+    const bool same = a == b;
+    std::printf("%-10s: %s (%zu entities, %zu belt items, %zu networks, tick %llu)\n", what,
+                same ? "match" : "MISMATCH", b.entities, b.items, b.networks, static_cast<unsigned long long>(b.tick));
+    if (!same) {
+        std::printf("            original entities %zu belts %zu crafters %zu inventories %zu lines %zu items %zu"
+                    " poles %zu networks %zu\n", a.entities, a.belts, a.crafters, a.inventories, a.lines, a.items,
+                    a.poles, a.networks);
+        std::printf("            loaded   entities %zu belts %zu crafters %zu inventories %zu lines %zu items %zu"
+                    " poles %zu networks %zu\n", b.entities, b.belts, b.crafters, b.inventories, b.lines, b.items,
+                    b.poles, b.networks);
+    }
+    return same;
+}
+
+// =====================
+// MAIN
+// =====================
+
+int main(int argc, char* argv[]) {
+    int    entities = 1000000;
+    int    ticks    = 1200;    // first items reach the smelters after 16 s
+    double targetMs = 1000.0;
+    double pauseTargetMs = 1000.0 / ECSWorld::TICKS_PER_SECOND;
+    bool   forkSave      = false;
+
+    for (int i = 1; i < argc; i++) {
+        const bool hasValue = i + 1 < argc;
+        if (!std::strcmp(argv[i], "--entities") && hasValue)       entities = std::atoi(argv[++i]);
+        else if (!std::strcmp(argv[i], "--ticks") && hasValue)     ticks    = std::atoi(argv[++i]);
+        else if (!std::strcmp(argv[i], "--target-ms") && hasValue) targetMs = std::atof(argv[++i]);
+        else if (!std::strcmp(argv[i], "--pause-ms") && hasValue)  pauseTargetMs = std::atof(argv[++i]);
+        else if (!std::strcmp(argv[i], "--fork"))                  forkSave = true;
+        else {
+            std::fprintf(stderr, "usage: SnapshotBench [--entities N] [--ticks N] [--target-ms MS] [--pause-ms MS]"
+                                 " [--fork]\n");
+            return 2;
+        }
+    }
+
+    // Recipes are read from assets/ under the working directory
+    FileManager::SetBasePath(std::filesystem::current_path().string());
+    if (RecipeDB::loadFromJSON("data/recipes.json") == 0 || RecipeDB::find("smelt_iron") == INVALID_RECIPE) {
+        std::fprintf(stderr, "recipe smelt_iron not found\n");
+        return 1;
+    }
+
+    ECSWorld original;
+    const auto    tb      = std::chrono::steady_clock::now();
+    const Factory factory = buildFactory(original, entities);
+    const double  buildMs = elapsedMs(tb);
+    for (int t = 0; t < ticks; t++)
+        tick(original, factory);
+
+    WorldCapture capture;
+    const auto   tc        = std::chrono::steady_clock::now();
+    original.capture(capture);
+    const double captureMs = elapsedMs(tc);
+
+    std::vector<uint8_t> bytes;
+    const auto           tw      = std::chrono::steady_clock::now();
+    capture.write(bytes);
+    const double         writeMs = elapsedMs(tw);
+    const double         saveMs  = captureMs + writeMs;
+
+    std::vector<uint8_t> packed;
+    const auto           tp     = std::chrono::steady_clock::now();
+    Compression::packRLE(bytes, packed);
+    const double         packMs = elapsedMs(tp);
+
+    // Background save: the child captures, writes and packs its copy-on-write view
+    double      pauseMs = captureMs, backgroundMs = captureMs + writeMs + packMs;
+    const char* pauseBy = "capture";
+#ifndef _WIN32
+    const auto  tf  = std::chrono::steady_clock::now();
+    const pid_t pid = forkSave ? fork() : -1;
+    if (pid == 0) {
+        WorldCapture         child;
+        std::vector<uint8_t> childBytes, childPacked;
+        original.capture(child);
+        child.write(childBytes);
+        Compression::packRLE(childBytes, childPacked);
+        _exit(childPacked.size() == packed.size() ? 0 : 1);
+    }
+    if (pid > 0) {
+        pauseMs = elapsedMs(tf);
+        pauseBy = "fork";
+        int status = 0;
+        if (waitpid(pid, &status, 0) != pid || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+            std::printf("background save failed\n");
+        backgroundMs = elapsedMs(tf);
+    }
+#endif
+
+    ECSWorld     loaded;
+    const auto   tl     = std::chrono::steady_clock::now();
+    const bool   ok     = loaded.load(bytes);
+    const double loadMs = elapsedMs(tl);
+
+    const Digest before = digest(original);
+    std::printf("entities  : %zu, built in %.1f ms, %d ticks run\n", before.entities, buildMs, ticks);
+    std::printf("snapshot  : %.1f MB (%.1f bytes/entity)\n", bytes.size() / (1024.0 * 1024.0),
+                double(bytes.size()) / std::max<size_t>(before.entities, 1));
+    std::printf("save      : %.1f ms (%.0f MB/s): capture %.1f ms, write %.1f ms\n", saveMs,
+                bytes.size() / (1024.0 * 1024.0) / (saveMs / 1000.0), captureMs, writeMs);
+    std::printf("pack      : %.1f ms, %.1f MB (%.0f%%)\n", packMs, packed.size() / (1024.0 * 1024.0),
+                100.0 * packed.size() / std::max<size_t>(bytes.size(), 1));
+    std::printf("pause     : %.2f ms (%s), background save done after %.1f ms\n", pauseMs, pauseBy, backgroundMs);
+    std::printf("load      : %.1f ms (%.0f MB/s)\n", loadMs, bytes.size() / (1024.0 * 1024.0) / (loadMs / 1000.0));
+
+    bool pass = ok && check("loaded", before, digest(loaded));
+
+    // Same future from the loaded state
+    for (int t = 0; t < ECSWorld::TICKS_PER_SECOND * 5; t++) {
+        tick(original, factory);
+        tick(loaded, factory);
+    }
+    pass = check("+5 s", digest(original), digest(loaded)) && pass;
+
+    const bool fast  = saveMs <= targetMs && loadMs <= targetMs;
+    const bool brief = pauseMs <= pauseTargetMs;
+    std::printf("result    : %s, %s the %.0f ms target, pause %s the %.1f ms target\n",
+                pass ? "round trip ok" : "ROUND TRIP FAILED", fast ? "within" : "OVER", targetMs,
+                brief ? "within" : "OVER", pauseTargetMs);
+    return pass && fast && brief ? 0 : 1;
+}
@@ -0,0 +1,261 @@
+// World generation throughput and determinism harness. Generates a grid of
+// chunks for a list of seeds through one of the generation paths, reports
+// chunks/sec, ns/tile and peak memory, and checks a hash of every chunk
+// against stored goldens so optimisations can be proven output-identical.
+// A missing goldens file or a chunk without a golden fails the run: other
+// seeds or grids need their own file (--goldens FILE --write-goldens).
+//
+// usage: WorldGenBench [--grid N] [--seeds a,b,c] [--mode single|region|pool]
+//                      [--goldens FILE] [--write-goldens]
+
+#include "game/world/worldgen.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#ifdef _WIN32
+    #ifndef WIN32_LEAN_AND_MEAN
+        #define WIN32_LEAN_AND_MEAN
+    #endif
+    #ifndef NOMINMAX
+        #define NOMINMAX
+    #endif
+    #include <windows.h>
+    #include <psapi.h>
+#else
+    #include <sys/resource.h>
+#endif
+
+// Set by CMake to the file in the source tree, so the check does not
+// depend on the working directory
+#ifndef WORLDGEN_GOLDENS
+    #define WORLDGEN_GOLDENS "bench/worldgen_goldens.txt"
+#endif
+
+// =====================
+// HELPERS
+// =====================
+
+static double elapsedMs(std::chrono::steady_clock::time_point t0) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+static size_t peakRssBytes() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS pmc{};
+    GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc));
+    return pmc.PeakWorkingSetSize;
+#elif defined(__APPLE__)
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return static_cast<size_t>(usage.ru_maxrss);           // bytes on macOS
+#else
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return static_cast<size_t>(usage.ru_maxrss) * 1024;    // KiB on Linux
+#endif
+}
+
+// FNV-1a over the decoded tiles (type, flags, resource, quantized
+// elevation) in row-major order, independent of the storage mode
+static uint64_t hashChunk(const Chunk& chunk) {
+    uint64_t h = 0xcbf29ce484222325ull;
+    auto mix = [&](uint8_t b) {
+        h ^= b;
+        h *= 0x100000001b3ull;
+    };
+
+    const auto elevations = chunk.elevations();
+    for (int i = 0; i < CHUNK_AREA; i++) {
+        const TileCell c = chunk.getCell(i);
+        mix(static_cast<uint8_t>(c.type));
+        mix(static_cast<uint8_t>(c.flags));
+        mix(static_cast<uint8_t>(c.resource));
+        mix(static_cast<uint8_t>(elevations[i] & 0xFF));
+        mix(static_cast<uint8_t>(static_cast<uint16_t>(elevations[i]) >> 8));
+    }
+    return h;
+}
+
+// (seed, x, y) -> hash
+using HashKey = std::tuple<int32_t, int32_t, int32_t>;
+using Hashes  = std::map<HashKey, uint64_t>;
+
+static bool readGoldens(const std::string& path, Hashes& out) {
+    std::ifstream file(path);
+    if (!file.is_open()) return false;
+
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        std::istringstream in(line);
+        int32_t            seed, x, y;
+        std::string        hex;
+        if (in >> seed >> x >> y >> hex)
+            out[{ seed, x, y }] = std::strtoull(hex.c_str(), nullptr, 16);
+    }
+    return true;
+}
+
+static bool writeGoldens(const std::string& path, const Hashes& hashes) {
+    std::ofstream file(path);
+    if (!file.is_open()) return false;
+
+    file << "# WorldGenBench goldens: seed chunkX chunkY fnv1a64(tiles)\n";
+    char hex[17];
+    for (const auto& [key, hash] : hashes) {
+        std::snprintf(hex, sizeof(hex), "%016llx", static_cast<unsigned long long>(hash));
+        file << std::get<0>(key) << ' ' << std::get<1>(key) << ' ' << std::get<2>(key) << ' ' << hex << '\n';
+    }
+    return static_cast<bool>(file);
+}
+
+static std::vector<int32_t> parseSeeds(const char* list) {
+    std::vector<int32_t> seeds;
+    std::stringstream    in(list);
+    std::string          item;
+    while (std::getline(in, item, ','))
+        if (!item.empty()) seeds.push_back(std::atoi(item.c_str()));
+    return seeds;
+}
+
+// =====================
+// GENERATION PATHS
+// =====================
+
+// One generateChunk call per chunk
+static void runSingle(const WorldGen& worldGen, int grid, std::vector<std::unique_ptr<Chunk>>& chunks) {
+    for (int i = 0; i < grid * grid; i++) {
+        chunks[i] = std::make_unique<Chunk>(ChunkPos(i % grid - grid / 2, i / grid - grid / 2));
+        worldGen.generateChunk(*chunks[i]);
+    }
+}
+
+// The whole grid in one batched generateRegion call
+static void runRegion(const WorldGen& worldGen, int grid, std::vector<std::unique_ptr<Chunk>>& chunks) {
+    std::vector<Chunk*> targets(chunks.size());
+    for (size_t i = 0; i < chunks.size(); i++) {
+        chunks[i]  = std::make_unique<Chunk>();
+        targets[i] = chunks[i].get();
+    }
+    worldGen.generateRegion(ChunkPos(-grid / 2, -grid / 2), grid, grid, targets);
+}
+
+// Single-chunk requests through the worker pool, as the game streams them
+static void runPool(const WorldGen& worldGen, int grid, std::vector<std::unique_ptr<Chunk>>& chunks) {
+    ChunkGenService service(worldGen, 0);
+    for (int i = 0; i < grid * grid; i++)
+        service.request(ChunkPos(i % grid - grid / 2, i / grid - grid / 2));
+
+    std::vector<std::unique_ptr<Chunk>> done;
+    while (done.size() < chunks.size()) {
+        if (service.poll(done) == 0)
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+    for (auto& chunk : done) {
+        const int i = (chunk->pos.y + grid / 2) * grid + (chunk->pos.x + grid / 2);
+        chunks[i]   = std::move(chunk);
+    }
+}
+
+// =====================
+// MAIN
+// =====================
+
+int main(int argc, char* argv[]) {
+    int                  grid    = 16;
+    std::vector<int32_t> seeds   = { 1337, 42, -7 };
+    std::string          mode    = "region";
+    std::string          goldens = WORLDGEN_GOLDENS;
+    bool                 write   = false;
+
+    for (int i = 1; i < argc; i++) {
+        const bool hasValue = i + 1 < argc;
+        if (!std::strcmp(argv[i], "--grid") && hasValue)         grid    = std::atoi(argv[++i]);
+        else if (!std::strcmp(argv[i], "--seeds") && hasValue)   seeds   = parseSeeds(argv[++i]);
+        else if (!std::strcmp(argv[i], "--mode") && hasValue)    mode    = argv[++i];
+        else if (!std::strcmp(argv[i], "--goldens") && hasValue) goldens = argv[++i];
+        else if (!std::strcmp(argv[i], "--write-goldens"))       write   = true;
+        else {
+            std::fprintf(stderr, "unknown argument: %s\n", argv[i]);
+            return 2;
+        }
+    }
+
+    auto run = mode == "single" ? runSingle : mode == "pool" ? runPool : mode == "region" ? runRegion : nullptr;
+    if (!run || grid <= 0 || seeds.empty()) {
+        std::fprintf(stderr, "usage: WorldGenBench [--grid N] [--seeds a,b,c] [--mode single|region|pool]"
+                             " [--goldens FILE] [--write-goldens]\n");
+        return 2;
+    }
+
+    const int count = grid * grid;
+    Hashes    hashes;
+    double    totalMs = 0.0;
+
+    std::printf("mode      : %s, %dx%d chunks per seed\n", mode.c_str(), grid, grid);
+
+    for (int32_t seed : seeds) {
+        WorldGen                            worldGen(seed);
+        std::vector<std::unique_ptr<Chunk>> chunks(count);
+
+        const auto   t0 = std::chrono::steady_clock::now();
+        run(worldGen, grid, chunks);
+        const double ms = elapsedMs(t0);
+        totalMs += ms;
+
+        for (const auto& chunk : chunks)
+            hashes[{ seed, chunk->pos.x, chunk->pos.y }] = hashChunk(*chunk);
+
+        std::printf("seed %-6d: %8.2f ms  %8.0f chunks/s  %6.2f ns/tile\n", seed, ms, count * 1000.0 / ms,
+                    ms * 1e6 / (double(count) * CHUNK_AREA));
+    }
+
+    const double chunksTotal = double(count) * seeds.size();
+    std::printf("total     : %8.2f ms  %8.0f chunks/s  %6.2f ns/tile\n", totalMs, chunksTotal * 1000.0 / totalMs,
+                totalMs * 1e6 / (chunksTotal * CHUNK_AREA));
+    std::printf("peak rss  : %.1f MB\n", peakRssBytes() / (1024.0 * 1024.0));
+
+    // --- Goldens ---
+    if (write) {
+        if (!writeGoldens(goldens, hashes)) {
+            std::fprintf(stderr, "cannot write %s\n", goldens.c_str());
+            return 1;
+        }
+        std::printf("goldens   : wrote %zu hashes to %s\n", hashes.size(), goldens.c_str());
+        return 0;
+    }
+
+    Hashes expected;
+    if (!readGoldens(goldens, expected)) {
+        std::fprintf(stderr, "goldens   : %s not found, output unchecked (write it with --write-goldens)\n",
+                     goldens.c_str());
+        return 1;
+    }
+
+    int checked = 0, mismatches = 0, missing = 0;
+    for (const auto& [key, hash] : hashes) {
+        auto it = expected.find(key);
+        if (it == expected.end()) {
+            if (++missing <= 10)
+                std::printf("missing   : seed %d chunk (%d, %d)\n", std::get<0>(key), std::get<1>(key), std::get<2>(key));
+            continue;
+        }
+        checked++;
+        if (it->second != hash && ++mismatches <= 10)
+            std::printf("mismatch  : seed %d chunk (%d, %d)\n", std::get<0>(key), std::get<1>(key), std::get<2>(key));
+    }
+    std::printf("goldens   : %d checked, %d mismatched, %d not in %s\n", checked, mismatches, missing,
+                goldens.c_str());
+    return mismatches == 0 && missing == 0 ? 0 : 1;
+}
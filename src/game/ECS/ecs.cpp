@@ -1,69 +1,233 @@
 #include "ecs.h"
-#include "../../renderer/renderer.h"
 
 #include <algorithm>
-#include <iostream>
+#include <cmath>
 #include <ranges>
 
+// =====================================================================
+// ItemRegistry
+// =====================================================================
+
+std::vector<std::string>                                                        ItemRegistry::s_names;
+std::unordered_map<std::string, ItemId, ItemRegistry::NameHash, std::equal_to<>> ItemRegistry::s_ids;
+
+ItemId ItemRegistry::intern(std::string_view name) {
+    if (const ItemId id = find(name); id != INVALID_ITEM)
+        return id;
+
+    if (s_names.size() >= INVALID_ITEM) {
+        LOG_ERROR(ECS, "Too many item types, cannot add {}", name);
+        return INVALID_ITEM;
+    }
+    const auto id = static_cast<ItemId>(s_names.size());
+    s_names.emplace_back(name);
+    s_ids.emplace(s_names.back(), id);
+    return id;
+}
+
+ItemId ItemRegistry::find(std::string_view name) noexcept {
+    if (auto it = s_ids.find(name); it != s_ids.end())
+        return it->second;
+    return INVALID_ITEM;
+}
+
+const std::string& ItemRegistry::name(ItemId id) noexcept {
+    static const std::string unknown = "<unknown item>";
+    return id < s_names.size() ? s_names[id] : unknown;
+}
+
 // =====================================================================
 // RecipeDB
 // =====================================================================
 
-std::vector<Recipe>                     RecipeDB::s_recipes;
-std::unordered_map<std::string, size_t> RecipeDB::s_index;
+std::vector<Recipe>                                                          RecipeDB::s_recipes;
+std::vector<RecipeDB::Range>                                                 RecipeDB::s_ranges;
+std::vector<ItemStack>                                                       RecipeDB::s_stacks;
+std::vector<std::string>                                                     RecipeDB::s_names;
+std::unordered_map<std::string, RecipeId, RecipeDB::NameHash, std::equal_to<>> RecipeDB::s_ids;
+
+// Stacks of one side of a recipe entry, item names interned on the way
+static std::vector<ItemStack> parseStacks(const FileManager::json& list) {
+    std::vector<ItemStack> stacks;
+    stacks.reserve(list.size());
+    for (const auto& entry : list)
+        stacks.push_back({ ItemRegistry::intern(entry.at("item").get<std::string>()), entry.value("count", 1) });
+    return stacks;
+}
 
-void RecipeDB::registerRecipe(Recipe recipe) {
-    const auto id = recipe.id;
-    s_index[id]   = s_recipes.size();
-    s_recipes.push_back(std::move(recipe));
+size_t RecipeDB::loadFromJSON(const std::string& relativePath) {
+    std::vector<RecipeDef> defs;
+    try {
+        const auto root = FileManager::LoadJSONFile(relativePath);
+        for (const auto& entry : root.at("recipes")) {
+            RecipeDef def;
+            def.id       = entry.at("id").get<std::string>();
+            def.duration = entry.value("duration", 1.0f);
+            def.inputs   = parseStacks(entry.value("inputs", FileManager::json::array()));
+            def.outputs  = parseStacks(entry.value("outputs", FileManager::json::array()));
+            defs.push_back(std::move(def));
+        }
+    } catch (const std::exception& e) {
+        LOG_ERROR(ECS, "Failed to load recipes from {}: {}", relativePath, e.what());
+        return 0;
+    }
+
+    // Size the pool once so the whole file lands without reallocating
+    size_t stackCount = s_stacks.size();
+    for (const auto& def : defs)
+        stackCount += def.inputs.size() + def.outputs.size();
+    s_stacks.reserve(stackCount);
+    s_recipes.reserve(s_recipes.size() + defs.size());
+    s_ranges.reserve(s_ranges.size() + defs.size());
+
+    size_t loaded = 0;
+    for (const auto& def : defs)
+        loaded += registerRecipe(def) != INVALID_RECIPE;
+
+    LOG_INFO(ECS, "Loaded {} recipes from {}", loaded, relativePath);
+    return loaded;
 }
 
-const Recipe* RecipeDB::get(const std::string& id) noexcept {
-    if (auto it = s_index.find(id); it != s_index.end())
-        return &s_recipes[it->second];
-    return nullptr;
+RecipeId RecipeDB::registerRecipe(const RecipeDef& def) {
+    RecipeId id = find(def.id);
+    if (id == INVALID_RECIPE) {
+        if (s_names.size() >= INVALID_RECIPE) {
+            LOG_ERROR(ECS, "Too many recipes, cannot add {}", def.id);
+            return INVALID_RECIPE;
+        }
+        id = static_cast<RecipeId>(s_names.size());
+        s_names.push_back(def.id);
+        s_ids.emplace(def.id, id);
+        s_recipes.emplace_back();
+        s_ranges.emplace_back();
+    }
+
+    // A replaced recipe leaves its old stacks unused in the pool; recipes
+    // are only redefined while loading, so this stays small
+    Range& range      = s_ranges[id];
+    range.firstInput  = static_cast<uint32_t>(s_stacks.size());
+    range.inputCount  = static_cast<uint32_t>(def.inputs.size());
+    s_stacks.insert(s_stacks.end(), def.inputs.begin(), def.inputs.end());
+    range.firstOutput = static_cast<uint32_t>(s_stacks.size());
+    range.outputCount = static_cast<uint32_t>(def.outputs.size());
+    s_stacks.insert(s_stacks.end(), def.outputs.begin(), def.outputs.end());
+
+    s_recipes[id].duration = def.duration;
+    rebuildSpans();
+    return id;
 }
 
-std::span<const Recipe> RecipeDB::all() noexcept {
-    return s_recipes;
+void RecipeDB::clear() {
+    s_recipes.clear();
+    s_ranges.clear();
+    s_stacks.clear();
+    s_names.clear();
+    s_ids.clear();
+}
+
+RecipeId RecipeDB::find(std::string_view id) noexcept {
+    if (auto it = s_ids.find(id); it != s_ids.end())
+        return it->second;
+    return INVALID_RECIPE;
+}
+
+const std::string& RecipeDB::name(RecipeId id) noexcept {
+    static const std::string unknown = "<unknown recipe>";
+    return id < s_names.size() ? s_names[id] : unknown;
+}
+
+void RecipeDB::rebuildSpans() noexcept {
+    const std::span<const ItemStack> pool = s_stacks;
+    for (size_t i = 0; i < s_recipes.size(); i++) {
+        const Range& range   = s_ranges[i];
+        s_recipes[i].inputs  = pool.subspan(range.firstInput, range.inputCount);
+        s_recipes[i].outputs = pool.subspan(range.firstOutput, range.outputCount);
+    }
 }
 
 // =====================================================================
 // CInventory
 // =====================================================================
 
-const ItemStack* CInventory::find(const std::string& id) const noexcept {
-    for (const auto& stack : items)
-        if (stack.itemId == id) return &stack;
+bool CInventory::addItem(ItemId id, int count) {
+    const int used = size();
+    for (int i = 0; i < used; i++) {
+        if (stacks[i].item == id) {
+            stacks[i].count += count;
+            return true;
+        }
+    }
+    if (full()) return false;
+    stacks[used] = { id, count };
+    occupied |= static_cast<uint16_t>(1u << used);
+    return true;
+}
+
+bool CInventory::removeItem(ItemId id, int count) {
+    const int used = size();
+    for (int i = 0; i < used; i++) {
+        ItemStack& stack = stacks[i];
+        if (stack.item == id && stack.count >= count) {
+            stack.count -= count;
+            if (stack.count == 0) {
+                // Swap-remove: the last stack fills the hole
+                stack            = stacks[used - 1];
+                stacks[used - 1] = {};
+                occupied &= static_cast<uint16_t>(~(1u << (used - 1)));
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+const ItemStack* CInventory::find(ItemId id) const noexcept {
+    for (const auto& stack : slots())
+        if (stack.item == id) return &stack;
     return nullptr;
 }
 
-int CInventory::count(const std::string& id) const noexcept {
+int CInventory::count(ItemId id) const noexcept {
     if (const auto* s = find(id)) return s->count;
     return 0;
 }
 
-bool CInventory::hasItems(const std::string& id, int n) const noexcept {
+bool CInventory::hasItems(ItemId id, int n) const noexcept {
     return count(id) >= n;
 }
 
 bool CInventory::full() const noexcept {
-    return static_cast<int>(items.size()) >= maxSlots;
+    return size() >= std::min(maxSlots, MAX_SLOTS);
 }
 
-bool CInventory::empty() const noexcept {
-    return items.empty();
+// =====================================================================
+// CCrafter
+// =====================================================================
+
+float CCrafter::ratio(uint64_t now) const noexcept {
+    if (state == CrafterState::NoPower && progress >= 0.0f) return progress;
+    if (state != CrafterState::Crafting || finishTick <= startTick || now <= startTick) return 0.0f;
+    return std::min(static_cast<float>(now - startTick) / static_cast<float>(finishTick - startTick), 1.0f);
 }
 
 // =====================================================================
-// CCrafter
+// ECSWorld — lifetime
 // =====================================================================
 
-float CCrafter::ratio() const noexcept {
-    if (state != CrafterState::Crafting) return 0.0f;
-    const auto* recipe = RecipeDB::get(recipeId);
-    if (!recipe || recipe->duration <= 0.0f) return 0.0f;
-    return std::clamp(progress / recipe->duration, 0.0f, 1.0f);
+ECSWorld::ECSWorld()
+    : m_grid(std::make_unique<SpatialGrid>()),
+      m_lines(std::make_unique<TransportLines>()),
+      m_power(std::make_unique<PowerGrid>()),
+      m_scheduler(std::make_unique<SystemScheduler>()) {
+    m_grid->connect(m_registry);
+    m_lines->connect(m_registry, *m_grid);
+}
+
+ECSWorld::~ECSWorld() {
+    if (m_lines)
+        m_lines->disconnect(m_registry);
+    if (m_grid)
+        m_grid->disconnect(m_registry);
 }
 
 // =====================================================================
@@ -83,11 +247,17 @@ entt::entity ECSWorld::createBuilding(
     m_registry.emplace<CScale>(e);
     m_registry.emplace<CMesh>(e, modelPath, true);
 
-    auto& inv      = m_registry.emplace<CInventory>(e);
-    inv.maxSlots   = inventorySlots;
+    auto& inv    = m_registry.emplace<CInventory>(e);
+    inv.maxSlots = std::clamp(inventorySlots, 0, CInventory::MAX_SLOTS);
 
-    if (!recipeId.empty())
-        m_registry.emplace<CCrafter>(e, recipeId);
+    if (!recipeId.empty()) {
+        const RecipeId recipe = RecipeDB::find(recipeId);
+        if (recipe != INVALID_RECIPE) {
+            m_registry.emplace<CCrafter>(e, recipe);
+            wake(e);
+        } else
+            LOG_WARN(ECS, "Unknown recipe {}, building placed without crafter", recipeId);
+    }
 
     return e;
 }
@@ -97,32 +267,112 @@ entt::entity ECSWorld::createBelt(float x, float y, Direction dir, float speed)
     m_registry.emplace<CPosition>(e, x, y, 0.0f);
     m_registry.emplace<CMesh>(e, "models/belt.gltf", true);
     m_registry.emplace<CBelt>(e, dir, speed);
+    m_lines->addBelt(m_registry, *m_grid, e);
+    return e;
+}
+
+entt::entity ECSWorld::createPole(float x, float y, float wireReach, float supplyRadius) {
+    auto e = m_registry.create();
+    m_registry.emplace<CPosition>(e, x, y, 0.0f);
+    m_registry.emplace<CMesh>(e, "models/pole.gltf", true);
+    m_registry.emplace<CPowerPole>(e, wireReach, supplyRadius);
+    m_power->addPole(m_registry, *m_grid, e);
     return e;
 }
 
 void ECSWorld::destroy(entt::entity e) {
+    if (m_registry.all_of<CBelt>(e))
+        m_lines->removeBelt(m_registry, *m_grid, e);
+    if (m_registry.all_of<CPowerPole>(e))
+        m_power->removePole(m_registry, *m_grid, e);
+    m_power->detach(m_registry, e);
     m_registry.destroy(e);
 }
 
+void ECSWorld::move(entt::entity e, float x, float y) {
+    const bool belt    = m_registry.all_of<CBelt>(e);
+    const bool pole    = m_registry.all_of<CPowerPole>(e);
+    const bool machine = m_registry.any_of<CPowerConsumer, CPowerProducer>(e);
+    const bool storage = m_registry.all_of<CInventory>(e);
+    if (belt) m_lines->removeBelt(m_registry, *m_grid, e);
+    if (pole) m_power->removePole(m_registry, *m_grid, e);
+
+    const auto& from = m_registry.get<CPosition>(e);
+    // Lines delivering into the building resolve their output again
+    if (storage)
+        m_lines->invalidateAround(m_registry, *m_grid, static_cast<int32_t>(std::lround(from.x)),
+                                  static_cast<int32_t>(std::lround(from.y)));
+    if (!m_registry.all_of<CPrevPosition>(e))
+        m_registry.emplace<CPrevPosition>(e, from.x, from.y, from.z);
+
+    m_registry.patch<CPosition>(e, [&](CPosition& pos) {
+        pos.x = x;
+        pos.y = y;
+    });
+
+    if (belt) m_lines->addBelt(m_registry, *m_grid, e);
+    if (pole) m_power->addPole(m_registry, *m_grid, e);
+    if (machine) m_power->attach(m_registry, *m_grid, e);
+    if (storage)
+        m_lines->invalidateAround(m_registry, *m_grid, static_cast<int32_t>(std::lround(x)),
+                                  static_cast<int32_t>(std::lround(y)));
+}
+
+bool ECSWorld::insertOnBelt(entt::entity e, ItemId item) {
+    const auto* belt = m_registry.try_get<CBelt>(e);
+    if (!belt || belt->line == INVALID_LINE) return false;
+    const auto& pos = m_registry.get<CPosition>(e);
+    return m_lines->insert(belt->line, static_cast<int32_t>(std::lround(pos.x)), static_cast<int32_t>(std::lround(pos.y)),
+                           item, true);
+}
+
+// =====================================================================
+// System scheduling
+// =====================================================================
+
+void ECSWorld::addSystem(std::string name, SystemAccess access, SystemScheduler::SystemFn fn) {
+    m_scheduler->add(std::move(name), std::move(access), std::move(fn));
+}
+
+void ECSWorld::runSystems(float dt) {
+    for (auto [e, prev, pos] : m_registry.view<CPrevPosition, const CPosition>().each())
+        prev = { pos.x, pos.y, pos.z };
+
+    m_scheduler->run(*this, dt);
+}
+
+CPosition ECSWorld::renderPosition(entt::entity e, float alpha) const {
+    const auto& pos = m_registry.get<CPosition>(e);
+    if (const auto* prev = m_registry.try_get<CPrevPosition>(e)) {
+        return { prev->x + (pos.x - prev->x) * alpha,
+                 prev->y + (pos.y - prev->y) * alpha,
+                 prev->z + (pos.z - prev->z) * alpha };
+    }
+    return pos;
+}
+
 // =====================================================================
 // System — Crafters
 // =====================================================================
 
-void ECSWorld::tryStartCraft(CCrafter& crafter, CInventory& inv) {
-    const auto* recipe = RecipeDB::get(crafter.recipeId);
-    if (!recipe) { crafter.state = CrafterState::Idle; return; }
+void ECSWorld::tryStartCraft(entt::entity e, CCrafter& crafter, CInventory& inv) {
+    if (crafter.recipe == INVALID_RECIPE) { crafter.state = CrafterState::Idle; return; }
+    if (crafter.speed <= 0.0f) { crafter.state = CrafterState::NoPower; return; }
+    // Paused for power with its inputs already consumed
+    if (crafter.progress >= 0.0f) { scheduleCraft(e, crafter, crafter.progress); return; }
+    const Recipe& recipe = RecipeDB::get(crafter.recipe);
 
     // Check all inputs are available
-    for (const auto& input : recipe->inputs) {
-        if (!inv.hasItems(input.itemId, input.count)) {
+    for (const auto& input : recipe.inputs) {
+        if (!inv.hasItems(input.item, input.count)) {
             crafter.state = CrafterState::NoInput;
             return;
         }
     }
 
     // Check output space (rough check: at least one free slot or existing stack)
-    for (const auto& output : recipe->outputs) {
-        const auto* existing = inv.find(output.itemId);
+    for (const auto& output : recipe.outputs) {
+        const auto* existing = inv.find(output.item);
         if (!existing && inv.full()) {
             crafter.state = CrafterState::OutputFull;
             return;
@@ -130,47 +380,157 @@ void ECSWorld::tryStartCraft(CCrafter& crafter, CInventory& inv) {
     }
 
     // Consume inputs
-    for (const auto& input : recipe->inputs)
-        inv.removeItem(input.itemId, input.count);
+    for (const auto& input : recipe.inputs)
+        inv.removeItem(input.item, input.count);
 
-    crafter.progress = 0.0f;
-    crafter.state    = CrafterState::Crafting;
+    scheduleCraft(e, crafter, 0.0f);
+}
+
+void ECSWorld::scheduleCraft(entt::entity e, CCrafter& crafter, float progress) {
+    progress = std::clamp(progress, 0.0f, 0.999f);
+
+    // Remaining work at the current speed; startTick is placed back so ratio() carries on from progress
+    const double   base = RecipeDB::get(crafter.recipe).duration * TICKS_PER_SECOND;
+    const uint64_t left = std::max<uint64_t>(1, std::llround(base * (1.0f - progress) / crafter.speed));
+    const uint64_t done = std::llround(progress / (1.0f - progress) * static_cast<double>(left));
+    const uint64_t now  = tick();
+
+    crafter.startTick  = now - std::min(now, done);
+    crafter.finishTick = now + left;
+    crafter.state      = CrafterState::Crafting;
+    crafter.progress   = -1.0f;
+    m_craftWheel.schedule(e, crafter.finishTick);
+}
+
+void ECSWorld::setCrafterSpeed(entt::entity e, CCrafter& crafter, float speed) {
+    if (crafter.speed == speed) return;
+    crafter.speed = speed;
+
+    if (crafter.state == CrafterState::Crafting) {
+        const uint64_t now      = tick();
+        const float    progress = crafter.ratio(now);
+        if (speed <= 0.0f) {
+            // Pause: the pending timer goes stale
+            crafter.progress   = progress;
+            crafter.state      = CrafterState::NoPower;
+            crafter.finishTick = 0;
+        } else if (crafter.finishTick > now) {
+            scheduleCraft(e, crafter, progress);
+        }
+    } else if (crafter.state == CrafterState::NoPower && speed > 0.0f) {
+        wake(e);
+    }
 }
 
 void ECSWorld::finishCraft(CCrafter& crafter, CInventory& inv) {
-    const auto* recipe = RecipeDB::get(crafter.recipeId);
-    if (!recipe) return;
+    if (crafter.recipe == INVALID_RECIPE) return;
 
-    for (const auto& output : recipe->outputs)
-        inv.addItem(output.itemId, output.count);
+    for (const auto& output : RecipeDB::get(crafter.recipe).outputs)
+        inv.addItem(output.item, output.count);
 
-    crafter.progress = 0.0f;
-    crafter.state    = CrafterState::Idle;
+    crafter.state = CrafterState::Idle;
 
-    std::cout << "[ECS] Crafted recipe: " << crafter.recipeId << '\n';
+    LOG_TRACE(ECS, "Crafted recipe {}", RecipeDB::name(crafter.recipe));
 }
 
 void ECSWorld::updateCrafters(float dt) {
-    auto view = m_registry.view<CCrafter, CInventory>();
-
-    for (auto [entity, crafter, inv] : view.each()) {
-        switch (crafter.state) {
-
-        case CrafterState::Idle:
-        case CrafterState::NoInput:
-        case CrafterState::OutputFull:
-            tryStartCraft(crafter, inv);
-            break;
-
-        case CrafterState::Crafting: {
-            crafter.progress += dt;
-            const auto* recipe = RecipeDB::get(crafter.recipeId);
-            if (recipe && crafter.progress >= recipe->duration)
-                finishCraft(crafter, inv);
-            break;
-        }
-        }
+    // Tolerance: a fixed 1/TICKS_PER_SECOND step must always make one tick
+    m_tickAccum += dt * TICKS_PER_SECOND;
+    while (m_tickAccum >= 1.0f - 1e-4f) {
+        m_tickAccum -= 1.0f;
+        stepCrafters();
+    }
+}
+
+// One tick: only crafters finishing now or woken since the last tick are visited
+void ECSWorld::stepCrafters() {
+    m_craftDue.clear();
+    m_craftWheel.step(m_craftDue);
+
+    for (const auto& timer : m_craftDue) {
+        if (!m_registry.valid(timer.entity)) continue;
+        auto* crafter = m_registry.try_get<CCrafter>(timer.entity);
+        auto* inv     = m_registry.try_get<CInventory>(timer.entity);
+        // Stale timer: the crafter was replaced or restarted since
+        if (!crafter || !inv || crafter->state != CrafterState::Crafting || crafter->finishTick != timer.due)
+            continue;
+
+        finishCraft(*crafter, *inv);
+        tryStartCraft(timer.entity, *crafter, *inv);
     }
+
+    for (const entt::entity e : m_craftWake) {
+        if (!m_registry.valid(e)) continue;
+        auto* crafter = m_registry.try_get<CCrafter>(e);
+        auto* inv     = m_registry.try_get<CInventory>(e);
+        if (!crafter) continue;
+
+        crafter->queued = false;
+        if (inv && crafter->state != CrafterState::Crafting)
+            tryStartCraft(e, *crafter, *inv);
+    }
+    m_craftWake.clear();
+}
+
+void ECSWorld::wake(entt::entity e) {
+    auto* crafter = m_registry.try_get<CCrafter>(e);
+    if (!crafter || crafter->queued || crafter->state == CrafterState::Crafting) return;
+    crafter->queued = true;
+    m_craftWake.push_back(e);
+}
+
+bool ECSWorld::insertItem(entt::entity e, ItemId id, int count) {
+    auto* inv = m_registry.try_get<CInventory>(e);
+    if (!inv || !inv->addItem(id, count)) return false;
+    wake(e);
+    return true;
+}
+
+bool ECSWorld::takeItem(entt::entity e, ItemId id, int count) {
+    auto* inv = m_registry.try_get<CInventory>(e);
+    if (!inv || !inv->removeItem(id, count)) return false;
+    wake(e);
+    return true;
+}
+
+// =====================================================================
+// System — Power
+// =====================================================================
+
+void ECSWorld::updatePower() {
+    m_powerChanges.clear();
+    m_power->update(m_registry, m_powerChanges);
+    for (const auto& change : m_powerChanges)
+        applyPower(change.consumer, change.satisfaction);
+}
+
+void ECSWorld::applyPower(entt::entity e, float satisfaction) {
+    auto& consumer        = m_registry.get<CPowerConsumer>(e);
+    consumer.satisfaction = satisfaction;
+    consumer.satisfied    = satisfaction >= 1.0f;
+    if (auto* crafter = m_registry.try_get<CCrafter>(e))
+        setCrafterSpeed(e, *crafter, satisfaction);
+}
+
+void ECSWorld::addPowerConsumer(entt::entity e, float demandKW) {
+    m_power->detach(m_registry, e);
+    m_registry.emplace_or_replace<CPowerConsumer>(e, demandKW);
+    applyPower(e, 0.0f);
+    m_power->attach(m_registry, *m_grid, e);
+}
+
+void ECSWorld::addPowerProducer(entt::entity e, float outputKW) {
+    m_power->detach(m_registry, e);
+    m_registry.emplace_or_replace<CPowerProducer>(e, outputKW);
+    m_power->attach(m_registry, *m_grid, e);
+}
+
+void ECSWorld::setPowerDemand(entt::entity e, float demandKW) {
+    m_power->setDemand(m_registry, e, demandKW);
+}
+
+void ECSWorld::setPowerOutput(entt::entity e, float outputKW) {
+    m_power->setOutput(m_registry, e, outputKW);
 }
 
 // =====================================================================
@@ -178,60 +538,23 @@ void ECSWorld::updateCrafters(float dt) {
 // =====================================================================
 
 void ECSWorld::updateBelts(float dt) {
-    auto view = m_registry.view<CBelt, CPosition>();
-
-    for (auto [entity, belt, pos] : view.each()) {
-        if (!belt.carrying) continue;
-
-        belt.progress += dt * belt.speed;
-
-        if (belt.progress >= 1.0f) {
-            // Try to push item to next belt or building inventory
-            const float dx = (belt.direction == Direction::East)  ?  1.0f
-                           : (belt.direction == Direction::West)  ? -1.0f : 0.0f;
-            const float dy = (belt.direction == Direction::North) ?  1.0f
-                           : (belt.direction == Direction::South) ? -1.0f : 0.0f;
-
-            auto target = entityAt(pos.x + dx, pos.y + dy);
-            bool pushed = false;
-
-            if (target) {
-                // Try belt-to-belt
-                if (auto* nextBelt = m_registry.try_get<CBelt>(*target)) {
-                    if (!nextBelt->carrying) {
-                        nextBelt->carrying = belt.carrying;
-                        nextBelt->progress = 0.0f;
-                        pushed = true;
-                    }
-                }
-                // Try belt-to-inventory
-                else if (auto* inv = m_registry.try_get<CInventory>(*target)) {
-                    if (inv->addItem(belt.carrying->itemId, belt.carrying->count))
-                        pushed = true;
-                }
-            }
-
-            if (pushed) {
-                belt.carrying.reset();
-                belt.progress = 0.0f;
-            } else {
-                // Blocked — clamp and wait
-                belt.progress = 1.0f;
-            }
-        }
-    }
+    m_lines->update(m_registry, *m_grid, dt, [this](entt::entity building, ItemId item) {
+        return insertItem(building, item, 1);
+    });
 }
 
 // =====================================================================
-// Query — entity at world position
+// Queries — through the spatial grid
 // =====================================================================
 
 std::optional<entt::entity> ECSWorld::entityAt(float x, float y) const noexcept {
-    auto view = m_registry.view<const CPosition>();
-    for (auto [entity, pos] : view.each()) {
-        // Grid snap: match within 0.5 units
-        if (std::abs(pos.x - x) < 0.5f && std::abs(pos.y - y) < 0.5f)
-            return entity;
-    }
-    return std::nullopt;
-}
\ No newline at end of file
+    return m_grid->at(x, y);
+}
+
+void ECSWorld::entitiesIn(float minX, float minY, float maxX, float maxY, std::vector<entt::entity>& out) const {
+    m_grid->query(minX, minY, maxX, maxY, out);
+}
+
+void ECSWorld::nearestEntities(float x, float y, size_t k, std::vector<entt::entity>& out, float maxRadius) const {
+    m_grid->nearest(x, y, k, maxRadius, out);
+}
@@ -4,54 +4,129 @@
 #define ECS_H
 
 #include <entt/entt.hpp>
+#include <array>
+#include <bit>
+#include <memory>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <unordered_map>
 #include <functional>
 #include <optional>
 #include <concepts>
 #include <span>
+#include <limits>
 
 #include "../../utils/utils.h"
+#include "scheduler.h"
+#include "spatialgrid.h"
+#include "powergrid.h"
+#include "timingwheel.h"
+#include "transportline.h"
 // =====================================================================
 // Forward declarations
 // =====================================================================
 class Renderer;
 class ChunkManager;
 struct Mesh;
+struct WorldCapture;
 
 // =====================================================================
 // Item / Recipe system
 // =====================================================================
 
+// Dense item handle, interned once from the item name
+using ItemId = uint16_t;
+inline constexpr ItemId INVALID_ITEM = 0xFFFF;
+
+// Global item name table — names are only needed at the edges (UI, JSON, logs)
+class ItemRegistry {
+public:
+    // Id for name, registering it on first use
+    static ItemId intern(std::string_view name);
+    // Id for name, INVALID_ITEM if unknown
+    [[nodiscard]] static ItemId find(std::string_view name) noexcept;
+    [[nodiscard]] static const std::string& name(ItemId id) noexcept;
+    [[nodiscard]] static size_t size() noexcept { return s_names.size(); }
+
+private:
+    // Transparent hash: lookups by string_view without building a string
+    struct NameHash {
+        using is_transparent = void;
+        size_t operator()(std::string_view s) const noexcept { return std::hash<std::string_view>{}(s); }
+    };
+
+    static std::vector<std::string>                                          s_names;
+    static std::unordered_map<std::string, ItemId, NameHash, std::equal_to<>> s_ids;
+};
+
 struct ItemStack {
-    std::string itemId;
-    int         count = 0;
+    ItemId item  = INVALID_ITEM;
+    int    count = 0;
 
     [[nodiscard]] bool empty() const noexcept { return count <= 0; }
 };
 
-// Concept: anything that can be used as an item ID
-template<typename T>
-concept ItemIdLike = std::convertible_to<T, std::string>;
+// Dense recipe handle, resolved once when a crafter is placed
+using RecipeId = uint16_t;
+inline constexpr RecipeId INVALID_RECIPE = 0xFFFF;
 
-struct Recipe {
+// Authoring form of a recipe, as registered or read from JSON
+struct RecipeDef {
     std::string              id;
     std::vector<ItemStack>   inputs;
     std::vector<ItemStack>   outputs;
     float                    duration = 1.0f; // seconds
 };
 
-// Global recipe registry — populated at startup
+// Resolved recipe row — inputs/outputs are spans into one shared stack pool
+struct Recipe {
+    std::span<const ItemStack> inputs;
+    std::span<const ItemStack> outputs;
+    float                      duration = 1.0f; // seconds
+};
+
+// Global recipe registry — populated at startup, flat table indexed by RecipeId
 class RecipeDB {
 public:
-    static void              registerRecipe(Recipe recipe);
-    [[nodiscard]] static const Recipe* get(const std::string& id) noexcept;
-    [[nodiscard]] static std::span<const Recipe> all() noexcept;
+    // Bulk-load recipes from an assets-relative JSON file:
+    //   { "recipes": [ { "id": "smelt_iron", "duration": 3.0,
+    //                    "inputs":  [ { "item": "iron_ore",   "count": 2 } ],
+    //                    "outputs": [ { "item": "iron_plate", "count": 1 } ] } ] }
+    // Returns the number of recipes loaded, logs and returns 0 on error
+    static size_t   loadFromJSON(const std::string& relativePath);
+    // Registers or replaces a recipe, returns its id
+    static RecipeId registerRecipe(const RecipeDef& def);
+    static void     clear();
+
+    // Id for name, INVALID_RECIPE if unknown
+    [[nodiscard]] static RecipeId           find(std::string_view id) noexcept;
+    // id must be valid
+    [[nodiscard]] static const Recipe&      get(RecipeId id) noexcept { return s_recipes[id]; }
+    [[nodiscard]] static const std::string& name(RecipeId id) noexcept;
+    [[nodiscard]] static std::span<const Recipe> all() noexcept { return s_recipes; }
 
 private:
-    static std::vector<Recipe>                      s_recipes;
-    static std::unordered_map<std::string, size_t>  s_index;
+    struct NameHash {
+        using is_transparent = void;
+        size_t operator()(std::string_view s) const noexcept { return std::hash<std::string_view>{}(s); }
+    };
+
+    // Offsets of a row into s_stacks, kept to re-point the spans when the pool grows
+    struct Range {
+        uint32_t firstInput  = 0;
+        uint32_t inputCount  = 0;
+        uint32_t firstOutput = 0;
+        uint32_t outputCount = 0;
+    };
+
+    static void rebuildSpans() noexcept;
+
+    static std::vector<Recipe>                                                  s_recipes;
+    static std::vector<Range>                                                   s_ranges;
+    static std::vector<ItemStack>                                               s_stacks;
+    static std::vector<std::string>                                             s_names;
+    static std::unordered_map<std::string, RecipeId, NameHash, std::equal_to<>> s_ids;
 };
 
 // =====================================================================
@@ -65,6 +140,14 @@ struct CPosition {
     float z = 0.0f; // height / layer
 };
 
+// Position at the start of the current tick, for render interpolation.
+// Added by ECSWorld::move, refreshed by ECSWorld::runSystems
+struct CPrevPosition {
+    float x = 0.0f;
+    float y = 0.0f;
+    float z = 0.0f;
+};
+
 struct CRotation {
     float degrees = 0.0f; // 0 / 90 / 180 / 270 for iso grid
 };
@@ -82,55 +165,82 @@ struct CMesh {
 };
 
 // --- Inventory ---
+// Slots stored inline, no allocation per building. Used slots stay packed
+// at the front: an emptied stack is swap-removed, so occupied (one bit per
+// used slot) is always a low run of bits. Stack order is not kept
 struct CInventory {
-    std::vector<ItemStack> items;
-    int                    maxSlots  = 10;
-    int                    maxStack  = 999;
+    static constexpr int MAX_SLOTS = 16;
+
+    std::array<ItemStack, MAX_SLOTS> stacks{};
+    uint16_t                         occupied = 0;
+    int                              maxSlots = 10;   // at most MAX_SLOTS
+    int                              maxStack = 999;
 
     // Returns true if at least one item was added
-    bool addItem(ItemIdLike auto&& id, int count);
+    bool addItem(ItemId id, int count);
     // Returns true if the full amount was available and removed
-    bool removeItem(ItemIdLike auto&& id, int count);
+    bool removeItem(ItemId id, int count);
     // Returns nullptr if not found
-    [[nodiscard]] const ItemStack* find(const std::string& id) const noexcept;
-    [[nodiscard]] int              count(const std::string& id) const noexcept;
-    [[nodiscard]] bool             hasItems(const std::string& id, int n) const noexcept;
+    [[nodiscard]] const ItemStack* find(ItemId id) const noexcept;
+    [[nodiscard]] int              count(ItemId id) const noexcept;
+    [[nodiscard]] bool             hasItems(ItemId id, int n) const noexcept;
     [[nodiscard]] bool             full()  const noexcept;
-    [[nodiscard]] bool             empty() const noexcept;
+    [[nodiscard]] bool             empty() const noexcept { return occupied == 0; }
+    [[nodiscard]] int              size()  const noexcept { return std::popcount(occupied); }
 
-    // Iterate slots
-    [[nodiscard]] std::span<const ItemStack> slots() const noexcept { return items; }
+    // Iterate used slots
+    [[nodiscard]] std::span<const ItemStack> slots() const noexcept { return { stacks.data(), static_cast<size_t>(size()) }; }
 };
+static_assert(std::is_trivially_copyable_v<CInventory>);
 
 // --- Crafter ---
-enum class CrafterState { Idle, Crafting, OutputFull, NoInput };
+enum class CrafterState { Idle, Crafting, OutputFull, NoInput, NoPower };
 
+// Event driven: a crafting machine sits in ECSWorld's timing wheel until
+// finishTick, a blocked one is parked until ECSWorld::wake. Crafting time
+// is divided by speed, the power satisfaction of a CPowerConsumer; a craft
+// running out of power is paused with its progress kept
 struct CCrafter {
-    std::string  recipeId;
-    float        progress  = 0.0f;  // seconds elapsed
-    CrafterState state     = CrafterState::Idle;
-
-    [[nodiscard]] float ratio() const noexcept;  // 0..1 progress fraction
+    RecipeId     recipe     = INVALID_RECIPE;
+    CrafterState state      = CrafterState::Idle;
+    uint64_t     startTick  = 0;      // tick the current craft started
+    uint64_t     finishTick = 0;      // tick it completes, matches its wheel timer
+    bool         queued     = false;  // already in the wake list
+    float        speed      = 1.0f;   // 0..1, stays 1 without a CPowerConsumer
+    float        progress   = -1.0f;  // 0..1 done when paused for power, -1 otherwise
+
+    [[nodiscard]] float ratio(uint64_t now) const noexcept;  // 0..1 progress fraction at tick now
 };
 
 // --- Conveyor belt ---
 enum class Direction { North, East, South, West };
 
+// A belt tile; its items live in the TransportLine it belongs to
 struct CBelt {
     Direction direction = Direction::East;
-    float     speed     = 1.0f;          // items/second
-    std::optional<ItemStack> carrying;   // one item in transit
-    float     progress  = 0.0f;          // 0..1 travel along belt
+    float     speed     = 1.0f;           // tiles/second
+    LineId    line      = INVALID_LINE;   // owning transport line, kept by TransportLines
 };
 
 // --- Power ---
+// Machines draw their full rating while attached to a pole, crafting or
+// not. Add and rate them through ECSWorld so PowerGrid stays in sync
 struct CPowerConsumer {
-    float demandKW  = 0.0f;
-    bool  satisfied = false;
+    float  demandKW     = 0.0f;
+    float  satisfaction = 0.0f;           // supply / demand of its network, at most 1
+    bool   satisfied    = false;          // satisfaction == 1
+    PoleId pole         = INVALID_POLE;   // kept by PowerGrid
 };
 
 struct CPowerProducer {
-    float outputKW = 0.0f;
+    float  outputKW = 0.0f;
+    PoleId pole     = INVALID_POLE;       // kept by PowerGrid
+};
+
+struct CPowerPole {
+    float  wireReach    = 7.5f;           // tiles, to other poles
+    float  supplyRadius = 2.5f;           // tiles, half side of the square it powers
+    PoleId id           = INVALID_POLE;   // kept by PowerGrid
 };
 
 // --- Tags (zero-size marker components) ---
@@ -143,8 +253,10 @@ struct TPlayerOwned{};
 // =====================================================================
 class ECSWorld {
 public:
-    ECSWorld() = default;
-    ~ECSWorld() = default;
+    static constexpr int TICKS_PER_SECOND = 60;
+
+    ECSWorld();
+    ~ECSWorld();
 
     // Non-copyable, movable
     ECSWorld(const ECSWorld&)            = delete;
@@ -155,6 +267,9 @@ public:
     // -----------------------------------------------------------------
     // Entity factory helpers
     // -----------------------------------------------------------------
+    // recipeId is resolved against RecipeDB here, unknown ids leave the
+    // building without a crafter. inventorySlots is capped at
+    // CInventory::MAX_SLOTS
     [[nodiscard]] entt::entity createBuilding(
         const std::string& modelPath,
         float x, float y,
@@ -168,8 +283,27 @@ public:
         float speed = 1.0f
     );
 
+    [[nodiscard]] entt::entity createPole(
+        float x, float y,
+        float wireReach    = 7.5f,
+        float supplyRadius = 2.5f
+    );
+
     void destroy(entt::entity e);
 
+    // Move an entity, keeps the spatial index, transport lines and power
+    // networks in sync
+    // (do not write CPosition directly). Moved entities are interpolated
+    // by renderPosition
+    void move(entt::entity e, float x, float y);
+
+    // Position between the previous and the current tick, alpha in [0, 1]
+    // being the fraction of a tick elapsed since the last one
+    [[nodiscard]] CPosition renderPosition(entt::entity e, float alpha) const;
+
+    // Put an item mid-tile on a belt, false if there is no room
+    bool insertOnBelt(entt::entity belt, ItemId item);
+
     // -----------------------------------------------------------------
     // Component access (forwarded for convenience)
     // -----------------------------------------------------------------
@@ -195,12 +329,73 @@ public:
     // -----------------------------------------------------------------
     void updateCrafters(float dt);
     void updateBelts(float dt);
+    void updatePower();
+
+    // -----------------------------------------------------------------
+    // System scheduling
+    // -----------------------------------------------------------------
+    // Registered systems run once per runSystems call, non-conflicting ones
+    // in parallel (see SystemScheduler). Call it with a fixed dt: one call
+    // is one simulation tick
+    void addSystem(std::string name, SystemAccess access, SystemScheduler::SystemFn fn);
+    void runSystems(float dt);
+
+    [[nodiscard]] SystemScheduler&       scheduler()       noexcept { return *m_scheduler; }
+    [[nodiscard]] const SystemScheduler& scheduler() const noexcept { return *m_scheduler; }
+
+    // -----------------------------------------------------------------
+    // Crafter scheduling
+    // -----------------------------------------------------------------
+    // Parked crafters only re-check their recipe when woken: change building
+    // inventories through insertItem / takeItem, or call wake after editing
+    // a CInventory directly
+    void wake(entt::entity e);
+    bool insertItem(entt::entity e, ItemId id, int count);
+    bool takeItem  (entt::entity e, ItemId id, int count);
+
+    // Simulation tick advanced by updateCrafters
+    [[nodiscard]] uint64_t tick() const noexcept { return m_craftWheel.now(); }
+
+    // -----------------------------------------------------------------
+    // Power
+    // -----------------------------------------------------------------
+    // Make e a consumer / producer attached to the pole covering it.
+    // A new consumer is unpowered until the next updatePower
+    void addPowerConsumer(entt::entity e, float demandKW);
+    void addPowerProducer(entt::entity e, float outputKW);
+    void setPowerDemand(entt::entity e, float demandKW);
+    void setPowerOutput(entt::entity e, float outputKW);
+
+    [[nodiscard]] const PowerGrid& powerGrid() const noexcept { return *m_power; }
+
+    // -----------------------------------------------------------------
+    // Snapshots (format in snapshot.h)
+    // -----------------------------------------------------------------
+    // Append a snapshot of every entity, the transport lines and the tick
+    // to out. Systems are not part of it
+    void save(std::vector<uint8_t>& out) const;
+    // First half of save, the only one that reads the world: copy what the
+    // snapshot is made of into out, written later by WorldCapture::write
+    void capture(WorldCapture& out) const;
+    // Replace the world with a snapshot, sections it does not know are
+    // skipped. False (and an empty world) if it is malformed
+    bool load(std::span<const uint8_t> data);
 
     // -----------------------------------------------------------------
     // Queries
     // -----------------------------------------------------------------
     [[nodiscard]] std::optional<entt::entity> entityAt(float x, float y) const noexcept;
 
+    // Entities whose position lies in the rectangle (inclusive)
+    void entitiesIn(float minX, float minY, float maxX, float maxY, std::vector<entt::entity>& out) const;
+
+    // Up to k entities closest to (x, y) within maxRadius, nearest first
+    void nearestEntities(float x, float y, size_t k, std::vector<entt::entity>& out,
+                         float maxRadius = std::numeric_limits<float>::max()) const;
+
+    [[nodiscard]] const SpatialGrid& spatialIndex() const noexcept { return *m_grid; }
+    [[nodiscard]] const TransportLines& transportLines() const noexcept { return *m_lines; }
+
     // Call cb for every entity with component T
     template<typename T, typename Fn>
     void forEach(Fn&& cb) {
@@ -211,40 +406,34 @@ public:
     [[nodiscard]] const entt::registry& raw() const noexcept { return m_registry; }
 
 private:
-    entt::registry m_registry;
+    entt::registry               m_registry;
+    std::unique_ptr<SpatialGrid>    m_grid;     // heap: the registry signals hold its address
+    std::unique_ptr<TransportLines> m_lines;    // same
+    std::unique_ptr<PowerGrid>      m_power;
+    std::unique_ptr<SystemScheduler> m_scheduler;
+
+    // Crafter scheduling
+    TimingWheel                     m_craftWheel;     // crafting machines by finishTick
+    std::vector<entt::entity>       m_craftWake;      // parked crafters to re-check next tick
+    std::vector<TimingWheel::Timer> m_craftDue;       // scratch for the timers of one tick
+    float                           m_tickAccum = 0.0f;
+
+    std::vector<PowerChange>        m_powerChanges;   // scratch for updatePower
 
     // helpers
-    void tryStartCraft(CCrafter& crafter, CInventory& inv);
+    void stepCrafters();
+    void tryStartCraft(entt::entity e, CCrafter& crafter, CInventory& inv);
     void finishCraft  (CCrafter& crafter, CInventory& inv);
+    // Start or resume a craft progress of the way through, at crafter.speed
+    void scheduleCraft(entt::entity e, CCrafter& crafter, float progress);
+    void setCrafterSpeed(entt::entity e, CCrafter& crafter, float speed);
+    void applyPower(entt::entity e, float satisfaction);
+
+    // Snapshot loading
+    void clearState();
+    // networks: the power network section, if any
+    bool readSnapshot(std::span<const uint8_t> data, std::span<const uint8_t>& networks);
+    void restoreDerivedState(std::span<const uint8_t> networks);
 };
 
-// =====================================================================
-// CInventory template implementations (must be in header)
-// =====================================================================
-
-inline bool CInventory::addItem(ItemIdLike auto&& id, int count) {
-    const std::string sid{ std::forward<decltype(id)>(id) };
-    for (auto& stack : items) {
-        if (stack.itemId == sid) {
-            stack.count += count;
-            return true;
-        }
-    }
-    if (static_cast<int>(items.size()) >= maxSlots) return false;
-    items.push_back({ sid, count });
-    return true;
-}
-
-inline bool CInventory::removeItem(ItemIdLike auto&& id, int count) {
-    const std::string sid{ std::forward<decltype(id)>(id) };
-    for (auto it = items.begin(); it != items.end(); ++it) {
-        if (it->itemId == sid && it->count >= count) {
-            it->count -= count;
-            if (it->count == 0) items.erase(it);
-            return true;
-        }
-    }
-    return false;
-}
-
 #endif
\ No newline at end of file
@@ -0,0 +1,376 @@
+#include "powergrid.h"
+#include "ecs.h"
+#include "snapshot.h"
+#include "spatialgrid.h"
+
+#include <algorithm>
+
+// Pole a machine is attached to, INVALID_POLE if none
+static PoleId machinePole(const entt::registry& registry, entt::entity e) noexcept {
+    if (const auto* consumer = registry.try_get<CPowerConsumer>(e)) return consumer->pole;
+    if (const auto* producer = registry.try_get<CPowerProducer>(e)) return producer->pole;
+    return INVALID_POLE;
+}
+
+static void setMachinePole(entt::registry& registry, entt::entity e, PoleId id) noexcept {
+    if (auto* consumer = registry.try_get<CPowerConsumer>(e)) consumer->pole = id;
+    if (auto* producer = registry.try_get<CPowerProducer>(e)) producer->pole = id;
+}
+
+// =====================================================================
+// PowerGrid — union-find
+// =====================================================================
+
+PoleId PowerGrid::allocate() {
+    if (!m_free.empty()) {
+        const PoleId id = m_free.back();
+        m_free.pop_back();
+        return id;
+    }
+    m_poles.emplace_back();
+    return static_cast<PoleId>(m_poles.size() - 1);
+}
+
+PoleId PowerGrid::network(PoleId id) noexcept {
+    // Path halving
+    while (m_poles[id].parent != id) {
+        m_poles[id].parent = m_poles[m_poles[id].parent].parent;
+        id                 = m_poles[id].parent;
+    }
+    return id;
+}
+
+void PowerGrid::unite(PoleId a, PoleId b) {
+    a = network(a);
+    b = network(b);
+    if (a == b) return;
+    if (m_poles[a].size < m_poles[b].size) std::swap(a, b);
+
+    PowerPole& root  = m_poles[a];
+    PowerPole& child = m_poles[b];
+    child.parent     = a;
+    root.size       += child.size;
+    root.members.insert(root.members.end(), child.members.begin(), child.members.end());
+    child.members.clear();
+    root.netSupplyKW += child.netSupplyKW;
+    root.netDemandKW += child.netDemandKW;
+
+    m_networks--;
+    markDirty(a);
+}
+
+void PowerGrid::markDirty(PoleId root) {
+    if (m_poles[root].dirty) return;
+    m_poles[root].dirty = true;
+    m_dirty.push_back(root);
+}
+
+float PowerGrid::ratio(const PowerPole& root) noexcept {
+    if (root.netDemandKW <= 1e-6) return 1.0f;
+    return static_cast<float>(std::min(1.0, root.netSupplyKW / root.netDemandKW));
+}
+
+// =====================================================================
+// PowerGrid — poles
+// =====================================================================
+
+void PowerGrid::connectPole(entt::registry& registry, const SpatialGrid& grid, PoleId id) {
+    const PowerPole& p     = m_poles[id];
+    const auto       poles = registry.view<const CPowerPole>();
+    grid.query(p.x - p.wireReach, p.y - p.wireReach, p.x + p.wireReach, p.y + p.wireReach, m_scratch);
+
+    for (const entt::entity e : m_scratch) {
+        if (!poles.contains(e)) continue;
+        const auto& other = poles.get<const CPowerPole>(e);
+        if (other.id == INVALID_POLE || other.id == id) continue;
+
+        const PowerPole& q     = m_poles[other.id];
+        const float      reach = std::min(p.wireReach, q.wireReach);
+        const float      dx    = q.x - p.x;
+        const float      dy    = q.y - p.y;
+        if (dx * dx + dy * dy <= reach * reach)
+            unite(id, other.id);
+    }
+}
+
+PoleId PowerGrid::insertPole(entt::registry& registry, entt::entity e) {
+    auto&       comp = registry.get<CPowerPole>(e);
+    const auto& pos  = registry.get<CPosition>(e);
+
+    const PoleId id = allocate();
+    PowerPole&   p  = m_poles[id];
+    p               = PowerPole{};
+    p.entity        = e;
+    p.x             = pos.x;
+    p.y             = pos.y;
+    p.wireReach     = comp.wireReach;
+    p.supplyRadius  = comp.supplyRadius;
+    p.parent        = id;
+    p.members.push_back(id);
+
+    comp.id           = id;
+    m_networks++;
+    m_maxSupplyRadius = std::max(m_maxSupplyRadius, comp.supplyRadius);
+    return id;
+}
+
+void PowerGrid::addPole(entt::registry& registry, const SpatialGrid& grid, entt::entity e) {
+    if (registry.get<CPowerPole>(e).id != INVALID_POLE) return;
+    const PoleId id  = insertPole(registry, e);
+    const auto&  pos = registry.get<CPosition>(e);
+    connectPole(registry, grid, id);
+
+    // Adopt the unpowered machines in the supply area
+    const float r = m_poles[id].supplyRadius;
+    grid.query(pos.x - r, pos.y - r, pos.x + r, pos.y + r, m_scratch);
+    for (const entt::entity m : m_scratch) {
+        if (!registry.any_of<CPowerConsumer, CPowerProducer>(m)) continue;
+        if (machinePole(registry, m) == INVALID_POLE)
+            attachTo(registry, m, id);
+    }
+
+    markDirty(network(id));
+}
+
+void PowerGrid::removePole(entt::registry& registry, const SpatialGrid& grid, entt::entity e) {
+    auto* comp = registry.try_get<CPowerPole>(e);
+    if (!comp || comp->id == INVALID_POLE) return;
+    const PoleId id = comp->id;
+    comp->id        = INVALID_POLE;
+
+    // The whole network is rebuilt from its remaining poles
+    const PoleId              root    = network(id);
+    std::vector<PoleId>       members = std::move(m_poles[root].members);
+    std::vector<entt::entity> orphans = std::move(m_poles[id].machines);
+
+    m_poles[id] = PowerPole{};
+    m_free.push_back(id);
+    m_networks--;
+
+    for (const PoleId m : members) {
+        if (m == id) continue;
+        PowerPole& p   = m_poles[m];
+        p.parent       = m;
+        p.size         = 1;
+        p.members.assign(1, m);
+        p.netSupplyKW  = p.supplyKW;
+        p.netDemandKW  = p.demandKW;
+        p.satisfaction = -1.0f;
+        m_networks++;
+        markDirty(m);
+    }
+    for (const PoleId m : members)
+        if (m != id) connectPole(registry, grid, m);
+
+    // Machines of the removed pole move to another pole covering them, if any
+    for (const entt::entity m : orphans) {
+        setMachinePole(registry, m, INVALID_POLE);
+        attach(registry, grid, m);
+    }
+}
+
+// =====================================================================
+// PowerGrid — machines
+// =====================================================================
+
+void PowerGrid::addPoleKW(PoleId id, double supply, double demand) {
+    PowerPole& p = m_poles[id];
+    p.supplyKW  += supply;
+    p.demandKW  += demand;
+
+    const PoleId root = network(id);
+    m_poles[root].netSupplyKW += supply;
+    m_poles[root].netDemandKW += demand;
+    markDirty(root);
+}
+
+void PowerGrid::addMachineKW(const entt::registry& registry, entt::entity e, PoleId id, double sign) {
+    const auto* consumer = registry.try_get<CPowerConsumer>(e);
+    const auto* producer = registry.try_get<CPowerProducer>(e);
+    addPoleKW(id, sign * (producer ? producer->outputKW : 0.0f), sign * (consumer ? consumer->demandKW : 0.0f));
+}
+
+void PowerGrid::attachTo(entt::registry& registry, entt::entity e, PoleId id) {
+    m_poles[id].machines.push_back(e);
+    setMachinePole(registry, e, id);
+    addMachineKW(registry, e, id, 1.0);
+    m_pending.push_back(e);
+}
+
+PoleId PowerGrid::coveringPole(const entt::registry& registry, const SpatialGrid& grid, float x, float y) {
+    const float r = m_maxSupplyRadius;
+    if (r <= 0.0f) return INVALID_POLE;
+    const auto poles = registry.view<const CPowerPole>();
+    grid.query(x - r, y - r, x + r, y + r, m_scratch);
+
+    PoleId best     = INVALID_POLE;
+    float  bestDist = 0.0f;
+    for (const entt::entity e : m_scratch) {
+        if (!poles.contains(e)) continue;
+        const PoleId id = poles.get<const CPowerPole>(e).id;
+        if (id == INVALID_POLE) continue;
+
+        const PowerPole& p  = m_poles[id];
+        const float      dx = p.x - x;
+        const float      dy = p.y - y;
+        if (std::abs(dx) > p.supplyRadius || std::abs(dy) > p.supplyRadius) continue;
+
+        const float dist = dx * dx + dy * dy;
+        if (best == INVALID_POLE || dist < bestDist) {
+            best     = id;
+            bestDist = dist;
+        }
+    }
+    return best;
+}
+
+void PowerGrid::attach(entt::registry& registry, const SpatialGrid& grid, entt::entity e) {
+    detach(registry, e);
+
+    const auto&  pos = registry.get<CPosition>(e);
+    const PoleId id  = coveringPole(registry, grid, pos.x, pos.y);
+    if (id != INVALID_POLE)
+        attachTo(registry, e, id);
+    else
+        m_pending.push_back(e);
+}
+
+void PowerGrid::detach(entt::registry& registry, entt::entity e) {
+    const PoleId id = machinePole(registry, e);
+    if (id == INVALID_POLE) return;
+
+    auto& machines = m_poles[id].machines;
+    if (auto it = std::find(machines.begin(), machines.end(), e); it != machines.end()) {
+        *it = machines.back();
+        machines.pop_back();
+    }
+    addMachineKW(registry, e, id, -1.0);
+    setMachinePole(registry, e, INVALID_POLE);
+    m_pending.push_back(e);
+}
+
+void PowerGrid::setDemand(entt::registry& registry, entt::entity e, float kw) {
+    auto& consumer = registry.get<CPowerConsumer>(e);
+    if (consumer.pole != INVALID_POLE)
+        addPoleKW(consumer.pole, 0.0, static_cast<double>(kw) - consumer.demandKW);
+    consumer.demandKW = kw;
+}
+
+void PowerGrid::setOutput(entt::registry& registry, entt::entity e, float kw) {
+    auto& producer = registry.get<CPowerProducer>(e);
+    if (producer.pole != INVALID_POLE)
+        addPoleKW(producer.pole, static_cast<double>(kw) - producer.outputKW, 0.0);
+    producer.outputKW = kw;
+}
+
+void PowerGrid::clear() noexcept {
+    m_poles.clear();
+    m_free.clear();
+    m_dirty.clear();
+    m_pending.clear();
+    m_networks        = 0;
+    m_maxSupplyRadius = 0.0f;
+}
+
+void PowerGrid::rebuild(entt::registry& registry, const SpatialGrid& grid) {
+    clearAll(registry);
+    const auto poles = registry.view<CPowerPole, CPosition>();
+    for (const entt::entity e : poles)
+        insertPole(registry, e);
+    for (const entt::entity e : poles)
+        connectPole(registry, grid, poles.get<CPowerPole>(e).id);
+    attachAll(registry, grid);
+}
+
+void PowerGrid::clearAll(entt::registry& registry) {
+    clear();
+    for (auto [e, pole] : registry.view<CPowerPole>().each()) pole.id = INVALID_POLE;
+    for (auto [e, consumer] : registry.view<CPowerConsumer>().each()) consumer.pole = INVALID_POLE;
+    for (auto [e, producer] : registry.view<CPowerProducer>().each()) producer.pole = INVALID_POLE;
+}
+
+void PowerGrid::attachAll(entt::registry& registry, const SpatialGrid& grid) {
+    for (PoleId id = 0; id < m_poles.size(); id++)
+        if (m_poles[id].parent == id) markDirty(id);
+
+    // Every pole is in, so each machine goes to its nearest one
+    for (const entt::entity e : registry.view<CPowerConsumer, CPosition>())
+        attach(registry, grid, e);
+    for (const entt::entity e : registry.view<CPowerProducer, CPosition>())
+        if (!registry.all_of<CPowerConsumer>(e)) attach(registry, grid, e);
+}
+
+// =====================================================================
+// PowerGrid — snapshots
+// =====================================================================
+// [u32 count] then [pole entity][root pole entity] per pole
+
+void PowerGrid::save(SnapshotWriter& out) const {
+    out.write(static_cast<uint32_t>(poleCount()));
+    for (PoleId id = 0; id < m_poles.size(); id++) {
+        if (m_poles[id].entity == entt::null) continue;
+        PoleId root = id;
+        while (m_poles[root].parent != root) root = m_poles[root].parent;
+        out.write(m_poles[id].entity);
+        out.write(m_poles[root].entity);
+    }
+}
+
+bool PowerGrid::load(SnapshotReader& in, entt::registry& registry, const SpatialGrid& grid) {
+    clearAll(registry);
+
+    const auto count = in.read<uint32_t>();
+    const auto poles = registry.view<CPowerPole, CPosition>();
+    if (!in.ok() || in.remaining() != size_t(count) * 2 * sizeof(entt::entity) ||
+        count != registry.view<const CPowerPole>().size())
+        return false;
+
+    std::vector<entt::entity> links(2 * size_t(count));
+    in.readBytes(links.data(), links.size() * sizeof(entt::entity));
+    for (size_t i = 0; i < links.size(); i += 2) {
+        if (!poles.contains(links[i]) || poles.get<CPowerPole>(links[i]).id != INVALID_POLE) return false;
+        insertPole(registry, links[i]);
+    }
+    for (size_t i = 0; i < links.size(); i += 2) {
+        if (!poles.contains(links[i + 1])) return false;
+        unite(poles.get<CPowerPole>(links[i]).id, poles.get<CPowerPole>(links[i + 1]).id);
+    }
+
+    attachAll(registry, grid);
+    return in.ok();
+}
+
+// =====================================================================
+// PowerGrid — update
+// =====================================================================
+
+void PowerGrid::update(entt::registry& registry, std::vector<PowerChange>& out) {
+    // Consumers that joined or lost a network whose satisfaction may not change
+    for (const entt::entity e : m_pending) {
+        if (!registry.valid(e)) continue;
+        const auto* consumer = registry.try_get<CPowerConsumer>(e);
+        if (!consumer) continue;
+
+        const float value = consumer->pole == INVALID_POLE ? 0.0f : ratio(m_poles[network(consumer->pole)]);
+        if (value != consumer->satisfaction) out.push_back({ e, value });
+    }
+    m_pending.clear();
+
+    for (const PoleId id : m_dirty) {
+        PowerPole& root = m_poles[id];
+        root.dirty      = false;
+        // Freed or merged into another network since it was marked
+        if (root.entity == entt::null || root.parent != id) continue;
+
+        const float value = ratio(root);
+        if (value == root.satisfaction) continue;
+        root.satisfaction = value;
+
+        for (const PoleId member : root.members)
+            for (const entt::entity e : m_poles[member].machines) {
+                const auto* consumer = registry.try_get<CPowerConsumer>(e);
+                if (consumer && consumer->satisfaction != value) out.push_back({ e, value });
+            }
+    }
+    m_dirty.clear();
+}
@@ -0,0 +1,132 @@
+#pragma once
+
+#ifndef POWERGRID_H
+#define POWERGRID_H
+
+#include <entt/entt.hpp>
+#include <cstdint>
+#include <vector>
+
+class SpatialGrid;
+class SnapshotWriter;
+class SnapshotReader;
+
+using PoleId = uint32_t;
+inline constexpr PoleId INVALID_POLE = 0xFFFFFFFFu;
+
+// =====================================================================
+// PowerGrid — pole networks and their supply / demand
+// =====================================================================
+// Two poles are wired when they are within the shorter of their wire
+// reaches; a network is a connected set of poles, kept in a union-find
+// (union by size, path halving). Placing a pole only unions it with its
+// neighbours. Removing one rebuilds its own network and nothing else, as
+// union-find cannot split.
+//
+// A machine (CPowerConsumer and / or CPowerProducer) is attached to the
+// nearest pole whose square supply area covers it. Every pole sums the
+// machines attached to it and every network root sums its poles, so
+// totals are adjusted in O(1) per edit and a tick only visits networks
+// whose totals changed. Satisfaction (supply / demand, at most 1) is
+// pushed to the consumers of a network when it changes; unattached
+// consumers get 0.
+struct PowerPole {
+    entt::entity entity       = entt::null;   // null for a free slot
+    float        x            = 0.0f;
+    float        y            = 0.0f;
+    float        wireReach    = 0.0f;
+    float        supplyRadius = 0.0f;
+
+    // Machines attached to this pole, and their totals
+    std::vector<entt::entity> machines;
+    double                    supplyKW = 0.0;
+    double                    demandKW = 0.0;
+
+    // Union-find
+    PoleId   parent = INVALID_POLE;
+    uint32_t size   = 1;
+
+    // Network totals, valid on roots only
+    std::vector<PoleId> members;
+    double              netSupplyKW  = 0.0;     // double: adjusted incrementally for the pole's lifetime
+    double              netDemandKW  = 0.0;
+    float               satisfaction = -1.0f;   // last pushed, -1 forces a push
+    bool                dirty        = false;   // in the dirty list
+};
+
+struct PowerChange {
+    entt::entity consumer     = entt::null;
+    float        satisfaction = 0.0f;
+};
+
+class PowerGrid {
+public:
+    PowerGrid() = default;
+
+    PowerGrid(const PowerGrid&)            = delete;
+    PowerGrid& operator=(const PowerGrid&) = delete;
+
+    // Pole e must already have its CPosition and CPowerPole
+    void addPole   (entt::registry& registry, const SpatialGrid& grid, entt::entity e);
+    void removePole(entt::registry& registry, const SpatialGrid& grid, entt::entity e);
+
+    // Machine e must already have its CPosition and its power component(s);
+    // attach again after adding or removing one of them
+    void attach(entt::registry& registry, const SpatialGrid& grid, entt::entity e);
+    void detach(entt::registry& registry, entt::entity e);
+
+    // Change a machine's rating in place, the network is re-evaluated next update
+    void setDemand(entt::registry& registry, entt::entity e, float kw);
+    void setOutput(entt::registry& registry, entt::entity e, float kw);
+
+    void clear() noexcept;
+    // Networks and attachments from scratch, from the poles and machines in registry
+    void rebuild(entt::registry& registry, const SpatialGrid& grid);
+
+    // Snapshots hold the network root of every pole, so load restores the
+    // networks without wiring poles again; machines are attached anew.
+    // False if the section does not match the poles in registry, rebuild then
+    void save(SnapshotWriter& out) const;
+    bool load(SnapshotReader& in, entt::registry& registry, const SpatialGrid& grid);
+
+    // Satisfaction of the consumers of every network whose totals changed,
+    // appended to out for each consumer whose value differs from its own
+    void update(entt::registry& registry, std::vector<PowerChange>& out);
+
+    // Root of the network of pole id
+    [[nodiscard]] PoleId           network(PoleId id) noexcept;
+    [[nodiscard]] const PowerPole& pole(PoleId id) const noexcept { return m_poles[id]; }
+    [[nodiscard]] size_t           poleCount() const noexcept { return m_poles.size() - m_free.size(); }
+    [[nodiscard]] size_t           networkCount() const noexcept { return m_networks; }
+
+private:
+    std::vector<PowerPole>    m_poles;
+    std::vector<PoleId>       m_free;
+    std::vector<PoleId>       m_dirty;      // roots whose totals changed
+    std::vector<entt::entity> m_pending;    // consumers to push to regardless (attached, orphaned)
+    size_t                    m_networks        = 0;
+    float                     m_maxSupplyRadius = 0.0f;   // bounds the pole search of attach
+
+    std::vector<entt::entity> m_scratch;    // spatial query results
+
+    PoleId allocate();
+    // New pole for e on its own network, not wired yet
+    PoleId insertPole(entt::registry& registry, entt::entity e);
+    // clear, and forget the ids stored in the components
+    void   clearAll(entt::registry& registry);
+    // Attach every machine once all poles are in, every network marked dirty
+    void   attachAll(entt::registry& registry, const SpatialGrid& grid);
+    void   unite(PoleId a, PoleId b);
+    void   markDirty(PoleId root);
+    // Wire pole id to every pole in reach
+    void   connectPole(entt::registry& registry, const SpatialGrid& grid, PoleId id);
+    // Nearest pole covering (x, y), INVALID_POLE if none
+    PoleId coveringPole(const entt::registry& registry, const SpatialGrid& grid, float x, float y);
+    // Add the rating of machine e to pole id and its network
+    void   addMachineKW(const entt::registry& registry, entt::entity e, PoleId id, double sign);
+    void   addPoleKW(PoleId id, double supply, double demand);
+    void   attachTo(entt::registry& registry, entt::entity e, PoleId id);
+    [[nodiscard]] static float ratio(const PowerPole& root) noexcept;
+};
+
+#endif
@@ -0,0 +1,216 @@
+#include "scheduler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <ostream>
+
+static constexpr float TIMING_SMOOTHING = 0.05f;
+
+// Worker index of the calling thread in its pool, -1 outside any pool
+static thread_local const JobPool* t_pool  = nullptr;
+static thread_local int            t_index = -1;
+
+// =====================================================================
+// JobPool
+// =====================================================================
+
+JobPool::JobPool(int workerCount) {
+    if (workerCount <= 0)
+        workerCount = defaultWorkerCount();
+
+    m_queues.reserve(workerCount);
+    for (int i = 0; i < workerCount; i++)
+        m_queues.push_back(std::make_unique<Queue>());
+
+    m_workers.reserve(workerCount);
+    for (int i = 0; i < workerCount; i++)
+        m_workers.emplace_back(&JobPool::workerLoop, this, i);
+}
+
+JobPool::~JobPool() {
+    {
+        std::lock_guard lock(m_sleepMutex);
+        m_stopping = true;
+    }
+    m_sleepCv.notify_all();
+    for (auto& worker : m_workers)
+        worker.join();
+}
+
+int JobPool::defaultWorkerCount() {
+    const int hw = static_cast<int>(std::thread::hardware_concurrency());
+    return std::max(1, hw - 1);
+}
+
+void JobPool::spawn(Job job) {
+    const int self   = (t_pool == this) ? t_index : -1;
+    const int target = self >= 0 ? self : static_cast<int>(m_nextQueue++ % m_queues.size());
+    {
+        std::lock_guard lock(m_queues[target]->mutex);
+        m_queues[target]->jobs.push_back(std::move(job));
+    }
+    {
+        std::lock_guard lock(m_sleepMutex);
+        m_queued++;
+    }
+    m_sleepCv.notify_one();
+}
+
+bool JobPool::tryRun(int self) {
+    const int count = static_cast<int>(m_queues.size());
+    Job       job;
+
+    if (self >= 0) {
+        std::lock_guard lock(m_queues[self]->mutex);
+        if (!m_queues[self]->jobs.empty()) {
+            job = std::move(m_queues[self]->jobs.back());
+            m_queues[self]->jobs.pop_back();
+        }
+    }
+    for (int i = 1; !job && i <= count; i++) {
+        Queue& victim = *m_queues[(std::max(self, 0) + i) % count];
+        std::lock_guard lock(victim.mutex);
+        if (!victim.jobs.empty()) {
+            job = std::move(victim.jobs.front());
+            victim.jobs.pop_front();
+        }
+    }
+    if (!job) return false;
+
+    m_queued--;
+    job();
+    return true;
+}
+
+void JobPool::wait(const std::atomic<int>& pending) {
+    const int self = (t_pool == this) ? t_index : -1;
+    while (pending.load(std::memory_order_acquire) > 0) {
+        if (!tryRun(self))
+            std::this_thread::yield();
+    }
+}
+
+void JobPool::workerLoop(int index) {
+    t_pool  = this;
+    t_index = index;
+
+    for (;;) {
+        if (tryRun(index)) continue;
+
+        std::unique_lock lock(m_sleepMutex);
+        m_sleepCv.wait(lock, [&] { return m_stopping || m_queued.load() > 0; });
+        if (m_stopping) return;
+    }
+}
+
+// =====================================================================
+// SystemAccess
+// =====================================================================
+
+bool SystemAccess::conflicts(const SystemAccess& other) const noexcept {
+    auto overlaps = [](const std::vector<entt::id_type>& a, const std::vector<entt::id_type>& b) {
+        for (const auto id : a)
+            if (std::find(b.begin(), b.end(), id) != b.end()) return true;
+        return false;
+    };
+    return overlaps(writes, other.writes) || overlaps(writes, other.reads) || overlaps(reads, other.writes);
+}
+
+// =====================================================================
+// SystemScheduler — registration
+// =====================================================================
+
+SystemScheduler::~SystemScheduler() = default;
+
+void SystemScheduler::add(std::string name, SystemAccess access, SystemFn fn) {
+    const size_t index = m_systems.size();
+
+    System system{ std::move(access), std::move(fn), {}, 0 };
+    for (size_t i = 0; i < index; i++) {
+        if (m_systems[i].access.conflicts(system.access)) {
+            m_systems[i].successors.push_back(index);
+            system.dependencies++;
+        }
+    }
+    m_systems.push_back(std::move(system));
+    m_timings.push_back({ std::move(name) });
+
+    m_remaining = std::make_unique<std::atomic<int>[]>(m_systems.size());
+}
+
+void SystemScheduler::setWorkerCount(int count) {
+    if (count == m_workerCount) return;
+    m_workerCount = count;
+    m_pool.reset();
+}
+
+// =====================================================================
+// SystemScheduler — running
+// =====================================================================
+
+void SystemScheduler::runSystem(ECSWorld& world, size_t index, float dt) {
+    const auto t0 = std::chrono::steady_clock::now();
+    m_systems[index].fn(world, dt);
+    const float ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - t0).count();
+
+    SystemTiming& timing = m_timings[index];
+    timing.lastMs = ms;
+    timing.maxMs  = std::max(timing.maxMs, ms);
+    timing.avgMs  = timing.avgMs == 0.0f ? ms : timing.avgMs + (ms - timing.avgMs) * TIMING_SMOOTHING;
+}
+
+void SystemScheduler::spawnSystem(ECSWorld& world, size_t index, float dt) {
+    m_pool->spawn([this, &world, index, dt] {
+        try {
+            runSystem(world, index, dt);
+        } catch (...) {
+            std::lock_guard lock(m_errorMutex);
+            if (!m_error) m_error = std::current_exception();
+        }
+
+        // Release the systems waiting on this one
+        for (const size_t next : m_systems[index].successors)
+            if (m_remaining[next].fetch_sub(1, std::memory_order_acq_rel) == 1)
+                spawnSystem(world, next, dt);
+
+        m_pending.fetch_sub(1, std::memory_order_release);
+    });
+}
+
+void SystemScheduler::run(ECSWorld& world, float dt) {
+    if (m_systems.empty()) return;
+
+    if (m_deterministic || m_systems.size() == 1) {
+        for (size_t i = 0; i < m_systems.size(); i++)
+            runSystem(world, i, dt);
+        return;
+    }
+
+    if (!m_pool)
+        m_pool = std::make_unique<JobPool>(m_workerCount);
+
+    m_error = nullptr;
+    m_pending.store(static_cast<int>(m_systems.size()), std::memory_order_relaxed);
+    for (size_t i = 0; i < m_systems.size(); i++)
+        m_remaining[i].store(m_systems[i].dependencies, std::memory_order_relaxed);
+
+    for (size_t i = 0; i < m_systems.size(); i++)
+        if (m_systems[i].dependencies == 0)
+            spawnSystem(world, i, dt);
+
+    m_pool->wait(m_pending);
+
+    if (m_error)
+        std::rethrow_exception(m_error);
+}
+
+void SystemScheduler::printTimings(std::ostream& out) const {
+    char line[128];
+    out << "[Scheduler] " << (m_deterministic ? "serial" : "parallel") << ", " << m_systems.size() << " systems\n";
+    for (const auto& timing : m_timings) {
+        std::snprintf(line, sizeof(line), "[Scheduler]   %-16s last %7.3f ms  avg %7.3f ms  max %7.3f ms\n",
+                      timing.name.c_str(), timing.lastMs, timing.avgMs, timing.maxMs);
+        out << line;
+    }
+}
@@ -0,0 +1,149 @@
+#pragma once
+
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <entt/entt.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <iosfwd>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+class ECSWorld;
+
+// =====================================================================
+// JobPool — work-stealing thread pool
+// =====================================================================
+// One deque per worker: a worker pushes and pops its own jobs at the back
+// and steals from the front of the others when it runs dry. Jobs spawned
+// from outside the pool are dealt round robin. The thread waiting on a
+// batch helps run jobs instead of blocking.
+class JobPool {
+public:
+    using Job = std::function<void()>;
+
+    explicit JobPool(int workerCount);
+    ~JobPool();
+
+    JobPool(const JobPool&)            = delete;
+    JobPool& operator=(const JobPool&) = delete;
+
+    void spawn(Job job);
+    // Run jobs on the calling thread until pending drops to zero
+    void wait(const std::atomic<int>& pending);
+
+    [[nodiscard]] int workerCount() const noexcept { return static_cast<int>(m_workers.size()); }
+
+    // hardware_concurrency - 1, at least one
+    static int defaultWorkerCount();
+
+private:
+    struct Queue {
+        std::mutex      mutex;
+        std::deque<Job> jobs;
+    };
+
+    std::vector<std::unique_ptr<Queue>> m_queues;
+    std::vector<std::thread>            m_workers;
+
+    std::mutex              m_sleepMutex;
+    std::condition_variable m_sleepCv;
+    std::atomic<int>        m_queued{ 0 };
+    std::atomic<uint32_t>   m_nextQueue{ 0 };
+    bool                    m_stopping = false;
+
+    // Own queue first (back), then steal from the others (front)
+    bool tryRun(int self);
+    void workerLoop(int index);
+};
+
+// =====================================================================
+// SystemScheduler — systems run as a DAG of declared component access
+// =====================================================================
+// Each system declares the component types it reads and writes (any type
+// can stand for a shared resource). Two systems conflict when one writes
+// something the other reads or writes; conflicting systems keep their
+// registration order, the others run in parallel on the JobPool. As long
+// as the declarations are honest, a parallel tick gives the same result as
+// a serial one. Deterministic mode runs everything serially on the calling
+// thread in registration order, to rule the scheduler out when debugging.
+struct SystemAccess {
+    std::vector<entt::id_type> reads;
+    std::vector<entt::id_type> writes;
+
+    template<typename... Ts>
+    SystemAccess& read() {
+        (reads.push_back(entt::type_hash<Ts>::value()), ...);
+        return *this;
+    }
+
+    template<typename... Ts>
+    SystemAccess& write() {
+        (writes.push_back(entt::type_hash<Ts>::value()), ...);
+        return *this;
+    }
+
+    [[nodiscard]] bool conflicts(const SystemAccess& other) const noexcept;
+};
+
+struct SystemTiming {
+    std::string name;
+    float       lastMs = 0.0f;
+    float       avgMs  = 0.0f;  // moving average
+    float       maxMs  = 0.0f;
+};
+
+class SystemScheduler {
+public:
+    using SystemFn = std::function<void(ECSWorld&, float)>;
+
+    SystemScheduler() = default;
+    ~SystemScheduler();
+
+    SystemScheduler(const SystemScheduler&)            = delete;
+    SystemScheduler& operator=(const SystemScheduler&) = delete;
+
+    void add(std::string name, SystemAccess access, SystemFn fn);
+    void run(ECSWorld& world, float dt);
+
+    void setDeterministic(bool on) noexcept { m_deterministic = on; }
+    [[nodiscard]] bool deterministic() const noexcept { return m_deterministic; }
+    // Pool size, 0 for JobPool::defaultWorkerCount; applies from the next parallel run
+    void setWorkerCount(int count);
+
+    [[nodiscard]] std::span<const SystemTiming> timings() const noexcept { return m_timings; }
+    void printTimings(std::ostream& out) const;
+
+private:
+    struct System {
+        SystemAccess        access;
+        SystemFn            fn;
+        std::vector<size_t> successors;       // conflicting systems registered later
+        int                 dependencies = 0; // conflicting systems registered earlier
+    };
+
+    std::vector<System>       m_systems;
+    std::vector<SystemTiming> m_timings;
+    bool                      m_deterministic = false;
+
+    // Per-run state
+    std::unique_ptr<JobPool>              m_pool;           // created on the first parallel run
+    int                                   m_workerCount = 0;
+    std::unique_ptr<std::atomic<int>[]>   m_remaining;      // unfinished dependencies per system
+    std::atomic<int>                      m_pending{ 0 };   // systems not finished this run
+    std::mutex                            m_errorMutex;
+    std::exception_ptr                    m_error;
+
+    void runSystem(ECSWorld& world, size_t index, float dt);
+    void spawnSystem(ECSWorld& world, size_t index, float dt);
+};
+
+#endif
@@ -0,0 +1,486 @@
+#include "snapshot.h"
+
+#include <algorithm>
+
+namespace {
+    constexpr uint32_t TAG_ITEMS     = snapshotTag("ITEM");
+    constexpr uint32_t TAG_RECIPES   = snapshotTag("RCPE");
+    constexpr uint32_t TAG_CLOCK     = snapshotTag("CLCK");
+    constexpr uint32_t TAG_ENTITIES  = snapshotTag("ENTS");
+    constexpr uint32_t TAG_POSITION  = snapshotTag("CPOS");
+    constexpr uint32_t TAG_PREVPOS   = snapshotTag("CPRV");
+    constexpr uint32_t TAG_ROTATION  = snapshotTag("CROT");
+    constexpr uint32_t TAG_SCALE     = snapshotTag("CSCL");
+    constexpr uint32_t TAG_MESH      = snapshotTag("CMSH");
+    constexpr uint32_t TAG_INVENTORY = snapshotTag("CINV");
+    constexpr uint32_t TAG_CRAFTER   = snapshotTag("CCRF");
+    constexpr uint32_t TAG_BELT      = snapshotTag("CBLT");
+    constexpr uint32_t TAG_CONSUMER  = snapshotTag("CPWC");
+    constexpr uint32_t TAG_PRODUCER  = snapshotTag("CPWP");
+    constexpr uint32_t TAG_POLE      = snapshotTag("CPOL");
+    constexpr uint32_t TAG_OWNED     = snapshotTag("TOWN");
+    constexpr uint32_t TAG_LINES     = snapshotTag("LINE");
+    constexpr uint32_t TAG_NETWORKS  = snapshotTag("PNET");
+
+    template<typename T>
+    void captureColumn(const entt::registry& registry, WorldCapture& out, uint32_t tag) {
+        auto& column = std::get<SnapshotColumn<T>>(out.columns);
+        column.tag   = tag;
+        entt::snapshot{ registry }.get<T>(column);
+    }
+}
+
+// =====================================================================
+// SnapshotWriter
+// =====================================================================
+
+void SnapshotWriter::header() {
+    SnapshotHeader header{};
+    std::memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = SNAPSHOT_VERSION;
+    write(header);
+}
+
+void SnapshotWriter::writeBytes(const void* data, size_t size) {
+    const auto* bytes = static_cast<const uint8_t*>(data);
+    m_out.insert(m_out.end(), bytes, bytes + size);
+}
+
+void SnapshotWriter::writeString(std::string_view s) {
+    const auto length = static_cast<uint16_t>(std::min<size_t>(s.size(), UINT16_MAX));
+    write(length);
+    writeBytes(s.data(), length);
+}
+
+void SnapshotWriter::beginSection(uint32_t tag) {
+    write(tag);
+    m_section = m_out.size();
+    write(uint64_t{ 0 });
+}
+
+void SnapshotWriter::endSection() {
+    const uint64_t size = m_out.size() - m_section - sizeof(uint64_t);
+    std::memcpy(m_out.data() + m_section, &size, sizeof(size));
+}
+
+// =====================================================================
+// SnapshotReader
+// =====================================================================
+
+bool SnapshotReader::header() {
+    const auto header = read<SnapshotHeader>();
+    return m_ok && std::memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) == 0 &&
+           header.version == SNAPSHOT_VERSION;
+}
+
+void SnapshotReader::readBytes(void* out, size_t size) {
+    if (!m_ok || size > remaining()) {
+        m_ok = false;
+        std::memset(out, 0, size);
+        return;
+    }
+    if (size == 0) return;
+    std::memcpy(out, m_data.data() + m_at, size);
+    m_at += size;
+}
+
+std::string SnapshotReader::readString() {
+    const auto                     length = read<uint16_t>();
+    const std::span<const uint8_t> chars  = take(length);
+    return { reinterpret_cast<const char*>(chars.data()), chars.size() };
+}
+
+std::span<const uint8_t> SnapshotReader::take(size_t size) {
+    if (!m_ok || size > remaining()) {
+        m_ok = false;
+        return {};
+    }
+    const auto bytes = m_data.subspan(m_at, size);
+    m_at += size;
+    return bytes;
+}
+
+bool SnapshotReader::nextSection(uint32_t& tag, std::span<const uint8_t>& payload) {
+    if (!m_ok || remaining() == 0) return false;
+    tag              = read<uint32_t>();
+    const auto size  = read<uint64_t>();
+    if (!m_ok || size > remaining()) {
+        m_ok = false;
+        return false;
+    }
+    payload = take(static_cast<size_t>(size));
+    return true;
+}
+
+void SnapshotReader::operator()(std::underlying_type_t<entt::entity>& value) {
+    value = read<std::underlying_type_t<entt::entity>>();
+}
+
+void SnapshotReader::operator()(entt::entity& e) {
+    e = read<entt::entity>();
+}
+
+// =====================================================================
+// Component codecs
+// =====================================================================
+
+void SnapshotCodec<CMesh>::decode(SnapshotReader& in, CMesh& mesh, const SnapshotRemap&) {
+    mesh.modelPath = in.readString();
+    mesh.visible   = in.read<uint8_t>() != 0;
+}
+
+// [i32 maxSlots][i32 maxStack][u16 count] then [u16 item][i32 count] per slot
+void SnapshotCodec<CInventory>::encode(SnapshotWriter& out, const CInventory& inv) {
+    out.write(static_cast<int32_t>(inv.maxSlots));
+    out.write(static_cast<int32_t>(inv.maxStack));
+    out.write(static_cast<uint16_t>(inv.size()));
+    for (const ItemStack& stack : inv.slots()) {
+        out.write(stack.item);
+        out.write(static_cast<int32_t>(stack.count));
+    }
+}
+
+// Stacks past CInventory::MAX_SLOTS (saves from before inventories were
+// inline) are dropped
+void SnapshotCodec<CInventory>::decode(SnapshotReader& in, CInventory& inv, const SnapshotRemap& remap) {
+    inv              = {};
+    inv.maxSlots     = std::clamp<int32_t>(in.read<int32_t>(), 0, CInventory::MAX_SLOTS);
+    inv.maxStack     = in.read<int32_t>();
+    const auto count = in.read<uint16_t>();
+
+    int used = 0;
+    for (uint16_t i = 0; i < count && in.ok(); i++) {
+        const ItemId item  = remap.item(in.read<ItemId>());
+        const int    stack = in.read<int32_t>();
+        if (item == INVALID_ITEM || used == CInventory::MAX_SLOTS) continue;
+        inv.stacks[used++] = { item, stack };
+    }
+    inv.occupied = static_cast<uint16_t>((1u << used) - 1);
+}
+
+// [u16 recipe][u8 state][u8 queued][f32 speed][f32 progress][u64 startTick][u64 finishTick]
+void SnapshotCodec<CCrafter>::encode(SnapshotWriter& out, const CCrafter& crafter) {
+    out.write(crafter.recipe);
+    out.write(static_cast<uint8_t>(crafter.state));
+    out.write(static_cast<uint8_t>(crafter.queued));
+    out.write(crafter.speed);
+    out.write(crafter.progress);
+    out.write(crafter.startTick);
+    out.write(crafter.finishTick);
+}
+
+void SnapshotCodec<CCrafter>::decode(SnapshotReader& in, CCrafter& crafter, const SnapshotRemap& remap) {
+    crafter.recipe     = remap.recipe(in.read<RecipeId>());
+    crafter.state      = static_cast<CrafterState>(in.read<uint8_t>());
+    crafter.queued     = in.read<uint8_t>() != 0;
+    crafter.speed      = in.read<float>();
+    crafter.progress   = in.read<float>();
+    crafter.startTick  = in.read<uint64_t>();
+    crafter.finishTick = in.read<uint64_t>();
+
+    // Recipe gone since the save: the building keeps its crafter, idle
+    if (crafter.recipe == INVALID_RECIPE || crafter.state > CrafterState::NoPower) {
+        crafter.state    = CrafterState::Idle;
+        crafter.progress = -1.0f;
+    }
+}
+
+void SnapshotCodec<CPowerConsumer>::encode(SnapshotWriter& out, const CPowerConsumer& consumer) {
+    out.write(consumer.demandKW);
+    out.write(consumer.satisfaction);
+}
+
+void SnapshotCodec<CPowerConsumer>::decode(SnapshotReader& in, CPowerConsumer& consumer, const SnapshotRemap&) {
+    consumer.demandKW     = in.read<float>();
+    consumer.satisfaction = in.read<float>();
+    consumer.satisfied    = consumer.satisfaction >= 1.0f;
+    consumer.pole         = INVALID_POLE;
+}
+
+void SnapshotCodec<CPowerProducer>::encode(SnapshotWriter& out, const CPowerProducer& producer) {
+    out.write(producer.outputKW);
+}
+
+void SnapshotCodec<CPowerProducer>::decode(SnapshotReader& in, CPowerProducer& producer, const SnapshotRemap&) {
+    producer.outputKW = in.read<float>();
+    producer.pole     = INVALID_POLE;
+}
+
+void SnapshotCodec<CPowerPole>::encode(SnapshotWriter& out, const CPowerPole& pole) {
+    out.write(pole.wireReach);
+    out.write(pole.supplyRadius);
+}
+
+void SnapshotCodec<CPowerPole>::decode(SnapshotReader& in, CPowerPole& pole, const SnapshotRemap&) {
+    pole.wireReach    = in.read<float>();
+    pole.supplyRadius = in.read<float>();
+    pole.id           = INVALID_POLE;
+}
+
+// =====================================================================
+// Captures
+// =====================================================================
+
+void SnapshotColumn<CMesh>::operator()(std::underlying_type_t<entt::entity> size) {
+    entities.reserve(size);
+    paths.reserve(size);
+    visible.reserve(size);
+}
+
+void SnapshotColumn<CMesh>::operator()(const CMesh& mesh) {
+    // Neighbours in storage order are mostly the same kind of entity
+    if (paths.empty() || palette[paths.back()] != mesh.modelPath) {
+        auto it = m_ids.find(std::string_view{ mesh.modelPath });
+        if (it == m_ids.end()) {
+            it = m_ids.emplace(mesh.modelPath, static_cast<uint32_t>(palette.size())).first;
+            palette.push_back(mesh.modelPath);
+        }
+        paths.push_back(it->second);
+    } else {
+        paths.push_back(paths.back());
+    }
+    visible.push_back(static_cast<uint8_t>(mesh.visible));
+}
+
+void SnapshotColumn<CMesh>::clear() noexcept {
+    entities.clear();
+    paths.clear();
+    visible.clear();
+    palette.clear();
+    m_ids.clear();
+}
+
+size_t SnapshotColumn<CMesh>::bytes() const noexcept {
+    size_t longest = 0;
+    for (const std::string& path : palette) longest = std::max(longest, path.size());
+    const size_t perEntity = sizeof(entt::entity) + sizeof(uint16_t) + longest + sizeof(uint8_t);
+    return SNAPSHOT_SECTION_BYTES + sizeof(uint32_t) + entities.size() * perEntity;
+}
+
+void SnapshotColumn<CMesh>::write(SnapshotWriter& out) const {
+    out.beginSection(tag);
+    out.write(static_cast<uint32_t>(entities.size()));
+    out.writeBytes(entities.data(), entities.size() * sizeof(entt::entity));
+    for (size_t i = 0; i < paths.size(); i++) {
+        out.writeString(palette[paths[i]]);
+        out.write(visible[i]);
+    }
+    out.endSection();
+}
+
+void WorldCapture::clear() noexcept {
+    head.clear();
+    entities.words.clear();
+    std::apply([](auto&... column) { (column.clear(), ...); }, columns);
+    tail.clear();
+}
+
+void WorldCapture::write(std::vector<uint8_t>& out) const {
+    // Size up front, the buffer is otherwise copied over and over as it grows
+    size_t size = head.size() + tail.size() + entities.words.size() * sizeof(entities.words[0]);
+    std::apply([&](const auto&... column) { ((size += column.bytes()), ...); }, columns);
+    out.reserve(out.size() + size);
+
+    SnapshotWriter writer{ out };
+    writer.writeBytes(head.data(), head.size());
+
+    writer.beginSection(TAG_ENTITIES);
+    writer.writeBytes(entities.words.data(), entities.words.size() * sizeof(entities.words[0]));
+    writer.endSection();
+
+    std::apply([&](const auto&... column) { (column.write(writer), ...); }, columns);
+    writer.writeBytes(tail.data(), tail.size());
+}
+
+// =====================================================================
+// ECSWorld — snapshots
+// =====================================================================
+
+void ECSWorld::save(std::vector<uint8_t>& out) const {
+    WorldCapture snapshot;
+    capture(snapshot);
+    snapshot.write(out);
+}
+
+void ECSWorld::capture(WorldCapture& out) const {
+    out.clear();
+
+    SnapshotWriter writer{ out.head };
+    writer.header();
+
+    // Names of the ids the columns and lines refer to
+    writer.beginSection(TAG_ITEMS);
+    writer.write(static_cast<uint32_t>(ItemRegistry::size()));
+    for (size_t i = 0; i < ItemRegistry::size(); i++)
+        writer.writeString(ItemRegistry::name(static_cast<ItemId>(i)));
+    writer.endSection();
+
+    writer.beginSection(TAG_RECIPES);
+    writer.write(static_cast<uint32_t>(RecipeDB::all().size()));
+    for (size_t i = 0; i < RecipeDB::all().size(); i++)
+        writer.writeString(RecipeDB::name(static_cast<RecipeId>(i)));
+    writer.endSection();
+
+    writer.beginSection(TAG_CLOCK);
+    writer.write(tick());
+    writer.write(m_tickAccum);
+    writer.endSection();
+
+    // Pools are copied as they are, encoded by WorldCapture::write
+    entt::snapshot{ m_registry }.get<entt::entity>(out.entities);
+    captureColumn<CPosition>(m_registry, out, TAG_POSITION);
+    captureColumn<CPrevPosition>(m_registry, out, TAG_PREVPOS);
+    captureColumn<CRotation>(m_registry, out, TAG_ROTATION);
+    captureColumn<CScale>(m_registry, out, TAG_SCALE);
+    captureColumn<CMesh>(m_registry, out, TAG_MESH);
+    captureColumn<CInventory>(m_registry, out, TAG_INVENTORY);
+    captureColumn<CCrafter>(m_registry, out, TAG_CRAFTER);
+    captureColumn<CBelt>(m_registry, out, TAG_BELT);
+    captureColumn<CPowerConsumer>(m_registry, out, TAG_CONSUMER);
+    captureColumn<CPowerProducer>(m_registry, out, TAG_PRODUCER);
+    captureColumn<CPowerPole>(m_registry, out, TAG_POLE);
+    captureColumn<TPlayerOwned>(m_registry, out, TAG_OWNED);
+
+    // Lines and networks are encoded right away, they come after the
+    // columns they refer to
+    SnapshotWriter tail{ out.tail };
+    tail.beginSection(TAG_LINES);
+    m_lines->save(tail);
+    tail.endSection();
+
+    tail.beginSection(TAG_NETWORKS);
+    m_power->save(tail);
+    tail.endSection();
+}
+
+bool ECSWorld::load(std::span<const uint8_t> data) {
+    // Neither index follows the columns as they go in: positions are
+    // indexed in one pass at the end, lines are loaded as a whole
+    m_lines->disconnect(m_registry);
+    m_grid->disconnect(m_registry);
+
+    std::span<const uint8_t> networks;
+    const bool               ok = readSnapshot(data, networks);
+    if (!ok) {
+        LOG_ERROR(ECS, "Invalid or unsupported world snapshot, world left empty");
+        clearState();
+    }
+
+    m_grid->connect(m_registry);
+    if (ok) restoreDerivedState(networks);
+    m_lines->connect(m_registry, *m_grid);
+    return ok;
+}
+
+void ECSWorld::clearState() {
+    m_registry = entt::registry{};
+    m_lines->clear();
+    m_power->clear();
+    m_craftWheel.reset();
+    m_craftWake.clear();
+    m_tickAccum = 0.0f;
+}
+
+bool ECSWorld::readSnapshot(std::span<const uint8_t> data, std::span<const uint8_t>& networks) {
+    clearState();
+
+    SnapshotReader in{ data };
+    if (!in.header()) return false;
+
+    SnapshotRemap            remap;
+    bool                     haveEntities = false;
+    bool                     haveLines    = false;
+    uint32_t                 tag          = 0;
+    std::span<const uint8_t> payload;
+
+    while (in.nextSection(tag, payload)) {
+        SnapshotReader section{ payload };
+        bool           ok = true;
+
+        switch (tag) {
+        case TAG_ITEMS: {
+            const auto count = section.read<uint32_t>();
+            ok = count <= section.remaining() / sizeof(uint16_t);
+            if (ok) remap.items.resize(count);
+            for (ItemId& id : remap.items) id = ItemRegistry::intern(section.readString());
+            break;
+        }
+
+        case TAG_RECIPES: {
+            const auto count = section.read<uint32_t>();
+            ok = count <= section.remaining() / sizeof(uint16_t);
+            if (ok) remap.recipes.resize(count);
+            for (RecipeId& id : remap.recipes) id = RecipeDB::find(section.readString());
+            break;
+        }
+
+        case TAG_CLOCK:
+            m_craftWheel.reset(section.read<uint64_t>());
+            m_tickAccum = section.read<float>();
+            break;
+
+        case TAG_ENTITIES: {
+            // [u32 size][u32 in use][entities]: checked up front, the loader trusts its archive
+            uint32_t count = 0, inUse = 0;
+            if (payload.size() >= 2 * sizeof(uint32_t)) {
+                std::memcpy(&count, payload.data(), sizeof(count));
+                std::memcpy(&inUse, payload.data() + sizeof(count), sizeof(inUse));
+            }
+            ok = !haveEntities && inUse <= count &&
+                 payload.size() == 2 * sizeof(uint32_t) + size_t(count) * sizeof(entt::entity);
+            if (ok) entt::snapshot_loader{ m_registry }.get<entt::entity>(section);
+            haveEntities = true;
+            break;
+        }
+
+        case TAG_POSITION:  ok = haveEntities && section.column<CPosition>(m_registry, remap); break;
+        case TAG_PREVPOS:   ok = haveEntities && section.column<CPrevPosition>(m_registry, remap); break;
+        case TAG_ROTATION:  ok = haveEntities && section.column<CRotation>(m_registry, remap); break;
+        case TAG_SCALE:     ok = haveEntities && section.column<CScale>(m_registry, remap); break;
+        case TAG_MESH:      ok = haveEntities && section.column<CMesh>(m_registry, remap); break;
+        case TAG_INVENTORY: ok = haveEntities && section.column<CInventory>(m_registry, remap); break;
+        case TAG_CRAFTER:   ok = haveEntities && section.column<CCrafter>(m_registry, remap); break;
+        case TAG_BELT:      ok = haveEntities && section.column<CBelt>(m_registry, remap); break;
+        case TAG_CONSUMER:  ok = haveEntities && section.column<CPowerConsumer>(m_registry, remap); break;
+        case TAG_PRODUCER:  ok = haveEntities && section.column<CPowerProducer>(m_registry, remap); break;
+        case TAG_POLE:      ok = haveEntities && section.column<CPowerPole>(m_registry, remap); break;
+        case TAG_OWNED:     ok = haveEntities && section.column<TPlayerOwned>(m_registry, remap); break;
+
+        case TAG_LINES:
+            ok        = haveEntities && !haveLines && m_lines->load(section, m_registry, remap);
+            haveLines = true;
+            break;
+
+        case TAG_NETWORKS:
+            networks = payload;     // needs the spatial index, read once every column is in
+            break;
+
+        default:
+            break;    // written by a newer build or another owner (chunk deltas)
+        }
+
+        if (!ok || !section.ok()) return false;
+    }
+    if (!in.ok() || !haveEntities) return false;
+
+    // Belts index the lines by CBelt::line: with belts the lines must be
+    // there, and agree with them
+    if (!haveLines && m_registry.view<const CBelt>().size() != 0) return false;
+    return m_lines->checkBelts(m_registry);
+}
+
+// State the snapshot leaves out: pole attachments, crafter timers and wake list
+void ECSWorld::restoreDerivedState(std::span<const uint8_t> networks) {
+    SnapshotReader in{ networks };
+    if (networks.empty() || !m_power->load(in, m_registry, *m_grid))
+        m_power->rebuild(m_registry, *m_grid);
+
+    for (auto [e, crafter] : m_registry.view<CCrafter>().each()) {
+        if (crafter.state == CrafterState::Crafting)
+            m_craftWheel.schedule(e, crafter.finishTick);
+        if (crafter.queued) {
+            crafter.queued = false;
+            wake(e);
+        }
+    }
+}
@@ -0,0 +1,351 @@
+#pragma once
+
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <entt/entt.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include "ecs.h"
+
+// =====================================================================
+// World snapshots — versioned binary save format
+// =====================================================================
+// Layout (host byte order, little-endian on every supported target):
+//   SnapshotHeader                     magic, version
+//   sections                           [u32 tag][u64 size][payload]
+//
+// Readers skip the sections they do not know: a section can be added
+// without a version bump, SNAPSHOT_VERSION changes when an existing one
+// changes layout.
+//
+// Entity storage goes through entt::snapshot / entt::snapshot_loader, so
+// identifiers (versions included) and the free list survive a round trip
+// and components referring to other entities stay valid. Components are
+// written as columns, one section per type: [u32 count][entities][values],
+// values packed back to back by SnapshotCodec. A column is bulk inserted on
+// load, one registry.insert per type.
+//
+// Item and recipe ids are interned per session, so the snapshot carries
+// their names and ids are remapped on load.
+//
+// Saving is split in two: ECSWorld::capture copies the state (component
+// pools as they are, lines and networks already encoded) into a
+// WorldCapture, WorldCapture::write encodes it. Only the capture needs the
+// world, the write can run on another thread while the world ticks on.
+//
+// Snapshot files (Simulation::save) are RLE packed as a whole:
+//   [SNAPSHOT_PACKED_MAGIC][u64 snapshot size][Compression::packRLE stream]
+inline constexpr char     SNAPSHOT_MAGIC[4] = { 'S', 'G', 'W', 'S' };
+inline constexpr uint32_t SNAPSHOT_VERSION  = 1;
+inline constexpr char     SNAPSHOT_PACKED_MAGIC[4] = { 'S', 'G', 'W', 'Z' };
+
+struct SnapshotHeader {
+    char     magic[4];
+    uint32_t version;
+};
+
+// Section tag from its four character name
+constexpr uint32_t snapshotTag(const char (&name)[5]) noexcept {
+    return uint32_t(uint8_t(name[0])) | uint32_t(uint8_t(name[1])) << 8 | uint32_t(uint8_t(name[2])) << 16 |
+           uint32_t(uint8_t(name[3])) << 24;
+}
+
+// [u32 tag][u64 size], then the payload
+inline constexpr size_t SNAPSHOT_SECTION_BYTES = sizeof(uint32_t) + sizeof(uint64_t);
+
+// Sections written by owners other than ECSWorld
+inline constexpr uint32_t SNAPSHOT_CHUNK_DELTAS = snapshotTag("DLTA");   // ChunkManager::saveDeltas
+
+// Snapshot ids to this session's ids
+struct SnapshotRemap {
+    std::vector<ItemId>   items;
+    std::vector<RecipeId> recipes;
+
+    [[nodiscard]] ItemId item(ItemId id) const noexcept { return id < items.size() ? items[id] : INVALID_ITEM; }
+    [[nodiscard]] RecipeId recipe(RecipeId id) const noexcept {
+        return id < recipes.size() ? recipes[id] : INVALID_RECIPE;
+    }
+};
+
+// =====================================================================
+// SnapshotWriter — appends to a byte buffer
+// =====================================================================
+class SnapshotWriter {
+public:
+    explicit SnapshotWriter(std::vector<uint8_t>& out) noexcept : m_out(out) {}
+
+    void header();
+
+    void writeBytes(const void* data, size_t size);
+    template<typename T>
+    void write(const T& value) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        writeBytes(&value, sizeof(T));
+    }
+    // u16 length, then the characters
+    void writeString(std::string_view s);
+
+    // Sections do not nest
+    void beginSection(uint32_t tag);
+    void endSection();
+
+    [[nodiscard]] std::vector<uint8_t>& bytes() noexcept { return m_out; }
+
+private:
+    std::vector<uint8_t>& m_out;
+    size_t                m_section = 0;   // offset of the open section's size field
+};
+
+// =====================================================================
+// SnapshotReader — reads a byte span, entt::snapshot_loader archive
+// =====================================================================
+// Reading past the end fails the reader for good: values read from then
+// on are zero and ok() returns false, so callers check once at the end.
+class SnapshotReader {
+public:
+    explicit SnapshotReader(std::span<const uint8_t> data) noexcept : m_data(data) {}
+
+    // False if the magic or version does not match
+    bool header();
+
+    void readBytes(void* out, size_t size);
+    template<typename T>
+    T read() {
+        static_assert(std::is_trivially_copyable_v<T>);
+        T value{};
+        readBytes(&value, sizeof(T));
+        return value;
+    }
+    std::string readString();
+    // The next size bytes, empty on failure
+    std::span<const uint8_t> take(size_t size);
+
+    // Next section, false at the end of the data or on a truncated section
+    bool nextSection(uint32_t& tag, std::span<const uint8_t>& payload);
+
+    // Bulk insert a column written by SnapshotWriter::column
+    template<typename T>
+    bool column(entt::registry& registry, const SnapshotRemap& remap);
+
+    // entt::snapshot_loader archive
+    void operator()(std::underlying_type_t<entt::entity>& value);
+    void operator()(entt::entity& e);
+
+    [[nodiscard]] bool   ok()        const noexcept { return m_ok; }
+    [[nodiscard]] size_t remaining() const noexcept { return m_data.size() - m_at; }
+
+private:
+    std::span<const uint8_t> m_data;
+    size_t                   m_at = 0;
+    bool                     m_ok = true;
+};
+
+// =====================================================================
+// SnapshotCodec — how a component is packed in its column
+// =====================================================================
+// The default copies the component's bytes, for trivially copyable
+// components without padding. Specializations write field by field and
+// remap ids; packed ones are read with a single copy per column.
+template<typename T>
+struct SnapshotCodec {
+    static_assert(std::is_trivially_copyable_v<T>, "specialize SnapshotCodec for this component");
+    static constexpr bool packed = true;
+
+    static void encode(SnapshotWriter& out, const T& value) { out.write(value); }
+    static void decode(SnapshotReader& in, T& value, const SnapshotRemap&) { value = in.read<T>(); }
+};
+
+// [u16 length][path][u8 visible]; written from SnapshotColumn<CMesh>'s palette
+template<>
+struct SnapshotCodec<CMesh> {
+    static constexpr bool packed = false;
+    static void decode(SnapshotReader& in, CMesh& mesh, const SnapshotRemap& remap);
+};
+
+template<>
+struct SnapshotCodec<CInventory> {
+    static constexpr bool packed = false;
+    static void encode(SnapshotWriter& out, const CInventory& inv);
+    static void decode(SnapshotReader& in, CInventory& inv, const SnapshotRemap& remap);
+};
+
+template<>
+struct SnapshotCodec<CCrafter> {
+    static constexpr bool packed = false;
+    static void encode(SnapshotWriter& out, const CCrafter& crafter);
+    static void decode(SnapshotReader& in, CCrafter& crafter, const SnapshotRemap& remap);
+};
+
+// Power: only the ratings, attachments are restored by PowerGrid::load
+template<>
+struct SnapshotCodec<CPowerConsumer> {
+    static constexpr bool packed = false;
+    static void encode(SnapshotWriter& out, const CPowerConsumer& consumer);
+    static void decode(SnapshotReader& in, CPowerConsumer& consumer, const SnapshotRemap& remap);
+};
+
+template<>
+struct SnapshotCodec<CPowerProducer> {
+    static constexpr bool packed = false;
+    static void encode(SnapshotWriter& out, const CPowerProducer& producer);
+    static void decode(SnapshotReader& in, CPowerProducer& producer, const SnapshotRemap& remap);
+};
+
+template<>
+struct SnapshotCodec<CPowerPole> {
+    static constexpr bool packed = false;
+    static void encode(SnapshotWriter& out, const CPowerPole& pole);
+    static void decode(SnapshotReader& in, CPowerPole& pole, const SnapshotRemap& remap);
+};
+
+// =====================================================================
+// SnapshotColumn — copy of one component pool
+// =====================================================================
+// Filled as an entt::snapshot archive: the pool's size, then its entities
+// and components in storage order. Nothing is encoded until write.
+template<typename T>
+struct SnapshotColumn {
+    uint32_t                  tag = 0;
+    std::vector<entt::entity> entities;
+    std::vector<T>            values;   // empty for tag components
+
+    void operator()(std::underlying_type_t<entt::entity> size) {
+        entities.reserve(size);
+        if constexpr (!std::is_empty_v<T>) values.reserve(size);
+    }
+    void operator()(entt::entity e) { entities.push_back(e); }
+    void operator()(const T& value) { values.push_back(value); }
+
+    void clear() noexcept {
+        entities.clear();
+        values.clear();
+    }
+    // Written size, an upper bound for codecs that are not packed
+    [[nodiscard]] size_t bytes() const noexcept {
+        constexpr size_t VALUE_BYTES = std::is_empty_v<T> ? 0 : sizeof(T);
+        return SNAPSHOT_SECTION_BYTES + sizeof(uint32_t) + entities.size() * (sizeof(entt::entity) + VALUE_BYTES);
+    }
+    void write(SnapshotWriter& out) const;
+};
+
+// Mesh paths are a handful of model files shared by every entity: the
+// copy keeps one string per path and an index per entity
+template<>
+struct SnapshotColumn<CMesh> {
+    uint32_t                  tag = 0;
+    std::vector<entt::entity> entities;
+    std::vector<uint32_t>     paths;    // into palette
+    std::vector<uint8_t>      visible;
+    std::vector<std::string>  palette;
+
+    void operator()(std::underlying_type_t<entt::entity> size);
+    void operator()(entt::entity e) { entities.push_back(e); }
+    void operator()(const CMesh& mesh);
+
+    void clear() noexcept;
+    [[nodiscard]] size_t bytes() const noexcept;
+    void                 write(SnapshotWriter& out) const;
+
+private:
+    struct PathHash {
+        using is_transparent = void;
+        size_t operator()(std::string_view s) const noexcept { return std::hash<std::string_view>{}(s); }
+    };
+    std::unordered_map<std::string, uint32_t, PathHash, std::equal_to<>> m_ids;
+};
+
+// Entity storage: [u32 size][u32 in use][entities], all 32-bit words
+struct SnapshotEntities {
+    std::vector<std::underlying_type_t<entt::entity>> words;
+
+    void operator()(std::underlying_type_t<entt::entity> value) { words.push_back(value); }
+    void operator()(entt::entity e) { words.push_back(entt::to_integral(e)); }
+};
+
+// =====================================================================
+// WorldCapture — everything ECSWorld::save writes, copied
+// =====================================================================
+// Self-contained: write() reads nothing from the world, the registries or
+// the item / recipe tables, so it can run on any thread. Owners other than
+// ECSWorld (chunk deltas) append their sections to tail.
+struct WorldCapture {
+    std::vector<uint8_t> head;      // header, names, clock
+    SnapshotEntities     entities;
+    std::tuple<SnapshotColumn<CPosition>, SnapshotColumn<CPrevPosition>, SnapshotColumn<CRotation>,
+               SnapshotColumn<CScale>, SnapshotColumn<CMesh>, SnapshotColumn<CInventory>, SnapshotColumn<CCrafter>,
+               SnapshotColumn<CBelt>, SnapshotColumn<CPowerConsumer>, SnapshotColumn<CPowerProducer>,
+               SnapshotColumn<CPowerPole>, SnapshotColumn<TPlayerOwned>>
+                         columns;
+    std::vector<uint8_t> tail;      // lines, networks, then any other owner's sections
+
+    // Empty, keeping the buffers: a capture reused for the next save does
+    // not allocate (and fault in) its pools again
+    void clear() noexcept;
+    // Append the snapshot to out
+    void write(std::vector<uint8_t>& out) const;
+};
+
+// =====================================================================
+// Templates
+// =====================================================================
+
+template<typename T>
+void SnapshotColumn<T>::write(SnapshotWriter& out) const {
+    out.beginSection(tag);
+    out.write(static_cast<uint32_t>(entities.size()));
+    out.writeBytes(entities.data(), entities.size() * sizeof(entt::entity));
+    if constexpr (std::is_empty_v<T>) {
+        // Presence only
+    } else if constexpr (SnapshotCodec<T>::packed) {
+        out.writeBytes(values.data(), values.size() * sizeof(T));
+    } else {
+        for (const T& value : values) SnapshotCodec<T>::encode(out, value);
+    }
+    out.endSection();
+}
+
+template<typename T>
+bool SnapshotReader::column(entt::registry& registry, const SnapshotRemap& remap) {
+    const auto count = read<uint32_t>();
+    if (!ok() || count > remaining() / sizeof(entt::entity)) return false;
+
+    std::vector<entt::entity> entities(count);
+    readBytes(entities.data(), count * sizeof(entt::entity));
+
+    // Alive, without T yet and listed once: the bulk insert trusts its input
+    size_t last = 0;
+    for (const entt::entity e : entities) {
+        if (!registry.valid(e) || registry.all_of<T>(e)) return false;
+        last = std::max<size_t>(last, entt::to_entity(e));
+    }
+    std::vector<bool> seen(count ? last + 1 : 0);
+    for (const entt::entity e : entities) {
+        if (seen[entt::to_entity(e)]) return false;
+        seen[entt::to_entity(e)] = true;
+    }
+
+    if constexpr (std::is_empty_v<T>) {
+        registry.insert<T>(entities.begin(), entities.end());
+    } else {
+        std::vector<T> values(count);
+        if constexpr (SnapshotCodec<T>::packed)
+            readBytes(values.data(), count * sizeof(T));
+        else
+            for (T& value : values) SnapshotCodec<T>::decode(*this, value, remap);
+        if (!ok()) return false;
+        registry.insert<T>(entities.begin(), entities.end(), std::make_move_iterator(values.begin()));
+    }
+    return ok();
+}
+
+#endif
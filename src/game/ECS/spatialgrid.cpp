@@ -0,0 +1,215 @@
+#include "spatialgrid.h"
+#include "ecs.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+// =====================================================================
+// Buckets
+// =====================================================================
+
+int32_t SpatialGrid::bucketCoord(float v) noexcept {
+    return static_cast<int32_t>(std::floor(v / BUCKET_SIZE));
+}
+
+int64_t SpatialGrid::keyOf(int32_t bx, int32_t by) noexcept {
+    return (static_cast<int64_t>(bx) << 32) | static_cast<uint32_t>(by);
+}
+
+const std::vector<SpatialGrid::Entry>* SpatialGrid::bucket(int32_t bx, int32_t by) const noexcept {
+    auto it = m_buckets.find(keyOf(bx, by));
+    return it != m_buckets.end() ? &it->second : nullptr;
+}
+
+void SpatialGrid::insert(entt::entity e, float x, float y) {
+    const int32_t bx    = bucketCoord(x);
+    const int32_t by    = bucketCoord(y);
+    const int64_t key   = keyOf(bx, by);
+    const auto    index = entt::to_entity(e);
+    if (index >= m_bucketOf.size())
+        m_bucketOf.resize(index + 1, NO_BUCKET);
+
+    if (key != m_lastKey) {
+        m_lastKey    = key;
+        m_lastBucket = &m_buckets[key];
+    }
+    m_lastBucket->push_back({ e, x, y });
+    m_bucketOf[index] = key;
+    m_count++;
+
+    m_minBX = std::min(m_minBX, bx); m_maxBX = std::max(m_maxBX, bx);
+    m_minBY = std::min(m_minBY, by); m_maxBY = std::max(m_maxBY, by);
+}
+
+void SpatialGrid::erase(entt::entity e) {
+    const auto index = entt::to_entity(e);
+    if (index >= m_bucketOf.size() || m_bucketOf[index] == NO_BUCKET) return;
+
+    auto it = m_buckets.find(m_bucketOf[index]);
+    if (it != m_buckets.end()) {
+        auto& entries = it->second;
+        auto  entry   = std::find_if(entries.begin(), entries.end(), [&](const Entry& en) { return en.entity == e; });
+        if (entry != entries.end()) {
+            *entry = entries.back();
+            entries.pop_back();
+            m_count--;
+        }
+        if (entries.empty()) {
+            if (it->first == m_lastKey) m_lastKey = NO_BUCKET;
+            m_buckets.erase(it);
+        }
+    }
+    m_bucketOf[index] = NO_BUCKET;
+}
+
+// =====================================================================
+// Registry signals
+// =====================================================================
+
+void SpatialGrid::connect(entt::registry& registry) {
+    clear();
+    for (auto [e, pos] : registry.view<const CPosition>().each())
+        insert(e, pos.x, pos.y);
+
+    registry.on_construct<CPosition>().connect<&SpatialGrid::onConstruct>(*this);
+    registry.on_update<CPosition>().connect<&SpatialGrid::onUpdate>(*this);
+    registry.on_destroy<CPosition>().connect<&SpatialGrid::onDestroy>(*this);
+}
+
+void SpatialGrid::disconnect(entt::registry& registry) {
+    registry.on_construct<CPosition>().disconnect<&SpatialGrid::onConstruct>(*this);
+    registry.on_update<CPosition>().disconnect<&SpatialGrid::onUpdate>(*this);
+    registry.on_destroy<CPosition>().disconnect<&SpatialGrid::onDestroy>(*this);
+}
+
+void SpatialGrid::clear() noexcept {
+    m_buckets.clear();
+    m_bucketOf.clear();
+    m_count = 0;
+    m_lastKey = NO_BUCKET;
+    m_lastBucket = nullptr;
+    m_minBX = m_minBY = INT32_MAX;
+    m_maxBX = m_maxBY = INT32_MIN;
+}
+
+void SpatialGrid::onConstruct(entt::registry& registry, entt::entity e) {
+    const auto& pos = registry.get<CPosition>(e);
+    insert(e, pos.x, pos.y);
+}
+
+void SpatialGrid::onUpdate(entt::registry& registry, entt::entity e) {
+    const auto& pos   = registry.get<CPosition>(e);
+    const auto  index = entt::to_entity(e);
+    const int64_t key = keyOf(bucketCoord(pos.x), bucketCoord(pos.y));
+
+    // Same bucket: refresh the cached coordinates in place
+    if (index < m_bucketOf.size() && m_bucketOf[index] == key) {
+        for (auto& entry : m_buckets[key])
+            if (entry.entity == e) { entry.x = pos.x; entry.y = pos.y; return; }
+    }
+    erase(e);
+    insert(e, pos.x, pos.y);
+}
+
+void SpatialGrid::onDestroy(entt::registry&, entt::entity e) {
+    erase(e);
+}
+
+// =====================================================================
+// Queries
+// =====================================================================
+
+std::optional<entt::entity> SpatialGrid::at(float x, float y) const noexcept {
+    std::optional<entt::entity> best;
+    float                       bestDist = std::numeric_limits<float>::max();
+
+    for (int32_t by = bucketCoord(y - 0.5f); by <= bucketCoord(y + 0.5f); by++)
+        for (int32_t bx = bucketCoord(x - 0.5f); bx <= bucketCoord(x + 0.5f); bx++) {
+            const auto* entries = bucket(bx, by);
+            if (!entries) continue;
+            for (const Entry& en : *entries) {
+                const float dx = std::abs(en.x - x);
+                const float dy = std::abs(en.y - y);
+                if (dx >= 0.5f || dy >= 0.5f) continue;
+
+                const float dist = dx * dx + dy * dy;
+                if (dist < bestDist || (dist == bestDist && en.entity < *best)) {
+                    best     = en.entity;
+                    bestDist = dist;
+                }
+            }
+        }
+    return best;
+}
+
+void SpatialGrid::query(float minX, float minY, float maxX, float maxY, std::vector<entt::entity>& out) const {
+    out.clear();
+    for (int32_t by = bucketCoord(minY); by <= bucketCoord(maxY); by++)
+        for (int32_t bx = bucketCoord(minX); bx <= bucketCoord(maxX); bx++) {
+            const auto* entries = bucket(bx, by);
+            if (!entries) continue;
+            for (const Entry& en : *entries)
+                if (en.x >= minX && en.x <= maxX && en.y >= minY && en.y <= maxY)
+                    out.push_back(en.entity);
+        }
+}
+
+void SpatialGrid::nearest(float x, float y, size_t k, float maxRadius, std::vector<entt::entity>& out) const {
+    out.clear();
+    if (k == 0 || m_count == 0) return;
+
+    struct Candidate {
+        float        dist2;
+        entt::entity entity;
+    };
+    std::vector<Candidate> found;
+
+    const int32_t cx       = bucketCoord(x);
+    const int32_t cy       = bucketCoord(y);
+    const float   maxDist2 = maxRadius * maxRadius;
+
+    // Stop at the radius or once every used bucket is covered, whichever is first
+    const int64_t coverAll = std::max({ int64_t(cx) - m_minBX, int64_t(m_maxBX) - cx,
+                                        int64_t(cy) - m_minBY, int64_t(m_maxBY) - cy, int64_t(0) });
+    const int     maxRing  = static_cast<int>(std::min<double>(coverAll, std::ceil(maxRadius / BUCKET_SIZE) + 1.0));
+
+    auto visit = [&](int32_t bx, int32_t by) {
+        const auto* entries = bucket(bx, by);
+        if (!entries) return;
+        for (const Entry& en : *entries) {
+            const float d2 = (en.x - x) * (en.x - x) + (en.y - y) * (en.y - y);
+            if (d2 <= maxDist2)
+                found.push_back({ d2, en.entity });
+        }
+    };
+
+    for (int r = 0; r <= maxRing; r++) {
+        if (r == 0) {
+            visit(cx, cy);
+        } else {
+            for (int i = -r; i <= r; i++) {
+                visit(cx + i, cy - r);
+                visit(cx + i, cy + r);
+            }
+            for (int i = -r + 1; i < r; i++) {
+                visit(cx - r, cy + i);
+                visit(cx + r, cy + i);
+            }
+        }
+
+        // Ring r + 1 is at least r whole buckets away from the query point
+        if (found.size() >= k) {
+            std::nth_element(found.begin(), found.begin() + (k - 1), found.end(),
+                             [](const Candidate& a, const Candidate& b) { return a.dist2 < b.dist2; });
+            const float reach = static_cast<float>(r * BUCKET_SIZE);
+            if (found[k - 1].dist2 <= reach * reach) break;
+        }
+    }
+
+    std::sort(found.begin(), found.end(), [](const Candidate& a, const Candidate& b) {
+        return a.dist2 < b.dist2 || (a.dist2 == b.dist2 && a.entity < b.entity);
+    });
+    for (size_t i = 0; i < found.size() && i < k; i++)
+        out.push_back(found[i].entity);
+}
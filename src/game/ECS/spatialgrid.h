@@ -0,0 +1,81 @@
+#pragma once
+
+#ifndef SPATIALGRID_H
+#define SPATIALGRID_H
+
+#include <entt/entt.hpp>
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+// =====================================================================
+// SpatialGrid — entities bucketed by tile cell
+// =====================================================================
+// Positions are bucketed into BUCKET_SIZE x BUCKET_SIZE tile cells held in a
+// hash map, each bucket storing (entity, x, y) so queries never touch the
+// registry. Kept in sync with CPosition through the registry's
+// construct / update / destroy signals: positions must be changed through
+// registry.patch / replace (ECSWorld::move), not by writing the component.
+class SpatialGrid {
+public:
+    static constexpr int BUCKET_SIZE = 8;
+
+    SpatialGrid() = default;
+
+    SpatialGrid(const SpatialGrid&)            = delete;
+    SpatialGrid& operator=(const SpatialGrid&) = delete;
+
+    // Index every existing CPosition and follow its signals
+    void connect(entt::registry& registry);
+    void disconnect(entt::registry& registry);
+    void clear() noexcept;
+
+    // CPosition listeners
+    void onConstruct(entt::registry& registry, entt::entity e);
+    void onUpdate   (entt::registry& registry, entt::entity e);
+    void onDestroy  (entt::registry& registry, entt::entity e);
+
+    // Entity within 0.5 units of (x, y) on both axes, the closest one wins
+    [[nodiscard]] std::optional<entt::entity> at(float x, float y) const noexcept;
+
+    // Every entity with minX <= x <= maxX and minY <= y <= maxY
+    void query(float minX, float minY, float maxX, float maxY, std::vector<entt::entity>& out) const;
+
+    // Up to k entities closest to (x, y) within maxRadius, nearest first
+    void nearest(float x, float y, size_t k, float maxRadius, std::vector<entt::entity>& out) const;
+
+    [[nodiscard]] size_t size() const noexcept { return m_count; }
+
+private:
+    struct Entry {
+        entt::entity entity;
+        float        x;
+        float        y;
+    };
+
+    static constexpr int64_t NO_BUCKET = INT64_MIN;
+
+    std::unordered_map<int64_t, std::vector<Entry>> m_buckets;
+    std::vector<int64_t>                            m_bucketOf;    // by entity index
+    size_t                                          m_count = 0;
+
+    // Bucket of the last insert: runs of neighbours (belt lines, bulk
+    // loads) skip the lookup. Map nodes are stable, reset on erase
+    int64_t             m_lastKey    = NO_BUCKET;
+    std::vector<Entry>* m_lastBucket = nullptr;
+
+    // Bucket coords ever used (grow only), bounds the ring search
+    int32_t m_minBX = INT32_MAX, m_minBY = INT32_MAX;
+    int32_t m_maxBX = INT32_MIN, m_maxBY = INT32_MIN;
+
+    [[nodiscard]] static int32_t bucketCoord(float v) noexcept;
+    [[nodiscard]] static int64_t keyOf(int32_t bx, int32_t by) noexcept;
+
+    [[nodiscard]] const std::vector<Entry>* bucket(int32_t bx, int32_t by) const noexcept;
+
+    void insert(entt::entity e, float x, float y);
+    void erase (entt::entity e);
+};
+
+#endif
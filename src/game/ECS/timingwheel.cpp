@@ -0,0 +1,70 @@
+#include "timingwheel.h"
+
+#include <algorithm>
+
+// =====================================================================
+// Scheduling
+// =====================================================================
+
+void TimingWheel::schedule(entt::entity e, uint64_t due) {
+    insert({ e, std::max(due, m_now + 1) });
+    m_count++;
+}
+
+// Lowest level whose current block contains due; the slot is strictly ahead
+// of the clock on that level, so it comes up exactly when due's block starts
+void TimingWheel::insert(const Timer& timer) {
+    for (int level = 0; level < LEVELS; level++) {
+        const int shift = SLOT_BITS * (level + 1);
+        if ((timer.due >> shift) == (m_now >> shift)) {
+            const auto slot = (timer.due >> (SLOT_BITS * level)) & (SLOTS - 1);
+            m_levels[level][slot].push_back(timer);
+            return;
+        }
+    }
+    m_overflow.push_back(timer);
+}
+
+void TimingWheel::cascade(Slot& slot) {
+    // Swap out first: insert may target this same slot's level
+    Slot timers;
+    timers.swap(slot);
+    for (const Timer& timer : timers)
+        insert(timer);
+
+    // Hand the capacity back so the slot does not reallocate next round
+    timers.clear();
+    if (slot.empty()) slot.swap(timers);
+}
+
+// =====================================================================
+// Clock
+// =====================================================================
+
+void TimingWheel::step(std::vector<Timer>& out) {
+    m_now++;
+
+    // Entering a new block on level n: pull its slot down, highest first
+    constexpr uint64_t TOP_MASK = (uint64_t(1) << (SLOT_BITS * LEVELS)) - 1;
+    if ((m_now & TOP_MASK) == 0)
+        cascade(m_overflow);
+    for (int level = LEVELS - 1; level > 0; level--) {
+        const uint64_t mask = (uint64_t(1) << (SLOT_BITS * level)) - 1;
+        if ((m_now & mask) == 0)
+            cascade(m_levels[level][(m_now >> (SLOT_BITS * level)) & (SLOTS - 1)]);
+    }
+
+    Slot& due = m_levels[0][m_now & (SLOTS - 1)];
+    out.insert(out.end(), due.begin(), due.end());
+    m_count -= due.size();
+    due.clear();
+}
+
+void TimingWheel::reset(uint64_t now) noexcept {
+    for (auto& level : m_levels)
+        for (auto& slot : level)
+            slot.clear();
+    m_overflow.clear();
+    m_now   = now;
+    m_count = 0;
+}
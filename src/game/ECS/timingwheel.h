@@ -0,0 +1,60 @@
+#pragma once
+
+#ifndef TIMINGWHEEL_H
+#define TIMINGWHEEL_H
+
+#include <entt/entt.hpp>
+#include <array>
+#include <cstdint>
+#include <vector>
+
+// =====================================================================
+// TimingWheel — hierarchical wheel of entity timers, in simulation ticks
+// =====================================================================
+// LEVELS wheels of SLOTS slots each: level 0 holds timers due within the
+// current 256-tick block, one slot per tick; level n holds timers due within
+// the current 256^(n+1) block, one slot per 256^n ticks. A slot is cascaded
+// down when the clock enters its block, so every timer is touched O(LEVELS)
+// times and an advance costs O(1) per tick plus the timers that fire.
+// Timers past the top level wait in an overflow list.
+//
+// Timers cannot be cancelled: owners check a fired timer against their own
+// state (e.g. CCrafter::finishTick) and ignore stale ones.
+class TimingWheel {
+public:
+    static constexpr int      LEVELS    = 4;
+    static constexpr int      SLOT_BITS = 8;
+    static constexpr uint32_t SLOTS     = 1u << SLOT_BITS;
+
+    struct Timer {
+        entt::entity entity;
+        uint64_t     due;
+    };
+
+    explicit TimingWheel(uint64_t now = 0) noexcept : m_now(now) {}
+
+    // Fire for e at tick due, clamped to the next tick
+    void schedule(entt::entity e, uint64_t due);
+
+    // Move the clock forward one tick, appending the timers due on it to out
+    void step(std::vector<Timer>& out);
+
+    // Drop every timer and restart the clock at now
+    void reset(uint64_t now = 0) noexcept;
+
+    [[nodiscard]] uint64_t now()  const noexcept { return m_now; }
+    [[nodiscard]] size_t   size() const noexcept { return m_count; }
+
+private:
+    using Slot = std::vector<Timer>;
+
+    std::array<std::array<Slot, SLOTS>, LEVELS> m_levels;
+    Slot                                        m_overflow;
+    uint64_t                                    m_now   = 0;
+    size_t                                      m_count = 0;
+
+    void insert(const Timer& timer);
+    void cascade(Slot& slot);
+};
+
+#endif
@@ -0,0 +1,611 @@
+#include "transportline.h"
+#include "ecs.h"
+#include "snapshot.h"
+#include "spatialgrid.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+static void directionStep(Direction dir, int32_t& dx, int32_t& dy) noexcept {
+    dx = (dir == Direction::East)  ? 1 : (dir == Direction::West)  ? -1 : 0;
+    dy = (dir == Direction::North) ? 1 : (dir == Direction::South) ? -1 : 0;
+}
+
+static void tileOf(const CPosition& pos, int32_t& x, int32_t& y) noexcept {
+    x = static_cast<int32_t>(std::lround(pos.x));
+    y = static_cast<int32_t>(std::lround(pos.y));
+}
+
+// =====================================================================
+// TransportLine
+// =====================================================================
+
+uint32_t TransportLine::lengthUnits() const noexcept {
+    return length * TransportLines::TILE_UNITS;
+}
+
+int TransportLine::tileIndex(int32_t x, int32_t y) const noexcept {
+    int32_t dx, dy;
+    directionStep(direction, dx, dy);
+    if (dx != 0 ? y != startY : x != startX) return -1;
+
+    const int64_t i = int64_t(x - startX) * dx + int64_t(y - startY) * dy;
+    return (i >= 0 && i < length) ? static_cast<int>(i) : -1;
+}
+
+void TransportLine::tileAt(uint32_t i, int32_t& x, int32_t& y) const noexcept {
+    int32_t dx, dy;
+    directionStep(direction, dx, dy);
+    x = startX + dx * static_cast<int32_t>(i);
+    y = startY + dy * static_cast<int32_t>(i);
+}
+
+void TransportLine::outputTile(int32_t& x, int32_t& y) const noexcept {
+    tileAt(length, x, y);
+}
+
+// =====================================================================
+// Item encoding
+// =====================================================================
+
+void TransportLines::decode(const TransportLine& line, uint32_t offset, std::vector<Placed>& out) {
+    uint32_t pos = 0;
+    for (uint32_t i = line.head; i < line.items.size(); i++) {
+        pos += line.items[i].gap + (i == line.head ? 0 : ITEM_SPACING);
+        out.push_back({ line.items[i].item, pos + offset });
+    }
+}
+
+// placed must be sorted head first. Items pushed past the start of the line
+// to keep their spacing are dropped
+void TransportLines::encode(TransportLine& line, std::span<const Placed> placed) {
+    line.items.clear();
+    line.head = 0;
+    line.tail = 0;
+
+    uint32_t prev = 0;
+    for (const Placed& p : placed) {
+        const bool     first = line.items.empty();
+        const uint32_t pos   = first ? p.pos : std::max(p.pos, prev + ITEM_SPACING);
+        if (pos > line.lengthUnits()) break;
+
+        line.items.push_back({ p.item, first ? pos : pos - prev - ITEM_SPACING });
+        prev = pos;
+    }
+    line.tail = prev;
+
+    line.active = 0;
+    while (line.active < line.items.size() && line.items[line.active].gap == 0)
+        line.active++;
+}
+
+void TransportLines::advance(TransportLine& line, uint32_t move) noexcept {
+    while (move > 0 && line.active < line.items.size()) {
+        uint32_t&      gap = line.items[line.active].gap;
+        const uint32_t d   = std::min(gap, move);
+        gap -= d;
+        move -= d;
+        line.tail -= d;
+        if (gap == 0) line.active++;
+    }
+    // Items already compressed behind it stop too: active stays the whole
+    // gap 0 prefix, which snapshots check
+    while (line.active < line.items.size() && line.items[line.active].gap == 0)
+        line.active++;
+}
+
+void TransportLines::popHead(TransportLine& line) noexcept {
+    line.head++;
+    if (line.head == line.items.size()) {
+        line.items.clear();
+        line.head = line.active = line.tail = 0;
+        return;
+    }
+
+    // The new head was measured against the old one, which sat at the end
+    line.items[line.head].gap += ITEM_SPACING;
+    line.active = line.head;
+
+    // Drop the consumed prefix once it dominates the buffer
+    if (line.head >= 64 && line.head * 2 >= line.items.size()) {
+        line.items.erase(line.items.begin(), line.items.begin() + line.head);
+        line.active -= line.head;
+        line.head = 0;
+    }
+}
+
+bool TransportLines::insert(LineId id, int32_t x, int32_t y, ItemId item, bool sideLoad) {
+    TransportLine& line = m_lines[id];
+    const int      k    = line.tileIndex(x, y);
+    if (k < 0) return false;
+
+    const uint32_t pos = (line.length - k) * TILE_UNITS - (sideLoad ? TILE_UNITS / 2 : 0);
+
+    // Fast path: behind the last item, the usual feed at the start of a line
+    if (line.head == line.items.size()) {
+        line.items.clear();
+        line.items.push_back({ item, pos });
+        line.head   = 0;
+        line.active = pos > 0 ? 0 : 1;
+        line.tail   = pos;
+        return true;
+    }
+    if (pos >= line.tail) {
+        if (pos - line.tail < ITEM_SPACING) return false;
+        const bool     noneActive = line.active == line.items.size();
+        const uint32_t gap        = pos - line.tail - ITEM_SPACING;
+        line.items.push_back({ item, gap });
+        if (noneActive && gap == 0) line.active = static_cast<uint32_t>(line.items.size());
+        line.tail = pos;
+        return true;
+    }
+
+    // Between two items: find the first one behind pos
+    uint32_t ahead = 0, cur = 0;
+    uint32_t i     = line.head;
+    for (; i < line.items.size(); i++) {
+        cur += line.items[i].gap + (i == line.head ? 0 : ITEM_SPACING);
+        if (cur > pos) break;
+        ahead = cur;
+    }
+    const bool hasAhead = i > line.head;
+    if ((hasAhead && pos - ahead < ITEM_SPACING) || cur - pos < ITEM_SPACING) return false;
+
+    line.items[i].gap = cur - pos - ITEM_SPACING;
+    line.items.insert(line.items.begin() + i, { item, hasAhead ? pos - ahead - ITEM_SPACING : pos });
+
+    line.active = line.head;
+    while (line.active < line.items.size() && line.items[line.active].gap == 0)
+        line.active++;
+    return true;
+}
+
+size_t TransportLines::itemCount() const noexcept {
+    size_t count = 0;
+    for (const auto& line : m_lines)
+        count += line.itemCount();
+    return count;
+}
+
+// =====================================================================
+// Line slots
+// =====================================================================
+
+LineId TransportLines::allocate() {
+    if (!m_free.empty()) {
+        const LineId id = m_free.back();
+        m_free.pop_back();
+        return id;
+    }
+    m_lines.emplace_back();
+    return static_cast<LineId>(m_lines.size() - 1);
+}
+
+void TransportLines::release(LineId id) {
+    m_lines[id] = TransportLine{};
+    m_free.push_back(id);
+    m_orderDirty = true;
+}
+
+void TransportLines::relabel(entt::registry& registry, LineId id) {
+    for (const entt::entity e : m_lines[id].belts)
+        registry.get<CBelt>(e).line = id;
+}
+
+void TransportLines::clear() noexcept {
+    m_lines.clear();
+    m_free.clear();
+    m_order.clear();
+    m_orderDirty = true;
+}
+
+LineId TransportLines::lineAt(const entt::registry& registry, const SpatialGrid& grid, int32_t x, int32_t y,
+                              Direction dir, float speed) const {
+    const auto e = grid.at(static_cast<float>(x), static_cast<float>(y));
+    if (!e) return INVALID_LINE;
+    const auto* belt = registry.try_get<CBelt>(*e);
+    if (!belt || belt->direction != dir || belt->speed != speed) return INVALID_LINE;
+    return belt->line;
+}
+
+// =====================================================================
+// Output targets
+// =====================================================================
+
+void TransportLines::invalidate(LineId id) noexcept {
+    m_lines[id].output = LineOutput::Unresolved;
+    m_lines[id].target = entt::null;
+    m_orderDirty       = true;
+}
+
+void TransportLines::invalidateAround(const entt::registry& registry, const SpatialGrid& grid, int32_t x, int32_t y) {
+    for (const Direction dir : { Direction::North, Direction::East, Direction::South, Direction::West }) {
+        int32_t dx, dy;
+        directionStep(dir, dx, dy);
+        const auto e = grid.at(static_cast<float>(x - dx), static_cast<float>(y - dy));
+        if (!e) continue;
+        const auto* belt = registry.try_get<CBelt>(*e);
+        if (!belt || belt->direction != dir || belt->line == INVALID_LINE) continue;
+        if (m_lines[belt->line].belts.back() == *e)
+            invalidate(belt->line);
+    }
+    m_orderDirty = true;
+}
+
+void TransportLines::resolve(const entt::registry& registry, const SpatialGrid& grid, TransportLine& line) const {
+    int32_t x, y;
+    line.outputTile(x, y);
+    line.output   = LineOutput::None;
+    line.target   = entt::null;
+    line.sideLoad = false;
+
+    const auto e = grid.at(static_cast<float>(x), static_cast<float>(y));
+    if (!e) return;
+
+    if (const auto* next = registry.try_get<CBelt>(*e)) {
+        const int turn = (static_cast<int>(next->direction) - static_cast<int>(line.direction) + 4) % 4;
+        if (turn == 2 || next->line == INVALID_LINE) return;    // belts facing each other
+        line.output   = LineOutput::Belt;
+        line.sideLoad = turn != 0;
+        line.target   = *e;
+    } else if (registry.all_of<CInventory>(*e)) {
+        line.output = LineOutput::Inventory;
+        line.target = *e;
+    }
+}
+
+// Lines only feed one line each, so the graph is a forest of in-trees
+// (plus loops): order by distance to the line a chain drains into
+void TransportLines::rebuildOrder(const entt::registry& registry, const SpatialGrid& grid) {
+    constexpr uint8_t UNSEEN = 0, OPEN = 1, DONE = 2;
+    const size_t      count  = m_lines.size();
+
+    std::vector<uint32_t> depth(count, 0);
+    m_visit.assign(count, UNSEEN);
+
+    for (auto& line : m_lines)
+        if (line.length > 0 && line.output == LineOutput::Unresolved)
+            resolve(registry, grid, line);
+
+    auto next = [&](LineId id) -> LineId {
+        const TransportLine& line = m_lines[id];
+        if (line.output != LineOutput::Belt || !registry.valid(line.target)) return INVALID_LINE;
+        return registry.get<CBelt>(line.target).line;
+    };
+
+    std::vector<LineId> chain;
+    uint32_t            maxDepth = 0;
+    for (LineId id = 0; id < count; id++) {
+        if (m_lines[id].length == 0 || m_visit[id] != UNSEEN) continue;
+
+        // Walk down to a sink, a finished line or a loop, then unwind
+        chain.clear();
+        LineId cur = id;
+        while (cur != INVALID_LINE && m_visit[cur] == UNSEEN) {
+            m_visit[cur] = OPEN;
+            chain.push_back(cur);
+            cur = next(cur);
+        }
+        uint32_t d = (cur != INVALID_LINE && m_visit[cur] == DONE) ? depth[cur] + 1 : 0;
+        for (auto it = chain.rbegin(); it != chain.rend(); ++it, d++) {
+            depth[*it]   = d;
+            m_visit[*it] = DONE;
+            maxDepth     = std::max(maxDepth, d);
+        }
+    }
+
+    // Counting sort by depth, sinks first
+    std::vector<uint32_t> start(maxDepth + 2, 0);
+    for (LineId id = 0; id < count; id++)
+        if (m_lines[id].length > 0) start[depth[id] + 1]++;
+    for (size_t d = 1; d < start.size(); d++)
+        start[d] += start[d - 1];
+
+    m_order.assign(start.back(), INVALID_LINE);
+    for (LineId id = 0; id < count; id++)
+        if (m_lines[id].length > 0) m_order[start[depth[id]]++] = id;
+
+    m_orderDirty = false;
+}
+
+bool TransportLines::pushToBelt(const entt::registry& registry, TransportLine& line, ItemId item) {
+    if (!registry.valid(line.target)) {
+        invalidate(static_cast<LineId>(&line - m_lines.data()));
+        return false;
+    }
+    const LineId next = registry.get<CBelt>(line.target).line;
+    if (next == INVALID_LINE) return false;
+
+    int32_t x, y;
+    line.outputTile(x, y);
+    return insert(next, x, y, item, line.sideLoad);
+}
+
+// =====================================================================
+// Registry signals
+// =====================================================================
+
+void TransportLines::connect(entt::registry& registry, const SpatialGrid& grid) {
+    m_grid = &grid;
+    registry.on_construct<CInventory>().connect<&TransportLines::onInventoryChanged>(*this);
+    registry.on_destroy<CInventory>().connect<&TransportLines::onInventoryChanged>(*this);
+}
+
+void TransportLines::disconnect(entt::registry& registry) {
+    registry.on_construct<CInventory>().disconnect<&TransportLines::onInventoryChanged>(*this);
+    registry.on_destroy<CInventory>().disconnect<&TransportLines::onInventoryChanged>(*this);
+    m_grid = nullptr;
+}
+
+// A building appeared or went away: re-resolve the lines pointing at its tile
+void TransportLines::onInventoryChanged(entt::registry& registry, entt::entity e) {
+    const auto* pos = registry.try_get<CPosition>(e);
+    if (!pos || !m_grid) return;
+    int32_t x, y;
+    tileOf(*pos, x, y);
+    invalidateAround(registry, *m_grid, x, y);
+}
+
+// =====================================================================
+// Edits
+// =====================================================================
+
+void TransportLines::addBelt(entt::registry& registry, const SpatialGrid& grid, entt::entity e) {
+    auto&   belt = registry.get<CBelt>(e);
+    int32_t x, y, dx, dy;
+    tileOf(registry.get<CPosition>(e), x, y);
+    directionStep(belt.direction, dx, dy);
+
+    // Line ending right behind this tile, line starting right in front of it
+    LineId up = lineAt(registry, grid, x - dx, y - dy, belt.direction, belt.speed);
+    if (up != INVALID_LINE && m_lines[up].tileIndex(x - dx, y - dy) != int(m_lines[up].length) - 1)
+        up = INVALID_LINE;
+    LineId down = lineAt(registry, grid, x + dx, y + dy, belt.direction, belt.speed);
+    if (down != INVALID_LINE && m_lines[down].tileIndex(x + dx, y + dy) != 0)
+        down = INVALID_LINE;
+
+    if (up == INVALID_LINE && down == INVALID_LINE) {
+        const LineId   id   = allocate();
+        TransportLine& line = m_lines[id];
+        line.startX    = x;
+        line.startY    = y;
+        line.direction = belt.direction;
+        line.speed     = belt.speed;
+        line.length    = 1;
+        line.belts.push_back(e);
+        belt.line = id;
+    } else if (down == INVALID_LINE) {
+        // Extend downstream: the end moves one tile away from every item
+        TransportLine& line = m_lines[up];
+        line.length++;
+        line.belts.push_back(e);
+        if (line.head < line.items.size()) {
+            line.items[line.head].gap += TILE_UNITS;
+            line.tail += TILE_UNITS;
+            line.active = line.head;
+        }
+        belt.line = up;
+    } else if (up == INVALID_LINE) {
+        // Extend upstream: positions are measured from the end, nothing moves
+        TransportLine& line = m_lines[down];
+        line.startX = x;
+        line.startY = y;
+        line.length++;
+        line.belts.insert(line.belts.begin(), e);
+        belt.line = down;
+    } else {
+        // Bridge: fold the downstream line into the upstream one
+        TransportLine& upLine   = m_lines[up];
+        TransportLine& downLine = m_lines[down];
+
+        m_scratch.clear();
+        decode(downLine, 0, m_scratch);
+        decode(upLine, (downLine.length + 1) * TILE_UNITS, m_scratch);
+
+        upLine.length += 1 + downLine.length;
+        upLine.belts.push_back(e);
+        upLine.belts.insert(upLine.belts.end(), downLine.belts.begin(), downLine.belts.end());
+        encode(upLine, m_scratch);
+
+        release(down);
+        relabel(registry, up);
+    }
+
+    // The line's end may have moved, and lines ending next to this tile
+    // now point at a belt
+    invalidate(belt.line);
+    invalidateAround(registry, grid, x, y);
+}
+
+void TransportLines::removeBelt(entt::registry& registry, const SpatialGrid& grid, entt::entity e) {
+    auto& belt = registry.get<CBelt>(e);
+    if (belt.line == INVALID_LINE) return;
+
+    // Lines feeding this tile lose their target; the parts left behind
+    // start out unresolved
+    int32_t x, y;
+    tileOf(registry.get<CPosition>(e), x, y);
+    invalidateAround(registry, grid, x, y);
+
+    const LineId id = belt.line;
+    belt.line       = INVALID_LINE;
+
+    TransportLine& line = m_lines[id];
+    const auto     it   = std::find(line.belts.begin(), line.belts.end(), e);
+    if (it == line.belts.end()) return;
+
+    const uint32_t k          = static_cast<uint32_t>(it - line.belts.begin());
+    const uint32_t upLength   = k;
+    const uint32_t downLength = line.length - k - 1;
+    if (upLength == 0 && downLength == 0) {
+        release(id);
+        return;
+    }
+
+    // Downstream part: positions up to the removed tile's exit; upstream
+    // part: positions from its entry, shifted to the new end
+    m_scratch.clear();
+    decode(line, 0, m_scratch);
+    const uint32_t downUnits = downLength * TILE_UNITS;
+    const uint32_t upFrom    = (downLength + 1) * TILE_UNITS;
+    const auto     upBegin   = std::find_if(m_scratch.begin(), m_scratch.end(), [&](const Placed& p) { return p.pos >= upFrom; });
+    const auto     downEnd   = std::find_if(m_scratch.begin(), m_scratch.end(), [&](const Placed& p) { return p.pos > downUnits; });
+    for (auto p = upBegin; p != m_scratch.end(); ++p)
+        p->pos -= upFrom;
+
+    const auto upFirst   = static_cast<size_t>(upBegin - m_scratch.begin());
+    const auto downCount = static_cast<size_t>(downEnd - m_scratch.begin());
+    const std::span<const Placed> downItems(m_scratch.data(), downCount);
+    const std::span<const Placed> upItems(m_scratch.data() + upFirst, m_scratch.size() - upFirst);
+
+    // The longer part keeps the id, the shorter one gets a new line and is relabelled
+    const bool   keepDown = downLength >= upLength;
+    const LineId other    = (upLength > 0 && downLength > 0) ? allocate() : INVALID_LINE;   // may grow m_lines
+    TransportLine& old    = m_lines[id];
+
+    TransportLine up, down;
+    up.startX = old.startX;
+    up.startY = old.startY;
+    old.tileAt(k + 1, down.startX, down.startY);
+    for (TransportLine* part : { &up, &down }) {
+        part->direction = old.direction;
+        part->speed     = old.speed;
+    }
+    up.length   = upLength;
+    down.length = downLength;
+    up.belts.assign(old.belts.begin(), old.belts.begin() + k);
+    down.belts.assign(old.belts.begin() + k + 1, old.belts.end());
+    encode(up, upItems);
+    encode(down, downItems);
+
+    if (other == INVALID_LINE) {
+        old = std::move(upLength > 0 ? up : down);
+        return;
+    }
+    m_lines[id]    = std::move(keepDown ? down : up);
+    m_lines[other] = std::move(keepDown ? up : down);
+    relabel(registry, other);
+}
+
+// =====================================================================
+// Snapshots
+// =====================================================================
+// [u32 slots][u32 free][free ids], then per slot
+// [i32 startX][i32 startY][u8 direction][f32 speed][f32 carry][u32 length]
+// and for live lines [u32 items][u32 active][u32 tail][items][u32 belts][belts].
+// Items are written from the head, the consumed prefix is dropped
+
+void TransportLines::save(SnapshotWriter& out) const {
+    out.write(static_cast<uint32_t>(m_lines.size()));
+    out.write(static_cast<uint32_t>(m_free.size()));
+    out.writeBytes(m_free.data(), m_free.size() * sizeof(LineId));
+
+    // Items are most of the section: packed here, written once per line
+    std::vector<uint8_t> packed;
+    for (const TransportLine& line : m_lines) {
+        out.write(line.startX);
+        out.write(line.startY);
+        out.write(static_cast<uint8_t>(line.direction));
+        out.write(line.speed);
+        out.write(line.carry);
+        out.write(line.length);
+        if (line.length == 0) continue;
+
+        out.write(static_cast<uint32_t>(line.itemCount()));
+        out.write(line.active - line.head);
+        out.write(line.tail);
+        packed.resize(line.itemCount() * (sizeof(ItemId) + sizeof(uint32_t)));
+        uint8_t* at = packed.data();
+        for (uint32_t i = line.head; i < line.items.size(); i++) {
+            std::memcpy(at, &line.items[i].item, sizeof(ItemId));
+            std::memcpy(at + sizeof(ItemId), &line.items[i].gap, sizeof(uint32_t));
+            at += sizeof(ItemId) + sizeof(uint32_t);
+        }
+        out.writeBytes(packed.data(), packed.size());
+        out.write(static_cast<uint32_t>(line.belts.size()));
+        out.writeBytes(line.belts.data(), line.belts.size() * sizeof(entt::entity));
+    }
+}
+
+bool TransportLines::load(SnapshotReader& in, const entt::registry& registry, const SnapshotRemap& remap) {
+    // Smallest slot and item records, bound the counts before allocating
+    constexpr size_t SLOT_BYTES = 21;
+    constexpr size_t ITEM_BYTES = 6;
+    clear();
+
+    const auto slots = in.read<uint32_t>();
+    const auto free  = in.read<uint32_t>();
+    if (!in.ok() || free > slots || slots > in.remaining() / SLOT_BYTES) return false;
+
+    m_lines.resize(slots);
+    m_free.resize(free);
+    in.readBytes(m_free.data(), free * sizeof(LineId));
+
+    for (LineId id = 0; id < slots && in.ok(); id++) {
+        TransportLine& line = m_lines[id];
+        line.startX         = in.read<int32_t>();
+        line.startY         = in.read<int32_t>();
+        line.direction      = static_cast<Direction>(in.read<uint8_t>() & 3);
+        line.speed          = in.read<float>();
+        line.carry          = in.read<float>();
+        line.length         = in.read<uint32_t>();
+        if (line.length == 0) continue;
+
+        const auto items = in.read<uint32_t>();
+        line.active      = in.read<uint32_t>();
+        line.tail        = in.read<uint32_t>();
+        if (items > in.remaining() / ITEM_BYTES || line.active > items) return false;
+        line.items.resize(items);
+        for (LineItem& item : line.items) {
+            item.item = remap.item(in.read<ItemId>());
+            item.gap  = in.read<uint32_t>();
+        }
+
+        // tail and active follow from the gaps, insert and advance index
+        // items by them: both must match and every item be on the line
+        uint64_t pos        = 0;
+        uint32_t compressed = 0;
+        for (uint32_t i = 0; i < items; i++) {
+            pos += line.items[i].gap + (i == 0 ? 0 : ITEM_SPACING);
+            if (pos > uint64_t(line.length) * TILE_UNITS) return false;
+        }
+        while (compressed < items && line.items[compressed].gap == 0)
+            compressed++;
+        if (pos != line.tail || compressed != line.active) return false;
+
+        const auto belts = in.read<uint32_t>();
+        if (belts != line.length || belts > in.remaining() / sizeof(entt::entity)) return false;
+        line.belts.resize(belts);
+        in.readBytes(line.belts.data(), belts * sizeof(entt::entity));
+        for (const entt::entity e : line.belts) {
+            const auto* belt = registry.valid(e) ? registry.try_get<CBelt>(e) : nullptr;
+            if (!belt || belt->line != id) return false;
+        }
+    }
+    // Listed once each, allocate would hand a repeated slot out twice
+    std::vector<bool> freed(slots);
+    for (const LineId id : m_free) {
+        if (id >= slots || m_lines[id].length != 0 || freed[id]) return false;
+        freed[id] = true;
+    }
+
+    m_orderDirty = true;
+    return in.ok();
+}
+
+bool TransportLines::checkBelts(const entt::registry& registry) const {
+    for (auto [e, belt] : registry.view<const CBelt>().each()) {
+        if (belt.line == INVALID_LINE) continue;
+        if (belt.line >= m_lines.size() || m_lines[belt.line].length == 0) return false;
+
+        const auto* pos = registry.try_get<CPosition>(e);
+        if (!pos) return false;
+        int32_t x, y;
+        tileOf(*pos, x, y);
+        const TransportLine& line = m_lines[belt.line];
+        const int            k    = line.tileIndex(x, y);
+        if (k < 0 || line.belts[k] != e) return false;
+    }
+    return true;
+}
@@ -0,0 +1,222 @@
+#pragma once
+
+#ifndef TRANSPORTLINE_H
+#define TRANSPORTLINE_H
+
+#include <entt/entt.hpp>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+class SpatialGrid;
+class SnapshotWriter;
+class SnapshotReader;
+struct SnapshotRemap;
+enum class Direction;
+
+using ItemId = uint16_t;
+using LineId = uint32_t;
+inline constexpr LineId INVALID_LINE = 0xFFFFFFFFu;
+
+// =====================================================================
+// TransportLine — a straight run of belts simulated as one object
+// =====================================================================
+// Positions are fixed point, TILE_UNITS per tile, measured backwards from
+// the line's downstream end. Items are gap encoded, head first: the head's
+// gap is its distance to the end, every other item's gap is the free space
+// to the item ahead of it beyond ITEM_SPACING.
+//
+// Items ahead of `active` are compressed (gap 0) behind a blocked head, so
+// advancing the line only shrinks items[active].gap: everything behind it
+// moves along without being touched.
+struct LineItem {
+    ItemId   item = 0;
+    uint32_t gap  = 0;
+};
+
+// What a line's head item is handed to, cached until the tile past the end
+// of the line or the line itself is edited
+enum class LineOutput : uint8_t { Unresolved, None, Belt, Inventory };
+
+struct TransportLine {
+    int32_t   startX    = 0;        // tile of the upstream-most belt
+    int32_t   startY    = 0;
+    Direction direction = {};
+    float     speed     = 1.0f;     // tiles/second
+    float     carry     = 0.0f;     // sub-unit movement left from the last tick
+
+    uint32_t  length    = 0;        // tiles, 0 for a free slot
+    uint32_t  head      = 0;        // items[head] is the frontmost live item
+    uint32_t  active    = 0;        // items before it are compressed (gap 0)
+    uint32_t  tail      = 0;        // position of the last item
+
+    LineOutput   output   = LineOutput::Unresolved;
+    bool         sideLoad = false;       // Belt output enters the target mid-tile
+    entt::entity target   = entt::null;  // belt or building past the end
+
+    std::vector<LineItem>     items;
+    std::vector<entt::entity> belts;    // start to end
+
+    [[nodiscard]] uint32_t lengthUnits() const noexcept;
+    [[nodiscard]] size_t   itemCount()   const noexcept { return items.size() - head; }
+    // Tile index from the start, -1 if (x, y) is not on the line
+    [[nodiscard]] int      tileIndex(int32_t x, int32_t y) const noexcept;
+    // Tile at index i from the start
+    void tileAt(uint32_t i, int32_t& x, int32_t& y) const noexcept;
+    // Tile the head item is handed to
+    void outputTile(int32_t& x, int32_t& y) const noexcept;
+};
+
+// =====================================================================
+// TransportLines — every line, split and merged as belts are edited
+// =====================================================================
+// A belt joins the line that ends right behind it or starts right in front
+// of it (same direction and speed), merging the two when it bridges them.
+// Removing a belt splits its line, items on the removed tile are lost.
+// CBelt::line is kept pointing at the owning line.
+//
+// Each line caches its output target. Editing a tile only invalidates the
+// edited lines and the lines ending next to it pointing at it; buildings
+// are followed through the CInventory construct / destroy signals. Lines
+// are updated downstream first, so an item can cross any number of lines
+// in the tick a slot frees up.
+class TransportLines {
+public:
+    static constexpr uint32_t TILE_UNITS   = 256;
+    static constexpr uint32_t ITEM_SPACING = TILE_UNITS / 4;   // 4 items per tile
+
+    TransportLines() = default;
+
+    TransportLines(const TransportLines&)            = delete;
+    TransportLines& operator=(const TransportLines&) = delete;
+
+    // Follow building placement on registry; grid must outlive the connection
+    void connect(entt::registry& registry, const SpatialGrid& grid);
+    void disconnect(entt::registry& registry);
+
+    // CInventory listeners
+    void onInventoryChanged(entt::registry& registry, entt::entity e);
+
+    // Lines ending next to tile (x, y) and pointing at it resolve their
+    // output again, for buildings moved there or away
+    void invalidateAround(const entt::registry& registry, const SpatialGrid& grid, int32_t x, int32_t y);
+
+    // Belt e must already have its CPosition and CBelt
+    void addBelt   (entt::registry& registry, const SpatialGrid& grid, entt::entity e);
+    void removeBelt(entt::registry& registry, const SpatialGrid& grid, entt::entity e);
+    void clear() noexcept;
+
+    // Every line with its items, for ECSWorld snapshots. load replaces the
+    // lines, belts must already be in registry; outputs are resolved again
+    void save(SnapshotWriter& out) const;
+    bool load(SnapshotReader& in, const entt::registry& registry, const SnapshotRemap& remap);
+    // Once every component is loaded: each CBelt's line is INVALID_LINE or
+    // a live line holding that belt at its tile
+    [[nodiscard]] bool checkBelts(const entt::registry& registry) const;
+
+    // Put an item on line id at tile (x, y): at the tile's entry when fed
+    // from behind, mid-tile when side loaded. False if there is no room
+    bool insert(LineId id, int32_t x, int32_t y, ItemId item, bool sideLoad);
+
+    // Advance every line by dt. deliver(entt::entity building, ItemId) is
+    // called for a head item leaving into a building and returns true if
+    // the item was taken
+    template<typename Deliver>
+    void update(entt::registry& registry, const SpatialGrid& grid, float dt, Deliver&& deliver);
+
+    // fn(ItemId, float x, float y) for every item, in tile coordinates
+    template<typename Fn>
+    void forEachItem(Fn&& fn) const;
+
+    [[nodiscard]] const TransportLine& line(LineId id) const noexcept { return m_lines[id]; }
+    [[nodiscard]] size_t               lineCount() const noexcept { return m_lines.size() - m_free.size(); }
+    [[nodiscard]] size_t               itemCount() const noexcept;
+
+private:
+    // Item and absolute position, used while re-encoding on edits
+    struct Placed {
+        ItemId   item;
+        uint32_t pos;
+    };
+
+    std::vector<TransportLine> m_lines;
+    std::vector<LineId>        m_free;
+    std::vector<Placed>        m_scratch;
+
+    // Update order, downstream lines first; rebuilt after any edit
+    std::vector<LineId>  m_order;
+    std::vector<uint8_t> m_visit;
+    bool                 m_orderDirty = true;
+
+    const SpatialGrid* m_grid = nullptr;    // set while connected
+
+    LineId allocate();
+    void   release(LineId id);
+    void   relabel(entt::registry& registry, LineId id);
+
+    void invalidate(LineId id) noexcept;
+    void resolve(const entt::registry& registry, const SpatialGrid& grid, TransportLine& line) const;
+    void rebuildOrder(const entt::registry& registry, const SpatialGrid& grid);
+    bool pushToBelt(const entt::registry& registry, TransportLine& line, ItemId item);
+
+    // Line id (x, y) belongs to, if that tile holds a belt going dir at speed
+    LineId lineAt(const entt::registry& registry, const SpatialGrid& grid, int32_t x, int32_t y,
+                  Direction dir, float speed) const;
+
+    static void decode(const TransportLine& line, uint32_t offset, std::vector<Placed>& out);
+    static void encode(TransportLine& line, std::span<const Placed> placed);
+    static void advance(TransportLine& line, uint32_t move) noexcept;
+    static void popHead(TransportLine& line) noexcept;
+};
+
+template<typename Deliver>
+void TransportLines::update(entt::registry& registry, const SpatialGrid& grid, float dt, Deliver&& deliver) {
+    if (m_orderDirty) rebuildOrder(registry, grid);
+
+    for (const LineId id : m_order) {
+        TransportLine& line = m_lines[id];
+        if (line.head == line.items.size()) continue;
+
+        // Head waiting at the end: hand it over
+        if (line.items[line.head].gap == 0) {
+            bool taken = false;
+            if (line.output == LineOutput::Belt) {
+                taken = pushToBelt(registry, line, line.items[line.head].item);
+            } else if (line.output == LineOutput::Inventory) {
+                if (registry.valid(line.target))
+                    taken = deliver(line.target, line.items[line.head].item);
+                else
+                    invalidate(id);
+            }
+            if (taken) popHead(line);
+            if (line.head == line.items.size()) continue;
+        }
+
+        const float    units = line.speed * dt * TILE_UNITS + line.carry;
+        const uint32_t move  = static_cast<uint32_t>(units);
+        line.carry           = units - static_cast<float>(move);
+        advance(line, move);
+    }
+}
+
+template<typename Fn>
+void TransportLines::forEachItem(Fn&& fn) const {
+    for (const auto& line : m_lines) {
+        if (line.length == 0) continue;
+        int32_t endX, endY, dx, dy;
+        line.tileAt(line.length - 1, endX, endY);
+        line.outputTile(dx, dy);
+        dx -= endX;
+        dy -= endY;
+
+        // Tile centres: the end of the line is half a tile past the last centre
+        uint32_t pos = 0;
+        for (uint32_t i = line.head; i < line.items.size(); i++) {
+            pos += line.items[i].gap + (i == line.head ? 0 : ITEM_SPACING);
+            const float back = static_cast<float>(pos) / TILE_UNITS - 0.5f;
+            fn(line.items[i].item, endX - dx * back, endY - dy * back);
+        }
+    }
+}
+
+#endif
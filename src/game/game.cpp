@@ -4,20 +4,24 @@
 
 #include "game.h"
 
+#include <algorithm>
+#include <cmath>
+
 Game::Game():
     width(1280),
     height(720),
-    renderer(width,height)
+    renderer(width,height),
+    simThread(simulation)
 {
 }
 
 void Game::init() {
     if (!renderer.init()) {
-        std::cout << "failed to Initialize Renderer" << std::endl;
+        LOG_ERROR(Renderer, "Failed to initialize the renderer");
         return;
     }
 
-    std::cout << "Game Initialized" << std::endl;
+    LOG_INFO(Core, "Game initialized");
 
     lastFrame = (float)glfwGetTime();
     fpsTimer = glfwGetTime();
@@ -27,10 +31,20 @@ void Game::init() {
     glfwSetScrollCallback(renderer.getWindow(), Game::scroll_callback);
 
     // Init
-    RecipeDB::registerRecipe({"smelt_iron", {{"iron_ore", 2}}, {{"iron_plate", 1}}, 3.0f});
+    simulation.init();
+
+    // Starting base, placed before the simulation thread takes the world over
+    ECSWorld& world = simulation.getWorld();
+    const ItemId ironOre = ItemRegistry::intern("iron_ore");
+
     auto smelter = world.createBuilding("assets/models/smelter.gltf", 0, 0, "smelt_iron");
     world.get<CScale>(smelter) = { 64.0f, 64.0f, 64.0f }; // to be adjusted
-    world.get<CInventory>(smelter).addItem("iron_ore", 20);
+    world.insertItem(smelter, ironOre, 20);
+
+    // Written in the background, the simulation only pauses for the fork / copy
+    simulation.setAutosave(FileManager::GetBasePath() + "/saves/autosave.sgw", AUTOSAVE_SECONDS);
+
+    simThread.start();
 }
 
 void Game::update() {
@@ -68,12 +82,18 @@ void Game::update() {
     float gridX = camPixelX / tileW + camPixelY / tileH;
     float gridY = camPixelY / tileH - camPixelX / tileW;
 
-    chunkManager.updateLoadedChunks(gridX, gridY, 1.0f, 5);
-
-    // ECS
+    // Chunks stream around the camera on the simulation thread
+    const int32_t tileX = static_cast<int32_t>(std::floor(gridX));
+    const int32_t tileY = static_cast<int32_t>(std::floor(gridY));
+    if (tileX != focusX || tileY != focusY) {
+        focusX = tileX;
+        focusY = tileY;
+        simThread.post({ InputEvent::Type::Focus, gridX, gridY });
+    }
 
-    world.updateCrafters(dt);
-    world.updateBelts(dt);
+    // Picked up once per frame, rendered as is
+    snapshot = &simThread.latest();
+    simAlpha = snapshot->alpha(RenderSnapshot::Clock::now());
 
         fpsFrames++;
     double currentTime = glfwGetTime();
@@ -83,19 +103,29 @@ void Game::update() {
         double fps = fpsFrames / elapsed;
         double ms = 1000.0 / fps;
 
+        const ChunkGenStats&    gen    = snapshot->gen;
+        const ChunkStreamStats& stream = snapshot->stream;
+
         std::string title = "My Game - FPS: " + std::to_string((int)fps)
-                        + " | " + std::to_string(ms).substr(0, 4) + " ms";
+                        + " | " + std::to_string(ms).substr(0, 4) + " ms"
+                        + " | UPS: " + std::to_string((int)((snapshot->tick - upsTick) / elapsed))
+                        + " (" + std::to_string(snapshot->tickMs).substr(0, 4) + " ms)"
+                        + " | gen queue: " + std::to_string(gen.queueDepth + gen.inFlight)
+                        + " (" + std::to_string(gen.avgLatencyMs).substr(0, 4) + " ms)"
+                        + " | stream: " + std::to_string(stream.recomputes) + "/" + std::to_string(stream.updates)
+                        + " (+" + std::to_string(stream.lastLoads) + " -" + std::to_string(stream.lastUnloads) + ")";
 
         glfwSetWindowTitle(renderer.getWindow(), title.c_str());
 
         fpsFrames = 0;
+        upsTick = snapshot->tick;
         fpsTimer = currentTime;
     }
 }
 
 void Game::render() {
     renderer.clear();           // Nettoyage de l'écran
-    renderer.renderChunks(chunkManager);
+    renderer.renderChunks(*snapshot);
     renderer.draw();            // Envoi au GPU (Flush)
     renderer.present();         // Affichage (Swap buffers)
 }
@@ -109,7 +139,7 @@ void Game::moveEvent(int x, int y) {
 }
 
 void Game::clickEvent(int x, int y) {
-    std::cout << "Click at : (" << x << ", " << y << ")" << std::endl;
+    simThread.post({ InputEvent::Type::Click, (float)x, (float)y });
 }
 
 void Game::keyPressEvent(int key) {
@@ -125,6 +155,12 @@ void Game::keyPressEvent(int key) {
         else
             glfwSetWindowMonitor(renderer.getWindow(), NULL, 100, 100, 1280, 720, GLFW_DONT_CARE);
     }
+
+    if (key == GLFW_KEY_F3)
+        simThread.post({ InputEvent::Type::ToggleSystemTimings });
+
+    if (key == GLFW_KEY_F4)
+        simThread.post({ InputEvent::Type::ToggleDeterministic });
 }
 
 void Game::keyReleaseEvent(int key) {
@@ -142,7 +178,8 @@ void Game::scroll_callback(GLFWwindow* window, double xoffset, double yoffset) {
 }
 
 void Game::stop() {
-    std::cout << "Game Stopped" << std::endl;
+    simThread.stop();
+    LOG_INFO(Core, "Game stopped");
 }
 
 
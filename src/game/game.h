@@ -6,12 +6,11 @@
 #define GAME_H
 
 #include "../renderer/renderer.h"
-#include "world/worldgen.h"
-#include "ECS/ecs.h"
+#include "simulation.h"
+#include "simthread.h"
 
 class Game {
 public:
-
     Game();
 
     void init();
@@ -30,22 +29,31 @@ public:
 
     Renderer& getRenderer() { return this->renderer; }
 
-    float    dt = 0.0f;
+    float    dt = 0.0f;         // frame time
+    float    simAlpha = 0.0f;   // fraction of a tick since the last snapshot, for interpolation
 private:
+    static constexpr int AUTOSAVE_SECONDS = 300;   // of simulated time
+
     int width = 0;
     int height = 0;
 
     Renderer renderer;
     FileManager fileManager;
 
-    ChunkManager chunkManager; // default seed
+    // World state lives on the simulation thread once started, the window
+    // thread only posts input and reads snapshots
+    Simulation       simulation;
+    SimulationThread simThread;
+    const RenderSnapshot* snapshot = nullptr;   // picked up by update, drawn by render
 
     bool keys[1024] = {};  // tracks which keys are held down
 
-    ECSWorld world;
+    int32_t focusX = 0, focusY = 0;   // camera tile last sent to the simulation
 
     float lastFrame = 0.0f;
 
+    uint64_t upsTick = 0;   // snapshot tick at the last title update
+
     double fpsTimer = 0.0;
     int fpsFrames = 0;
 };
@@ -0,0 +1,63 @@
+#ifndef RENDERSNAPSHOT_H
+#define RENDERSNAPSHOT_H
+
+#include "world/worldgen.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// =====================
+// RENDER SNAPSHOT
+// =====================
+// Everything the render thread needs from one simulation tick, published
+// by the simulation thread through a TripleBuffer. Nothing in it points
+// back into simulation state.
+
+// Tile types of a ready chunk. Shared and immutable: a new view is built
+// only when the chunk changes, so snapshots copy pointers, not tiles, and
+// a skipped snapshot never loses a chunk update
+struct ChunkView {
+    ChunkPos pos;
+    uint64_t version = 0;   // bumped on every rebuild, renderer re-uploads when it changes
+    TileType types[CHUNK_AREA];
+};
+
+// A visible entity, at the current tick and the one before for interpolation
+struct EntityView {
+    uint32_t id = 0;        // entt::entity value
+    float    x = 0.0f, y = 0.0f, z = 0.0f;
+    float    prevX = 0.0f, prevY = 0.0f, prevZ = 0.0f;
+};
+
+struct BeltItemView {
+    uint16_t item = 0;      // ItemId
+    float    x = 0.0f, y = 0.0f;
+};
+
+struct RenderSnapshot {
+    using Clock = std::chrono::steady_clock;
+
+    uint64_t          tick = 0;
+    Clock::time_point time;             // when the tick finished
+    float             tickDt = 0.0f;    // seconds per tick
+
+    std::vector<std::shared_ptr<const ChunkView>> chunks;   // loaded and ready
+    std::vector<EntityView>                       entities;
+    std::vector<BeltItemView>                     beltItems;
+
+    // For the title bar
+    ChunkGenStats    gen;
+    ChunkStreamStats stream;
+    float            tickMs = 0.0f;     // simulation cost of this tick
+
+    // Fraction of a tick elapsed since this one, for interpolation
+    float alpha(Clock::time_point now) const {
+        const float elapsed = std::chrono::duration<float>(now - time).count();
+        return tickDt > 0.0f ? std::clamp(elapsed / tickDt, 0.0f, 1.0f) : 1.0f;
+    }
+};
+
+#endif // RENDERSNAPSHOT_H
@@ -0,0 +1,65 @@
+#include "simthread.h"
+#include "../utils/log.h"
+
+#include <chrono>
+
+SimulationThread::SimulationThread(Simulation& simulation):
+    simulation(simulation)
+{
+}
+
+SimulationThread::~SimulationThread() {
+    stop();
+}
+
+void SimulationThread::start() {
+    if (running()) return;
+
+    // Something to draw before the first tick completes
+    simulation.snapshot(snapshots.back());
+    snapshots.publish();
+
+    stopping = false;
+    thread   = std::thread(&SimulationThread::run, this);
+}
+
+void SimulationThread::stop() {
+    if (!running()) return;
+    stopping = true;
+    thread.join();
+}
+
+bool SimulationThread::post(const InputEvent& event) {
+    if (inputs.push(event)) return true;
+    LOG_WARN(Simulation, "Input queue full, event dropped");
+    return false;
+}
+
+const RenderSnapshot& SimulationThread::latest() {
+    snapshots.update();
+    return snapshots.front();
+}
+
+void SimulationThread::run() {
+    using Clock = std::chrono::steady_clock;
+    const auto tickDuration = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(Simulation::TICK_DT));
+
+    auto next = Clock::now();
+    while (!stopping.load(std::memory_order_relaxed)) {
+        InputEvent event;
+        while (inputs.pop(event))
+            simulation.handle(event);
+
+        simulation.tick();
+        simulation.snapshot(snapshots.back());
+        snapshots.publish();
+
+        // Fixed rate; when too far behind, slow down instead of spiralling
+        next += tickDuration;
+        const auto now = Clock::now();
+        if (now - next > tickDuration * MAX_CATCHUP_TICKS)
+            next = now;
+        std::this_thread::sleep_until(next);
+    }
+}
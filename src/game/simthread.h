@@ -0,0 +1,51 @@
+#ifndef SIMTHREAD_H
+#define SIMTHREAD_H
+
+#include "simulation.h"
+#include "../utils/spscqueue.h"
+#include "../utils/triplebuffer.h"
+
+#include <atomic>
+#include <thread>
+
+// =====================
+// SIMULATION THREAD
+// =====================
+// Runs a Simulation at ECSWorld::TICKS_PER_SECOND on its own thread. Input
+// goes in through a lock-free queue, every tick ends by publishing a
+// RenderSnapshot through a triple buffer: the window thread never waits on
+// the simulation and never touches its state. Only one thread may post and
+// read snapshots (the window thread).
+class SimulationThread {
+public:
+    static constexpr int MAX_CATCHUP_TICKS = 5;    // further behind than this and the backlog is dropped
+
+    explicit SimulationThread(Simulation& simulation);
+    ~SimulationThread();
+
+    SimulationThread(const SimulationThread&)            = delete;
+    SimulationThread& operator=(const SimulationThread&) = delete;
+
+    void start();
+    void stop();    // finishes the current tick and joins
+    bool running() const { return thread.joinable(); }
+
+    // False when the queue is full and the event was dropped
+    bool post(const InputEvent& event);
+
+    // Latest published snapshot, valid until the next call
+    const RenderSnapshot& latest();
+
+private:
+    static constexpr size_t INPUT_CAPACITY = 256;
+
+    Simulation&                           simulation;
+    std::thread                           thread;
+    std::atomic<bool>                     stopping{ false };
+    SPSCQueue<InputEvent, INPUT_CAPACITY> inputs;
+    TripleBuffer<RenderSnapshot>          snapshots;
+
+    void run();
+};
+
+#endif // SIMTHREAD_H
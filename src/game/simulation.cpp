@@ -0,0 +1,352 @@
+#include "simulation.h"
+
+#include "ECS/snapshot.h"
+#include "../utils/compression.h"
+#include "../utils/log.h"
+#include "../utils/utils.h"
+
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+#ifndef _WIN32
+    #include <signal.h>
+    #include <sys/types.h>
+    #include <sys/wait.h>
+    #include <unistd.h>
+#endif
+
+namespace {
+    constexpr size_t PACKED_HEADER_BYTES = sizeof(SNAPSHOT_PACKED_MAGIC) + sizeof(uint64_t);
+    constexpr size_t MAX_RLE_EXPANSION   = 65;    // a 130 byte run packs into 2
+
+    float elapsedMs(std::chrono::steady_clock::time_point t0) {
+        return std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    }
+
+    // Encode, pack and write a capture. Written aside then renamed, a crash
+    // mid-write keeps the previous save
+    bool writeSnapshotFile(const std::string& path, const WorldCapture& capture) {
+        std::vector<uint8_t> bytes;
+        capture.write(bytes);
+
+        const uint64_t       size = bytes.size();
+        std::vector<uint8_t> packed(PACKED_HEADER_BYTES);
+        std::memcpy(packed.data(), SNAPSHOT_PACKED_MAGIC, sizeof(SNAPSHOT_PACKED_MAGIC));
+        std::memcpy(packed.data() + sizeof(SNAPSHOT_PACKED_MAGIC), &size, sizeof(size));
+        Compression::packRLE(bytes, packed);
+
+        std::error_code             ec;
+        const std::filesystem::path parent = std::filesystem::path(path).parent_path();
+        if (!parent.empty()) std::filesystem::create_directories(parent, ec);
+
+        const std::string tmp = path + ".tmp";
+        {
+            std::ofstream file(tmp, std::ios::binary | std::ios::trunc);
+            if (!file.write(reinterpret_cast<const char*>(packed.data()), static_cast<std::streamsize>(packed.size()))) {
+                LOG_ERROR(Simulation, "Cannot write {}", tmp);
+                return false;
+            }
+        }
+        std::filesystem::rename(tmp, path, ec);
+        if (ec) {
+            LOG_ERROR(Simulation, "Cannot replace {}: {}", path, ec.message());
+            return false;
+        }
+        return true;
+    }
+
+    // Snapshot in a file's bytes, unpacked in place. Bare snapshots (no
+    // packed header) are taken as they are
+    bool unpackSnapshotFile(std::vector<uint8_t>& bytes) {
+        if (bytes.size() < PACKED_HEADER_BYTES ||
+            std::memcmp(bytes.data(), SNAPSHOT_PACKED_MAGIC, sizeof(SNAPSHOT_PACKED_MAGIC)) != 0)
+            return true;
+
+        uint64_t size = 0;
+        std::memcpy(&size, bytes.data() + sizeof(SNAPSHOT_PACKED_MAGIC), sizeof(size));
+        if (size > (bytes.size() - PACKED_HEADER_BYTES) * MAX_RLE_EXPANSION) return false;
+
+        std::vector<uint8_t> unpacked(static_cast<size_t>(size));
+        if (!Compression::unpackRLE(std::span(bytes).subspan(PACKED_HEADER_BYTES), unpacked)) return false;
+        bytes = std::move(unpacked);
+        return true;
+    }
+}
+
+Simulation::Simulation():
+    Simulation(ChunkManagerConfig{ .saveDirectory = FileManager::GetBasePath() + "/saves/world" })
+{
+}
+
+Simulation::Simulation(const ChunkManagerConfig& config):
+    chunkManager(config)
+{
+}
+
+Simulation::~Simulation() {
+    finishSave();
+}
+
+void Simulation::init() {
+    RecipeDB::loadFromJSON("data/recipes.json");
+
+    // Power first, so crafters run this tick at their new speed
+    world.addSystem("power", SystemAccess{}.read<CPowerPole, CPowerProducer>().write<CPowerConsumer, CCrafter>(),
+                    [](ECSWorld& w, float) { w.updatePower(); });
+    // Belts hand items to buildings (CInventory) and wake their crafters
+    world.addSystem("crafters", SystemAccess{}.write<CCrafter, CInventory>(),
+                    [](ECSWorld& w, float dt) { w.updateCrafters(dt); });
+    world.addSystem("belts", SystemAccess{}.read<CPosition>().write<CBelt, CInventory, CCrafter>(),
+                    [](ECSWorld& w, float dt) { w.updateBelts(dt); });
+}
+
+void Simulation::handle(const InputEvent& event) {
+    switch (event.type) {
+    case InputEvent::Type::Focus:
+        focusX = event.x;
+        focusY = event.y;
+        break;
+
+    case InputEvent::Type::Click:
+        LOG_DEBUG(Simulation, "Click at ({}, {})", event.x, event.y);
+        break;
+
+    case InputEvent::Type::ToggleSystemTimings:
+        showSystemTimings = !showSystemTimings;
+        break;
+
+    case InputEvent::Type::ToggleDeterministic:
+        world.scheduler().setDeterministic(!world.scheduler().deterministic());
+        LOG_INFO(Simulation, "Systems run {}", world.scheduler().deterministic() ? "serially" : "in parallel");
+        break;
+    }
+}
+
+void Simulation::tick() {
+    const auto t0 = std::chrono::steady_clock::now();
+
+    chunkManager.updateLoadedChunks(focusX, focusY, 1.0f, RENDER_DISTANCE);
+    world.runSystems(TICK_DT);
+
+    collectSave(false);
+    if (autosaveTicks > 0 && world.tick() % autosaveTicks == 0) {
+        if (saving())
+            saveStats.skipped++;
+        else
+            saveAsync(autosavePath);
+    }
+
+    tickMs = elapsedMs(t0);
+
+    if (showSystemTimings && world.tick() % ECSWorld::TICKS_PER_SECOND == 0) {
+        std::ostringstream timings;
+        world.scheduler().printTimings(timings);
+        LOG_INFO(Simulation, "System timings\n{}", timings.str());
+    }
+}
+
+void Simulation::snapshot(RenderSnapshot& out) {
+    out.tick   = world.tick();
+    out.time   = RenderSnapshot::Clock::now();
+    out.tickDt = TICK_DT;
+    out.gen    = chunkManager.genStats();
+    out.stream = chunkManager.streamStats();
+    out.tickMs = tickMs;
+
+    // Chunks: drop the views of unloaded chunks, rebuild the dirty ones
+    if (out.stream.chunksUnloaded != seenUnloads) {
+        seenUnloads = out.stream.chunksUnloaded;
+        std::erase_if(chunkViews, [&](const auto& entry) { return chunkManager.findChunk(entry.first) == INVALID_CHUNK; });
+    }
+
+    out.chunks.clear();
+    for (ChunkHandle handle : chunkManager.loadedChunks()) {
+        Chunk& chunk = chunkManager.chunkAt(handle);
+        // Still being generated by a worker
+        if (!chunk.isReady()) continue;
+
+        auto& view = chunkViews[chunk.pos];
+        if (chunk.dirty || !view) {
+            auto rebuilt     = std::make_shared<ChunkView>();
+            rebuilt->pos     = chunk.pos;
+            rebuilt->version = ++chunkVersion;
+            chunk.unpackTypes(rebuilt->types);
+            view        = std::move(rebuilt);
+            chunk.dirty = false;
+        }
+        out.chunks.push_back(view);
+    }
+
+    // Entities and belt items around the focus
+    const float minX = focusX - VIEW_RADIUS, maxX = focusX + VIEW_RADIUS;
+    const float minY = focusY - VIEW_RADIUS, maxY = focusY + VIEW_RADIUS;
+
+    out.entities.clear();
+    world.entitiesIn(minX, minY, maxX, maxY, visible);
+    for (entt::entity e : visible) {
+        const CMesh* mesh = world.raw().try_get<CMesh>(e);
+        if (!mesh || !mesh->visible) continue;
+
+        const CPosition&     pos  = world.get<CPosition>(e);
+        const CPrevPosition* prev = world.raw().try_get<CPrevPosition>(e);
+
+        EntityView ev;
+        ev.id    = static_cast<uint32_t>(entt::to_integral(e));
+        ev.x     = pos.x;
+        ev.y     = pos.y;
+        ev.z     = pos.z;
+        ev.prevX = prev ? prev->x : pos.x;
+        ev.prevY = prev ? prev->y : pos.y;
+        ev.prevZ = prev ? prev->z : pos.z;
+        out.entities.push_back(ev);
+    }
+
+    out.beltItems.clear();
+    world.transportLines().forEachItem([&](ItemId item, float x, float y) {
+        if (x < minX || x > maxX || y < minY || y > maxY) return;
+        out.beltItems.push_back({ item, x, y });
+    });
+}
+
+bool Simulation::save(const std::string& path) const {
+    WorldCapture snapshot;
+    capture(snapshot);
+    return writeSnapshotFile(path, snapshot);
+}
+
+bool Simulation::load(const std::string& path) {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file.is_open()) {
+        LOG_ERROR(Simulation, "Cannot open {}", path);
+        return false;
+    }
+    std::vector<uint8_t> bytes(static_cast<size_t>(file.tellg()));
+    file.seekg(0);
+    if (!file.read(reinterpret_cast<char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()))) {
+        LOG_ERROR(Simulation, "Cannot read {}", path);
+        return false;
+    }
+    if (!unpackSnapshotFile(bytes)) {
+        LOG_ERROR(Simulation, "Cannot unpack {}", path);
+        return false;
+    }
+
+    if (!world.load(bytes)) return false;
+
+    // ECSWorld skipped the chunk section
+    SnapshotReader           in{ bytes };
+    uint32_t                 tag = 0;
+    std::span<const uint8_t> payload;
+    in.header();
+    while (in.nextSection(tag, payload)) {
+        if (tag == SNAPSHOT_CHUNK_DELTAS && !chunkManager.loadDeltas(payload)) {
+            LOG_WARN(Simulation, "Invalid chunk edits in {}, kept the current ones", path);
+            break;
+        }
+    }
+    return true;
+}
+
+bool Simulation::saveAsync(const std::string& path) {
+    if (saving()) return false;
+
+    saveStart = std::chrono::steady_clock::now();
+    savePath  = path;
+
+#ifndef _WIN32
+    if (saveMethod == SaveMethod::Fork) {
+        // Pages are shared with the child and copied only as this process
+        // writes to them: the fork is the whole pause
+        const pid_t pid = fork();
+        if (pid == 0) {
+            // Only this thread exists in the child. _exit: nothing inherited
+            // from the parent (threads, GL, files) is torn down from here. No
+            // log writer runs here either, what the child logs is lost: the
+            // parent reports the failure from the exit status
+            WorldCapture snapshot;
+            capture(snapshot);
+            _exit(writeSnapshotFile(path, snapshot) ? 0 : 1);
+        }
+        if (pid > 0) {
+            saveProcess       = pid;
+            saveStats.pauseMs = elapsedMs(saveStart);
+            return true;
+        }
+        LOG_WARN(Simulation, "fork failed ({}), saving from a copy", std::strerror(errno));
+    }
+#endif
+
+    if (!saveCapture) saveCapture = std::make_unique<WorldCapture>();
+    capture(*saveCapture);
+    saveThread = std::async(std::launch::async,
+                            [&snapshot = *saveCapture, path] { return writeSnapshotFile(path, snapshot); });
+    saveStats.pauseMs = elapsedMs(saveStart);
+    return true;
+}
+
+void Simulation::finishSave() {
+    collectSave(true);
+}
+
+void Simulation::setAutosave(const std::string& path, int intervalSeconds) {
+    autosavePath  = path;
+    autosaveTicks = intervalSeconds > 0 ? static_cast<uint64_t>(intervalSeconds) * ECSWorld::TICKS_PER_SECOND : 0;
+}
+
+void Simulation::capture(WorldCapture& out) const {
+    world.capture(out);
+
+    SnapshotWriter tail{ out.tail };
+    tail.beginSection(SNAPSHOT_CHUNK_DELTAS);
+    chunkManager.saveDeltas(tail.bytes());
+    tail.endSection();
+}
+
+bool Simulation::collectSave(bool block) {
+    if (!saving()) return true;
+
+    bool ok = false;
+    if (saveThread.valid()) {
+        if (!block && saveThread.wait_for(std::chrono::seconds(0)) != std::future_status::ready) return false;
+        ok = saveThread.get();
+    } else {
+#ifndef _WIN32
+        int   status = 0;
+        pid_t done   = 0;
+        for (;;) {
+            done = waitpid(saveProcess, &status, WNOHANG);
+            if (done < 0 && errno == EINTR) continue;
+            if (done != 0) break;
+
+            // A child stuck on a lock held at fork time never exits
+            if (std::chrono::steady_clock::now() - saveStart > SAVE_CHILD_TIMEOUT) {
+                LOG_ERROR(Simulation, "Background save to {} still running after {} s, killed", savePath,
+                          static_cast<int64_t>(SAVE_CHILD_TIMEOUT.count()));
+                kill(saveProcess, SIGKILL);
+                while (waitpid(saveProcess, &status, 0) < 0 && errno == EINTR) {}
+                done = -1;
+                break;
+            }
+            if (!block) return false;
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        ok = done == saveProcess && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+#endif
+        saveProcess = -1;
+    }
+
+    saveStats.totalMs = elapsedMs(saveStart);
+    if (ok) {
+        saveStats.saves++;
+        LOG_INFO(Simulation, "Saved {} ({} ms pause, {} ms total)", savePath, saveStats.pauseMs, saveStats.totalMs);
+    } else {
+        saveStats.failures++;
+        LOG_ERROR(Simulation, "Background save to {} failed", savePath);
+    }
+    return true;
+}
@@ -0,0 +1,144 @@
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include "world/worldgen.h"
+#include "ECS/ecs.h"
+#include "rendersnapshot.h"
+
+#include <chrono>
+#include <future>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+struct WorldCapture;
+
+// Input forwarded from the window thread to the simulation
+struct InputEvent {
+    enum class Type : uint8_t {
+        Focus,                  // camera moved to tile (x, y), chunks stream around it
+        Click,                  // window coordinates
+        ToggleSystemTimings,    // F3
+        ToggleDeterministic,    // F4
+    };
+
+    Type  type = Type::Focus;
+    float x = 0.0f, y = 0.0f;
+};
+
+// Background saves, see Simulation::saveAsync
+struct SaveStats {
+    float    pauseMs  = 0.0f;   // ticks held back by the last save
+    float    totalMs  = 0.0f;   // from the pause to the file on disk
+    uint64_t saves    = 0;      // written
+    uint64_t failures = 0;
+    uint64_t skipped  = 0;      // autosaves due while the previous save was still running
+};
+
+// How Simulation::saveAsync copies the world
+enum class SaveMethod {
+    Capture,    // copy the component pools (ECSWorld::capture), a thread writes them
+    Fork,       // POSIX, opt-in: a child process writes its copy-on-write view
+};
+
+// =====================
+// SIMULATION
+// =====================
+// World state and the per-tick update: chunk streaming and ECS systems.
+// Not thread safe; owned by one thread at a time (the SimulationThread
+// once started). The render side only ever sees RenderSnapshots. Nothing
+// here depends on GL or a window, so it also runs headless (FactoryBench).
+class Simulation {
+public:
+    static constexpr float TICK_DT = 1.0f / ECSWorld::TICKS_PER_SECOND;
+
+    Simulation();   // saves under FileManager's base path
+    explicit Simulation(const ChunkManagerConfig& config);
+    ~Simulation();  // waits for a background save
+
+    Simulation(const Simulation&)            = delete;
+    Simulation& operator=(const Simulation&) = delete;
+
+    // Recipes and systems; the world is empty until the caller fills it
+    void init();
+
+    void handle(const InputEvent& event);
+    void tick();
+
+    // Fill out with the state of the last tick. Chunk views are only
+    // rebuilt for dirty chunks, the others are shared with earlier snapshots
+    void snapshot(RenderSnapshot& out);
+
+    // World snapshot file: the ECS state and the chunk edits (format in
+    // ECS/snapshot.h, RLE packed). Call between ticks. load returns false
+    // if the file cannot be read (world untouched) or is malformed (empty
+    // world)
+    bool save(const std::string& path) const;
+    bool load(const std::string& path);
+
+    // save without stopping the world for it. The only pause is taking a
+    // consistent copy of the state, between two ticks; encoding, packing
+    // and writing run in the background while ticks go on. Completion is
+    // picked up by tick(). False if a save is still running
+    //
+    // SaveMethod::Fork makes the pause the fork alone, but the child of a
+    // multithreaded process is only guaranteed async-signal-safe calls: it
+    // allocates and writes files, and hangs if another thread (renderer,
+    // chunk workers, job pool, log writer) held a lock it needs at fork
+    // time. A child still running after SAVE_CHILD_TIMEOUT is killed and
+    // the save counted as failed. Without fork (Windows), or if it fails,
+    // saves use SaveMethod::Capture
+    bool saveAsync(const std::string& path);
+    // Block until the background save, if any, is on disk (or the forked
+    // child is killed for taking too long)
+    void finishSave();
+    [[nodiscard]] bool saving() const { return saveProcess > 0 || saveThread.valid(); }
+
+    // saveAsync to path every intervalSeconds of simulated time, 0 turns it off
+    void setAutosave(const std::string& path, int intervalSeconds);
+    void setSaveMethod(SaveMethod method) { saveMethod = method; }
+    const SaveStats& getSaveStats() const { return saveStats; }
+
+    ECSWorld&     getWorld() { return world; }
+    ChunkManager& getChunkManager() { return chunkManager; }
+
+private:
+    // Area around the focus copied into snapshots, in tiles
+    static constexpr int   RENDER_DISTANCE = 5;
+    static constexpr float VIEW_RADIUS     = (RENDER_DISTANCE + 1) * CHUNK_SIZE;
+
+    // A forked save still running after this is taken to be stuck
+    static constexpr auto SAVE_CHILD_TIMEOUT = std::chrono::seconds(30);
+
+    ChunkManager chunkManager;
+    ECSWorld     world;
+
+    float focusX = 0.0f, focusY = 0.0f;
+    float tickMs = 0.0f;
+    bool  showSystemTimings = false;    // F3: print per-system timings every second
+
+    // Views of ready chunks, dropped when the chunk unloads
+    std::unordered_map<ChunkPos, std::shared_ptr<const ChunkView>, ChunkPosHash> chunkViews;
+    uint64_t chunkVersion = 0;
+    uint64_t seenUnloads  = 0;  // streamStats().chunksUnloaded at the last prune
+
+    std::vector<entt::entity> visible;  // scratch
+
+    // Background save
+    std::string                           autosavePath;
+    uint64_t                              autosaveTicks = 0;    // 0: off
+    SaveMethod                            saveMethod = SaveMethod::Capture;
+    std::string                           savePath;             // of the save in flight
+    std::chrono::steady_clock::time_point saveStart;
+    int                                   saveProcess = -1;     // child pid while a forked save runs
+    std::future<bool>                     saveThread;           // valid while a thread save runs
+    std::unique_ptr<WorldCapture>         saveCapture;          // written by saveThread, kept for the next one
+    SaveStats                             saveStats;
+
+    // World and chunk edits, as written by save
+    void capture(WorldCapture& out) const;
+    // Save done: wait for it if block, else only check. False while it runs
+    bool collectSave(bool block);
+};
+
+#endif // SIMULATION_H
@@ -0,0 +1,260 @@
+#include "chunk.h"
+
+// =====================
+// PALETTE HELPERS
+// =====================
+
+namespace {
+    int bitsForPalette(size_t n) {
+        if (n <= 1)  return 0;
+        if (n <= 2)  return 1;
+        if (n <= 4)  return 2;
+        if (n <= 16) return 4;
+        return 8;
+    }
+
+    constexpr size_t MAX_PALETTE = 256;
+
+    // Fixed index width so the inner loop unrolls
+    template<int Bits, typename T>
+    void decodeIndices(std::span<const uint8_t> indices, const T* lookup, T* out) {
+        constexpr int perByte = 8 / Bits;
+        constexpr int mask    = (1 << Bits) - 1;
+        for (uint8_t packed : indices) {
+            for (int k = 0; k < perByte; k++)
+                out[k] = lookup[(packed >> (k * Bits)) & mask];
+            out += perByte;
+        }
+    }
+}
+
+void Chunk::setPaletteIndex(int i, int value) {
+    const int     bit   = i * bits;
+    const int     shift = bit & 7;
+    const uint8_t mask  = static_cast<uint8_t>(((1 << bits) - 1) << shift);
+    uint8_t&      b     = indices[bit >> 3];
+    b = static_cast<uint8_t>((b & ~mask) | ((value << shift) & mask));
+}
+
+void Chunk::repack(int newBits) {
+    uint8_t decoded[CHUNK_AREA];
+    for (int i = 0; i < CHUNK_AREA; i++)
+        decoded[i] = bits == 0 ? 0 : static_cast<uint8_t>(paletteIndex(i));
+
+    bits = static_cast<int8_t>(newBits);
+    indices.assign(CHUNK_AREA * bits / 8, 0);
+    for (int i = 0; i < CHUNK_AREA; i++)
+        setPaletteIndex(i, decoded[i]);
+}
+
+// =====================
+// STORAGE TRANSITIONS
+// =====================
+
+void Chunk::setCell(int i, const TileCell& cell) {
+    if (storage == ChunkStorage::Full) {
+        fullTypes[i]     = cell.type;
+        fullFlags[i]     = cell.flags;
+        fullResources[i] = cell.resource;
+        return;
+    }
+
+    auto it = std::find(palette.begin(), palette.end(), cell);
+    if (it == palette.end()) {
+        if (palette.size() >= MAX_PALETTE) {
+            makeFull();
+            setCell(i, cell);
+            return;
+        }
+        palette.push_back(cell);
+        it = palette.end() - 1;
+
+        // Widen indices when the palette outgrew them (Single -> 1 -> 2 -> 4 -> 8 bits)
+        const int needed = bitsForPalette(palette.size());
+        if (needed > bits) {
+            repack(needed);
+            storage = ChunkStorage::Palette;
+        }
+    }
+
+    if (storage == ChunkStorage::Palette)
+        setPaletteIndex(i, static_cast<int>(it - palette.begin()));
+}
+
+void Chunk::assignCells(std::span<const TileCell, CHUNK_AREA> cells) {
+    std::vector<TileCell> newPalette;
+    uint8_t               idx[CHUNK_AREA];
+    int                   last = 0;
+
+    for (int i = 0; i < CHUNK_AREA; i++) {
+        // Neighbouring tiles usually share a cell, try the last hit first
+        if (!newPalette.empty() && newPalette[last] == cells[i]) {
+            idx[i] = static_cast<uint8_t>(last);
+            continue;
+        }
+        auto it = std::find(newPalette.begin(), newPalette.end(), cells[i]);
+        if (it == newPalette.end()) {
+            if (newPalette.size() >= MAX_PALETTE) {
+                // Too varied for a palette
+                storage = ChunkStorage::Full;
+                bits    = 0;
+                palette.clear();
+                palette.shrink_to_fit();
+                indices.clear();
+                indices.shrink_to_fit();
+                fullTypes.resize(CHUNK_AREA);
+                fullFlags.resize(CHUNK_AREA);
+                fullResources.resize(CHUNK_AREA);
+                for (int j = 0; j < CHUNK_AREA; j++) {
+                    fullTypes[j]     = cells[j].type;
+                    fullFlags[j]     = cells[j].flags;
+                    fullResources[j] = cells[j].resource;
+                }
+                return;
+            }
+            newPalette.push_back(cells[i]);
+            it = newPalette.end() - 1;
+        }
+        last   = static_cast<int>(it - newPalette.begin());
+        idx[i] = static_cast<uint8_t>(last);
+    }
+
+    fullTypes     = {};
+    fullFlags     = {};
+    fullResources = {};
+
+    palette = std::move(newPalette);
+    bits    = static_cast<int8_t>(bitsForPalette(palette.size()));
+    storage = bits == 0 ? ChunkStorage::Single : ChunkStorage::Palette;
+
+    indices.assign(CHUNK_AREA * bits / 8, 0);
+    if (bits > 0)
+        for (int i = 0; i < CHUNK_AREA; i++)
+            setPaletteIndex(i, idx[i]);
+}
+
+void Chunk::makeFull() {
+    if (storage == ChunkStorage::Full) return;
+
+    fullTypes.resize(CHUNK_AREA);
+    fullFlags.resize(CHUNK_AREA);
+    fullResources.resize(CHUNK_AREA);
+    for (int i = 0; i < CHUNK_AREA; i++) {
+        const TileCell c = getCell(i);
+        fullTypes[i]     = c.type;
+        fullFlags[i]     = c.flags;
+        fullResources[i] = c.resource;
+    }
+
+    storage = ChunkStorage::Full;
+    bits    = 0;
+    palette = {};
+    indices = {};
+}
+
+void Chunk::compact() {
+    TileCell cells[CHUNK_AREA];
+    for (int i = 0; i < CHUNK_AREA; i++)
+        cells[i] = getCell(i);
+    assignCells(cells);
+}
+
+void Chunk::fill(TileType type, int8_t flags) {
+    const TileCell cell{ type, flags == 0 ? Tile::defaultFlags(type) : flags, 0 };
+
+    fullTypes     = {};
+    fullFlags     = {};
+    fullResources = {};
+    indices       = {};
+    palette.assign(1, cell);
+    storage = ChunkStorage::Single;
+    bits    = 0;
+}
+
+// =====================
+// QUERIES
+// =====================
+
+size_t Chunk::memoryUsage() const {
+    return sizeof(Chunk)
+         + palette.capacity() * sizeof(TileCell)
+         + indices.capacity()
+         + fullTypes.capacity() * sizeof(TileType)
+         + fullFlags.capacity()
+         + fullResources.capacity();
+}
+
+void Chunk::unpackTypes(std::span<TileType, CHUNK_AREA> out) const {
+    switch (storage) {
+        case ChunkStorage::Single:
+            std::fill(out.begin(), out.end(), palette[0].type);
+            return;
+
+        case ChunkStorage::Palette: {
+            TileType lookup[MAX_PALETTE];
+            for (size_t p = 0; p < palette.size(); p++)
+                lookup[p] = palette[p].type;
+
+            switch (bits) {
+                case 1:  decodeIndices<1>(indices, lookup, out.data()); break;
+                case 2:  decodeIndices<2>(indices, lookup, out.data()); break;
+                case 4:  decodeIndices<4>(indices, lookup, out.data()); break;
+                default: decodeIndices<8>(indices, lookup, out.data()); break;
+            }
+            return;
+        }
+
+        default:
+            std::copy(fullTypes.begin(), fullTypes.end(), out.begin());
+            return;
+    }
+}
+
+int Chunk::countFlag(int8_t flag) const {
+    switch (storage) {
+        case ChunkStorage::Single:
+            return (palette[0].flags & flag) ? CHUNK_AREA : 0;
+
+        case ChunkStorage::Palette: {
+            // Decide per palette entry, then only the indices are scanned
+            uint8_t match[MAX_PALETTE] = {};
+            bool    any = false;
+            for (size_t p = 0; p < palette.size(); p++)
+                any |= (match[p] = (palette[p].flags & flag) != 0);
+            if (!any) return 0;
+
+            uint8_t hits[CHUNK_AREA];
+            switch (bits) {
+                case 1:  decodeIndices<1>(indices, match, hits); break;
+                case 2:  decodeIndices<2>(indices, match, hits); break;
+                case 4:  decodeIndices<4>(indices, match, hits); break;
+                default: decodeIndices<8>(indices, match, hits); break;
+            }
+
+            int n = 0;
+            for (uint8_t h : hits)
+                n += h;
+            return n;
+        }
+
+        default: {
+            int n = 0;
+            for (int8_t f : fullFlags)
+                n += (f & flag) != 0;
+            return n;
+        }
+    }
+}
+
+void Chunk::summarizeOres() {
+    ores = {};
+
+    // Most chunks hold no ore at all, the palette tells without a scan
+    if (storage != ChunkStorage::Full &&
+        std::none_of(palette.begin(), palette.end(), [](const TileCell& c) { return oreSlot(c.type) >= 0; }))
+        return;
+
+    for (int y = 0; y < CHUNK_SIZE; y++)
+        for (int x = 0; x < CHUNK_SIZE; x++)
+            ores.add(x, y, getCell(index(x, y)));
+}
@@ -0,0 +1,218 @@
+#ifndef CHUNK_H
+#define CHUNK_H
+
+#include "tile.h"
+#include <algorithm>
+#include <iterator>
+#include <span>
+#include <vector>
+
+// =====================
+// TILE CELL
+// =====================
+// Gameplay part of a tile (everything but elevation), the unit chunk
+// palettes are built from.
+struct TileCell {
+    TileType type     = TileType::NONE;
+    int8_t   flags    = 0;
+    int8_t   resource = 0;
+
+    bool operator==(const TileCell& o) const = default;
+};
+
+// =====================
+// ORE SUMMARY
+// =====================
+static constexpr int ORE_KINDS = 3;
+
+// Slot of an ore type in OreSummary, -1 for anything else
+inline int oreSlot(TileType t) {
+    switch (t) {
+        case TileType::COPPER_ORE: return 0;
+        case TileType::IRON_ORE:   return 1;
+        case TileType::AMETHYST:   return 2;
+        default:                   return -1;
+    }
+}
+
+struct OreStats {
+    uint16_t tiles    = 0;
+    uint32_t resource = 0;              // sum of the tiles' resource amounts
+    int8_t   minX = CHUNK_SIZE, minY = CHUNK_SIZE;
+    int8_t   maxX = -1,         maxY = -1;  // inclusive, local tile coords
+
+    bool empty() const { return tiles == 0; }
+};
+
+// Per-chunk ore counts, emitted by the generator and kept up to date by
+// ChunkManager::setTile. Depleted tiles still count, with 0 resource.
+struct OreSummary {
+    OreStats ores[ORE_KINDS];
+
+    void add(int x, int y, const TileCell& cell) {
+        const int slot = oreSlot(cell.type);
+        if (slot < 0) return;
+        OreStats& s = ores[slot];
+        s.tiles++;
+        s.resource += static_cast<uint8_t>(cell.resource);
+        s.minX = std::min<int8_t>(s.minX, x); s.maxX = std::max<int8_t>(s.maxX, x);
+        s.minY = std::min<int8_t>(s.minY, y); s.maxY = std::max<int8_t>(s.maxY, y);
+    }
+
+    const OreStats& of(TileType t) const { return ores[oreSlot(t)]; }
+    bool            any() const {
+        return std::any_of(std::begin(ores), std::end(ores), [](const OreStats& s) { return !s.empty(); });
+    }
+};
+
+// =====================
+// CHUNK
+// =====================
+enum class ChunkState : int8_t {
+    Pending = 0,    // requested, waiting for a generation worker
+    Ready   = 1,    // tiles are valid and can be rendered / queried
+};
+
+enum class ChunkStorage : int8_t {
+    Single  = 0,    // one cell for the whole chunk (open ocean, fills)
+    Palette = 1,    // 1/2/4/8-bit indices into a palette of cells
+    Full    = 2,    // one plane per field
+};
+
+// Cells (type, flags, resource) use the most compact storage that holds
+// the chunk and move to a denser mode as edits add new values. Elevation
+// is always a quantized int16 plane. All planes are row-major
+// (index = y * CHUNK_SIZE + x).
+struct Chunk {
+    ChunkPos   pos;
+    ChunkState state     = ChunkState::Pending;
+    bool       dirty     = true;    // changed since the last render snapshot
+    bool       generated = false;
+    bool       modified  = false;   // edited since load, needs saving
+    OreSummary ores;
+
+    Chunk() = default;
+    explicit Chunk(ChunkPos pos) : pos(pos) {}
+
+    bool isReady() const { return state == ChunkState::Ready; }
+
+    static int index(int x, int y) { return y * CHUNK_SIZE + x; }
+
+    // --- Cells ---
+    TileCell getCell(int i) const {
+        switch (storage) {
+            case ChunkStorage::Single:  return palette[0];
+            case ChunkStorage::Palette: return palette[paletteIndex(i)];
+            default:                    return { fullTypes[i], fullFlags[i], fullResources[i] };
+        }
+    }
+    // Promotes the storage mode when the cell is not representable yet
+    void setCell(int i, const TileCell& cell);
+
+    // Replace every cell, picking the most compact storage for them
+    void assignCells(std::span<const TileCell, CHUNK_AREA> cells);
+
+    // --- Whole tile ---
+    Tile getTile(TilePos p)    const { return getTile(p.x, p.y); }
+    Tile getTile(int x, int y) const {
+        const int      i = index(x, y);
+        const TileCell c = getCell(i);
+        Tile t;
+        t.type      = c.type;
+        t.flags     = c.flags;
+        t.resource  = c.resource;
+        t.elevation = dequantizeElevation(tileElevations[i]);
+        return t;
+    }
+
+    void setTile(TilePos p, const Tile& t)    { setTile(p.x, p.y, t); }
+    void setTile(int x, int y, const Tile& t) {
+        const int i = index(x, y);
+        setCell(i, { t.type, t.flags, t.resource });
+        tileElevations[i] = quantizeElevation(t.elevation);
+    }
+
+    // --- Single fields ---
+    TileType type(int x, int y)      const { return getCell(index(x, y)).type; }
+    int8_t   flagsAt(int x, int y)   const { return getCell(index(x, y)).flags; }
+    int8_t   resource(int x, int y)  const { return getCell(index(x, y)).resource; }
+    float    elevation(int x, int y) const { return dequantizeElevation(tileElevations[index(x, y)]); }
+    bool     hasFlag(int x, int y, int8_t flag) const { return flagsAt(x, y) & flag; }
+
+    void setType(int x, int y, TileType t)    { editCell(x, y, [&](TileCell& c) { c.type = t; }); }
+    void setFlags(int x, int y, int8_t f)     { editCell(x, y, [&](TileCell& c) { c.flags = f; }); }
+    void setFlag(int x, int y, int8_t flag)   { editCell(x, y, [&](TileCell& c) { c.flags |= flag; }); }
+    void unsetFlag(int x, int y, int8_t flag) { editCell(x, y, [&](TileCell& c) { c.flags &= ~flag; }); }
+    void setResource(int x, int y, int8_t r)  { editCell(x, y, [&](TileCell& c) { c.resource = r; }); }
+
+    // --- Storage ---
+    ChunkStorage storageMode() const { return storage; }
+    int          indexBits()   const { return bits; }
+
+    std::span<const TileCell> paletteCells()   const { return palette; }
+    std::span<const uint8_t>  paletteIndices() const { return indices; }
+
+    // Cell planes, empty unless storage is Full (see makeFull)
+    std::span<const TileType> types()     const { return fullTypes; }
+    std::span<const int8_t>   flags()     const { return fullFlags; }
+    std::span<const int8_t>   resources() const { return fullResources; }
+
+    std::span<int16_t, CHUNK_AREA>       elevations()       { return tileElevations; }
+    std::span<const int16_t, CHUNK_AREA> elevations() const { return tileElevations; }
+
+    // Expand to one plane per field
+    void makeFull();
+    // Rebuild the most compact storage (drops stale palette entries)
+    void compact();
+
+    // Bytes held by this chunk, heap storage included
+    size_t memoryUsage() const;
+
+    // Number of tiles with the flag set
+    int countFlag(int8_t flag) const;
+
+    // Rebuild `ores` from the cells (after loads / applying edits)
+    void summarizeOres();
+
+    // Decode the type of every tile at once (memset / palette lookup / memcpy)
+    void unpackTypes(std::span<TileType, CHUNK_AREA> out) const;
+
+    void fill(TileType type, int8_t flags = 0);
+
+    // Noise elevation is in [-1, 1], stored as int16 (~3e-5 precision)
+    static int16_t quantizeElevation(float e) {
+        return static_cast<int16_t>(std::clamp(e, -1.0f, 1.0f) * 32767.0f);
+    }
+    static float dequantizeElevation(int16_t q) {
+        return static_cast<float>(q) * (1.0f / 32767.0f);
+    }
+
+private:
+    ChunkStorage          storage = ChunkStorage::Single;
+    int8_t                bits    = 0;              // palette index width, 0 when Single
+    std::vector<TileCell> palette = { TileCell{} }; // Single / Palette
+    std::vector<uint8_t>  indices;                  // Palette: CHUNK_AREA * bits / 8 bytes
+
+    std::vector<TileType> fullTypes;                // Full only
+    std::vector<int8_t>   fullFlags;
+    std::vector<int8_t>   fullResources;
+
+    int16_t tileElevations[CHUNK_AREA] = {};
+
+    int paletteIndex(int i) const {
+        const int bit = i * bits;
+        return (indices[bit >> 3] >> (bit & 7)) & ((1 << bits) - 1);
+    }
+    void setPaletteIndex(int i, int value);
+    void repack(int newBits);
+
+    template<typename Fn>
+    void editCell(int x, int y, Fn&& fn) {
+        const int i = index(x, y);
+        TileCell  c = getCell(i);
+        fn(c);
+        setCell(i, c);
+    }
+};
+
+#endif // CHUNK_H
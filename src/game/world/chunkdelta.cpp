@@ -0,0 +1,34 @@
+#include "chunkdelta.h"
+#include <algorithm>
+
+namespace {
+    bool byIndex(const ChunkDelta::Entry& e, int index) { return e.index < index; }
+}
+
+void ChunkDelta::set(int index, const TileCell& cell) {
+    auto it = std::lower_bound(cells.begin(), cells.end(), index, byIndex);
+    if (it != cells.end() && it->index == index)
+        it->cell = cell;
+    else
+        cells.insert(it, Entry{ static_cast<uint16_t>(index), cell });
+}
+
+const TileCell* ChunkDelta::find(int index) const {
+    auto it = std::lower_bound(cells.begin(), cells.end(), index, byIndex);
+    return it != cells.end() && it->index == index ? &it->cell : nullptr;
+}
+
+void ChunkDelta::apply(Chunk& chunk) const {
+    for (const Entry& e : cells)
+        chunk.setCell(e.index, e.cell);
+}
+
+ChunkDelta ChunkDelta::diff(const Chunk& base, const Chunk& edited) {
+    ChunkDelta delta;
+    for (int i = 0; i < CHUNK_AREA; i++) {
+        const TileCell cell = edited.getCell(i);
+        if (cell != base.getCell(i))
+            delta.cells.push_back({ static_cast<uint16_t>(i), cell });
+    }
+    return delta;
+}
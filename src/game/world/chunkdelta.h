@@ -0,0 +1,43 @@
+#ifndef CHUNKDELTA_H
+#define CHUNKDELTA_H
+
+#include "chunk.h"
+#include <span>
+#include <vector>
+
+// =====================
+// CHUNK DELTA
+// =====================
+// Cells of a chunk that differ from the generator output, sorted by tile
+// index. The authoritative chunk is WorldGen output + delta; elevation is
+// never edited and always comes from the generator.
+class ChunkDelta {
+public:
+    struct Entry {
+        uint16_t index;     // Chunk::index(x, y)
+        TileCell cell;
+    };
+
+    // Record (or overwrite) the cell at index
+    void            set(int index, const TileCell& cell);
+    const TileCell* find(int index) const;
+
+    // Write every recorded cell into a freshly generated chunk
+    void apply(Chunk& chunk) const;
+
+    // Cells of `edited` that differ from `base` (same position)
+    static ChunkDelta diff(const Chunk& base, const Chunk& edited);
+
+    std::span<const Entry> entries() const { return cells; }
+    bool                   empty()   const { return cells.empty(); }
+    size_t                 size()    const { return cells.size(); }
+    void                   clear()         { cells.clear(); }
+
+    // Bytes held, heap storage included
+    size_t memoryUsage() const { return sizeof(ChunkDelta) + cells.capacity() * sizeof(Entry); }
+
+private:
+    std::vector<Entry> cells;
+};
+
+#endif // CHUNKDELTA_H
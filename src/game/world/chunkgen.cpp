@@ -0,0 +1,223 @@
+#include "chunkgen.h"
+#include "worldgen.h"
+#include <algorithm>
+
+// =====================
+// HEAP ORDER
+// =====================
+
+namespace {
+    // std::*_heap builds a max-heap, invert so the nearest request is on top
+    struct FartherFirst {
+        template<typename R>
+        bool operator()(const R& a, const R& b) const { return a.distance > b.distance; }
+    };
+
+    constexpr float LATENCY_SMOOTHING = 0.1f;
+}
+
+// =====================
+// LIFETIME
+// =====================
+
+ChunkGenService::ChunkGenService(const WorldGen& worldGen, int workerCount)
+    : worldGen(worldGen) {
+    if (workerCount <= 0)
+        workerCount = defaultWorkerCount();
+
+    workers.reserve(workerCount);
+    for (int i = 0; i < workerCount; i++)
+        workers.emplace_back(&ChunkGenService::workerLoop, this);
+}
+
+ChunkGenService::~ChunkGenService() {
+    {
+        std::lock_guard lock(queueMutex);
+        stopping = true;
+        queue.clear();
+    }
+    queueCv.notify_all();
+
+    for (auto& worker : workers)
+        worker.join();
+}
+
+int ChunkGenService::defaultWorkerCount() {
+    const int hw = static_cast<int>(std::thread::hardware_concurrency());
+    return std::max(1, hw - 1);
+}
+
+// =====================
+// REQUESTS
+// =====================
+
+int64_t ChunkGenService::distanceTo(const Request& r) const {
+    // Doubled coordinates keep the block center integral
+    const int64_t dx = (2 * int64_t(r.pos.x) + r.w - 1) - 2 * int64_t(focus.x);
+    const int64_t dy = (2 * int64_t(r.pos.y) + r.h - 1) - 2 * int64_t(focus.y);
+    return dx * dx + dy * dy;
+}
+
+void ChunkGenService::request(ChunkPos pos) {
+    requestRegion(pos, 1, 1);
+}
+
+void ChunkGenService::requestRegion(ChunkPos origin, int w, int h, uint64_t wanted) {
+    if (w <= 0 || h <= 0) return;
+    if (w * h > MAX_REGION_CHUNKS) {
+        for (int y = 0; y < h; y += REGION_SPLIT)
+            for (int x = 0; x < w; x += REGION_SPLIT)
+                requestRegion(ChunkPos(origin.x + x, origin.y + y), std::min(REGION_SPLIT, w - x),
+                              std::min(REGION_SPLIT, h - y));
+        return;
+    }
+
+    wanted &= w * h == MAX_REGION_CHUNKS ? ~uint64_t{ 0 } : (uint64_t{ 1 } << (w * h)) - 1;
+    if (wanted == 0) return;
+    {
+        std::lock_guard lock(queueMutex);
+        for (auto& r : queue) {
+            if (r.pos == origin && r.w == w && r.h == h) {
+                r.wanted |= wanted;    // possibly wanted again after a cancel
+                return;
+            }
+        }
+
+        Request req{ origin, w, h, wanted, 0, Clock::now() };
+        req.distance = distanceTo(req);
+        queue.push_back(req);
+        std::push_heap(queue.begin(), queue.end(), FartherFirst{});
+    }
+    queueCv.notify_one();
+}
+
+void ChunkGenService::cancel(ChunkPos pos) {
+    std::lock_guard lock(queueMutex);
+    bool removed = false;
+    for (size_t i = queue.size(); i-- > 0;) {
+        Request&      r = queue[i];
+        const int32_t x = pos.x - r.pos.x;
+        const int32_t y = pos.y - r.pos.y;
+        if (x < 0 || y < 0 || x >= r.w || y >= r.h) continue;
+
+        r.wanted &= ~(uint64_t{ 1 } << (y * r.w + x));
+        if (r.wanted == 0) {
+            r = queue.back();
+            queue.pop_back();
+            removed = true;
+        }
+    }
+    if (removed)
+        std::make_heap(queue.begin(), queue.end(), FartherFirst{});
+}
+
+void ChunkGenService::setFocus(ChunkPos center) {
+    std::lock_guard lock(queueMutex);
+    if (center == focus) return;
+
+    focus = center;
+    for (auto& r : queue)
+        r.distance = distanceTo(r);
+    std::make_heap(queue.begin(), queue.end(), FartherFirst{});
+}
+
+// =====================
+// COMPLETION
+// =====================
+
+size_t ChunkGenService::poll(std::vector<std::unique_ptr<Chunk>>& out) {
+    std::lock_guard lock(doneMutex);
+    const size_t n = done.size();
+    for (auto& chunk : done)
+        out.push_back(std::move(chunk));
+    done.clear();
+    return n;
+}
+
+void ChunkGenService::recycle(std::unique_ptr<Chunk> buffer) {
+    if (!buffer) return;
+    std::lock_guard lock(doneMutex);
+    // Keep a couple of spares per worker, let the rest go
+    if (freeBuffers.size() < workers.size() * 2)
+        freeBuffers.push_back(std::move(buffer));
+}
+
+std::unique_ptr<Chunk> ChunkGenService::acquireBuffer() {
+    std::lock_guard lock(doneMutex);
+    if (freeBuffers.empty())
+        return std::make_unique<Chunk>();
+
+    auto buffer = std::move(freeBuffers.back());
+    freeBuffers.pop_back();
+    return buffer;
+}
+
+ChunkGenStats ChunkGenService::stats() const {
+    ChunkGenStats s;
+    {
+        std::lock_guard lock(doneMutex);
+        s = doneStats;
+    }
+    std::lock_guard lock(queueMutex);
+    s.queueDepth = queue.size();
+    s.inFlight   = inFlight;
+    return s;
+}
+
+// =====================
+// WORKER
+// =====================
+
+void ChunkGenService::workerLoop() {
+    for (;;) {
+        Request req;
+        {
+            std::unique_lock lock(queueMutex);
+            queueCv.wait(lock, [&] { return stopping || !queue.empty(); });
+            if (stopping) return;
+
+            std::pop_heap(queue.begin(), queue.end(), FartherFirst{});
+            req = queue.back();
+            queue.pop_back();
+            inFlight++;
+        }
+
+        // Buffers belong to this worker until they are pushed to `done`
+        std::vector<std::unique_ptr<Chunk>> buffers(static_cast<size_t>(req.w) * req.h);
+        std::vector<Chunk*>                 targets(buffers.size());
+        for (size_t i = 0; i < buffers.size(); i++) {
+            buffers[i]            = acquireBuffer();
+            buffers[i]->state     = ChunkState::Pending;
+            buffers[i]->generated = false;
+            targets[i]            = buffers[i].get();
+        }
+        worldGen.generateRegion(req.pos, req.w, req.h, targets);
+
+        const auto  now       = Clock::now();
+        const float latencyMs = std::chrono::duration<float, std::milli>(now - req.queuedAt).count();
+
+        {
+            // Chunks cancelled while queued are generated with the block but not handed back
+            std::lock_guard lock(doneMutex);
+            size_t          handed = 0;
+            for (size_t i = 0; i < buffers.size(); i++) {
+                if (req.wanted >> i & 1) {
+                    done.push_back(std::move(buffers[i]));
+                    handed++;
+                } else if (freeBuffers.size() < workers.size() * 2) {
+                    freeBuffers.push_back(std::move(buffers[i]));
+                }
+            }
+
+            doneStats.completed += handed;
+            doneStats.lastLatencyMs = latencyMs;
+            doneStats.maxLatencyMs  = std::max(doneStats.maxLatencyMs, latencyMs);
+            doneStats.avgLatencyMs  = doneStats.completed == handed
+                ? latencyMs
+                : doneStats.avgLatencyMs + (latencyMs - doneStats.avgLatencyMs) * LATENCY_SMOOTHING;
+        }
+
+        std::lock_guard lock(queueMutex);
+        inFlight--;
+    }
+}
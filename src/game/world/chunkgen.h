@@ -0,0 +1,103 @@
+#ifndef CHUNKGEN_H
+#define CHUNKGEN_H
+
+#include "chunk.h"
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class WorldGen;
+
+// =====================
+// GENERATION STATS
+// =====================
+struct ChunkGenStats {
+    size_t   queueDepth    = 0;     // requests waiting for a worker
+    size_t   inFlight      = 0;     // requests currently being generated
+    uint64_t completed     = 0;     // chunks finished since startup
+    float    lastLatencyMs = 0.0f;  // request -> finished, most recent chunk
+    float    avgLatencyMs  = 0.0f;  // moving average over recent chunks
+    float    maxLatencyMs  = 0.0f;
+};
+
+// =====================
+// CHUNK GEN SERVICE
+// =====================
+// Generates chunks on a pool of worker threads so the main thread never
+// runs FastNoise. Requests are served nearest-first relative to the focus
+// set by the owner, and finished chunks come back through poll(). Chunks
+// are pure generator output, the owner reapplies edits.
+class ChunkGenService {
+public:
+    ChunkGenService(const WorldGen& worldGen, int workerCount);
+    ~ChunkGenService();
+
+    ChunkGenService(const ChunkGenService&)            = delete;
+    ChunkGenService& operator=(const ChunkGenService&) = delete;
+
+    // Queue a chunk for generation (duplicates are ignored)
+    void request(ChunkPos pos);
+    // Queue a w x h block of chunks generated in one WorldGen::generateRegion
+    // call. Only the chunks in wanted (bit y * w + x) are handed back, all by
+    // default; blocks over MAX_REGION_CHUNKS are split and want every chunk
+    void requestRegion(ChunkPos origin, int w, int h, uint64_t wanted = ~uint64_t{ 0 });
+    // Drop pos from the queued requests: a block is only generated while one
+    // of its chunks is still wanted, and hands back those only. Work already
+    // in flight still completes
+    void cancel(ChunkPos pos);
+    // Re-prioritise queued requests around a new center
+    void setFocus(ChunkPos center);
+
+    // Move finished chunks into out, returns how many were added
+    size_t poll(std::vector<std::unique_ptr<Chunk>>& out);
+    // Hand a drained buffer back so workers can reuse it
+    void   recycle(std::unique_ptr<Chunk> buffer);
+
+    ChunkGenStats stats() const;
+    int           workerCount() const { return static_cast<int>(workers.size()); }
+
+    // hardware_concurrency - 1, at least one
+    static int defaultWorkerCount();
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr int MAX_REGION_CHUNKS = 64;   // bits of Request::wanted
+    static constexpr int REGION_SPLIT      = 8;    // side of the pieces of a larger block
+
+    struct Request {
+        ChunkPos          pos;          // origin of the block
+        int               w = 1;
+        int               h = 1;
+        uint64_t          wanted = 0;   // bit y * w + x: chunk not cancelled
+        int64_t           distance = 0; // block center to focus
+        Clock::time_point queuedAt;
+    };
+
+    const WorldGen& worldGen;
+
+    std::vector<std::thread> workers;
+
+    // Request queue (min-heap on distance to focus)
+    mutable std::mutex      queueMutex;
+    std::condition_variable queueCv;
+    std::vector<Request>    queue;
+    ChunkPos                focus;
+    size_t                  inFlight = 0;
+    bool                    stopping = false;
+
+    // Completion queue + recycled buffers
+    mutable std::mutex                  doneMutex;
+    std::vector<std::unique_ptr<Chunk>> done;
+    std::vector<std::unique_ptr<Chunk>> freeBuffers;
+    ChunkGenStats                       doneStats;
+
+    void    workerLoop();
+    int64_t distanceTo(const Request& r) const;
+    std::unique_ptr<Chunk> acquireBuffer();
+};
+
+#endif // CHUNKGEN_H
@@ -0,0 +1,120 @@
+#include "chunkpool.h"
+
+namespace {
+    constexpr size_t INITIAL_TABLE_SIZE = 256;
+}
+
+ChunkPool::ChunkPool() {
+    table.resize(INITIAL_TABLE_SIZE);
+    tableMask = INITIAL_TABLE_SIZE - 1;
+}
+
+// =====================
+// HANDLES
+// =====================
+
+void ChunkPool::growSlabs() {
+    const auto base = static_cast<ChunkHandle>(slabs.size() * SLAB_SIZE);
+    slabs.push_back(std::make_unique<Chunk[]>(SLAB_SIZE));
+    liveIndex.resize(base + SLAB_SIZE, 0);
+
+    // Reversed so the lowest handle of the slab is handed out first
+    for (uint32_t i = SLAB_SIZE; i-- > 0;)
+        freeList.push_back(base + i);
+}
+
+ChunkHandle ChunkPool::acquire(ChunkPos pos) {
+    if (freeList.empty())
+        growSlabs();
+
+    const ChunkHandle handle = freeList.back();
+    freeList.pop_back();
+
+    get(handle) = Chunk(pos);
+
+    liveIndex[handle] = static_cast<uint32_t>(liveHandles.size());
+    liveHandles.push_back(handle);
+    insertIndex(pos, handle);
+    return handle;
+}
+
+void ChunkPool::release(ChunkHandle handle) {
+    Chunk& chunk = get(handle);
+    eraseIndex(chunk.pos);
+
+    // Swap-remove from the dense live array
+    const uint32_t    at   = liveIndex[handle];
+    const ChunkHandle last = liveHandles.back();
+    liveHandles[at]  = last;
+    liveIndex[last]  = at;
+    liveHandles.pop_back();
+
+    // Drop heap storage now, the slot itself stays in its slab
+    chunk = Chunk();
+    freeList.push_back(handle);
+}
+
+// =====================
+// OPEN-ADDRESSING INDEX
+// =====================
+
+size_t ChunkPool::hash(ChunkPos pos) {
+    // splitmix64 finalizer over the packed coordinates
+    uint64_t h = (static_cast<uint64_t>(static_cast<uint32_t>(pos.x)) << 32) | static_cast<uint32_t>(pos.y);
+    h ^= h >> 30; h *= 0xbf58476d1ce4e5b9ull;
+    h ^= h >> 27; h *= 0x94d049bb133111ebull;
+    h ^= h >> 31;
+    return static_cast<size_t>(h);
+}
+
+ChunkHandle ChunkPool::find(ChunkPos pos) const {
+    for (size_t i = hash(pos) & tableMask;; i = (i + 1) & tableMask) {
+        const Slot& slot = table[i];
+        if (slot.handle == INVALID_CHUNK) return INVALID_CHUNK;
+        if (slot.pos == pos)              return slot.handle;
+    }
+}
+
+void ChunkPool::insertIndex(ChunkPos pos, ChunkHandle handle) {
+    if ((liveHandles.size()) * 2 > table.size())
+        growTable();
+
+    size_t i = hash(pos) & tableMask;
+    while (table[i].handle != INVALID_CHUNK)
+        i = (i + 1) & tableMask;
+    table[i] = { pos, handle };
+}
+
+void ChunkPool::eraseIndex(ChunkPos pos) {
+    size_t i = hash(pos) & tableMask;
+    while (table[i].handle != INVALID_CHUNK && table[i].pos != pos)
+        i = (i + 1) & tableMask;
+    if (table[i].handle == INVALID_CHUNK) return;
+
+    // Backward-shift: pull later entries of the probe run into the hole
+    size_t hole = i;
+    for (size_t j = (hole + 1) & tableMask; table[j].handle != INVALID_CHUNK; j = (j + 1) & tableMask) {
+        const size_t home = hash(table[j].pos) & tableMask;
+        // Entry j may move to the hole if its home is not in (hole, j]
+        const bool between = hole <= j ? (home > hole && home <= j) : (home > hole || home <= j);
+        if (!between) {
+            table[hole] = table[j];
+            hole        = j;
+        }
+    }
+    table[hole] = Slot{};
+}
+
+void ChunkPool::growTable() {
+    std::vector<Slot> old = std::move(table);
+    table.assign(old.size() * 2, Slot{});
+    tableMask = table.size() - 1;
+
+    for (const Slot& slot : old) {
+        if (slot.handle == INVALID_CHUNK) continue;
+        size_t i = hash(slot.pos) & tableMask;
+        while (table[i].handle != INVALID_CHUNK)
+            i = (i + 1) & tableMask;
+        table[i] = slot;
+    }
+}
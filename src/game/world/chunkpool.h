@@ -0,0 +1,68 @@
+#ifndef CHUNKPOOL_H
+#define CHUNKPOOL_H
+
+#include "chunk.h"
+#include <memory>
+#include <span>
+#include <vector>
+
+// =====================
+// CHUNK HANDLE
+// =====================
+using ChunkHandle = uint32_t;
+static constexpr ChunkHandle INVALID_CHUNK = 0xFFFFFFFFu;
+
+// =====================
+// CHUNK POOL
+// =====================
+// Chunks live in fixed-size slabs that are never moved or freed, so a
+// handle (slab * SLAB_SIZE + slot) and the Chunk& behind it stay valid
+// until the chunk is released. Released slots go on a free list and are
+// reused before a new slab is allocated.
+//
+// ChunkPos -> handle lookups go through an open-addressing table (linear
+// probing, backward-shift deletion, no tombstones), and the handles of
+// live chunks are kept in a dense array for iteration.
+class ChunkPool {
+public:
+    static constexpr uint32_t SLAB_SIZE = 64;
+
+    ChunkPool();
+
+    // Allocate a chunk for pos (pos must not be in the pool yet)
+    ChunkHandle acquire(ChunkPos pos);
+    void        release(ChunkHandle handle);
+
+    ChunkHandle find(ChunkPos pos) const;
+    bool        contains(ChunkPos pos) const { return find(pos) != INVALID_CHUNK; }
+
+    Chunk&       get(ChunkHandle handle)       { return slabs[handle / SLAB_SIZE][handle % SLAB_SIZE]; }
+    const Chunk& get(ChunkHandle handle) const { return slabs[handle / SLAB_SIZE][handle % SLAB_SIZE]; }
+
+    // Handles of every live chunk, densely packed (order changes on release)
+    std::span<const ChunkHandle> live() const { return liveHandles; }
+    size_t                       size() const { return liveHandles.size(); }
+    size_t                       capacity() const { return slabs.size() * SLAB_SIZE; }
+
+private:
+    struct Slot {
+        ChunkPos    pos;
+        ChunkHandle handle = INVALID_CHUNK;
+    };
+
+    std::vector<std::unique_ptr<Chunk[]>> slabs;
+    std::vector<ChunkHandle>              freeList;
+    std::vector<ChunkHandle>              liveHandles;
+    std::vector<uint32_t>                 liveIndex;    // handle -> position in liveHandles
+
+    std::vector<Slot> table;    // power of two, at most half full
+    size_t            tableMask = 0;
+
+    static size_t hash(ChunkPos pos);
+    void          growSlabs();
+    void          growTable();
+    void          insertIndex(ChunkPos pos, ChunkHandle handle);
+    void          eraseIndex(ChunkPos pos);
+};
+
+#endif // CHUNKPOOL_H
@@ -0,0 +1,107 @@
+#include "oreindex.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    int32_t floorDiv(int32_t v, int32_t d) {
+        return v >= 0 ? v / d : (v - d + 1) / d;
+    }
+
+    // Distance from a point to an inclusive tile box, 0 inside
+    float distanceToBox(int32_t x, int32_t y, const OrePatch& p) {
+        const float dx = static_cast<float>(std::max({ p.minX - x, 0, x - p.maxX }));
+        const float dy = static_cast<float>(std::max({ p.minY - y, 0, y - p.maxY }));
+        return std::sqrt(dx * dx + dy * dy);
+    }
+}
+
+void OreIndex::set(ChunkPos pos, const OreSummary& summary) {
+    if (summary.any())
+        chunks[pos] = summary;
+    else
+        chunks.erase(pos);
+}
+
+const OreSummary* OreIndex::find(ChunkPos pos) const {
+    auto it = chunks.find(pos);
+    return it != chunks.end() ? &it->second : nullptr;
+}
+
+// =====================
+// QUERIES
+// =====================
+
+template<typename Fn>
+void OreIndex::forEachInRing(ChunkPos center, int r, Fn&& fn) {
+    if (r == 0) {
+        fn(center);
+        return;
+    }
+    for (int i = -r; i <= r; i++) {
+        fn(ChunkPos(center.x + i, center.y - r));
+        fn(ChunkPos(center.x + i, center.y + r));
+    }
+    for (int i = -r + 1; i < r; i++) {
+        fn(ChunkPos(center.x - r, center.y + i));
+        fn(ChunkPos(center.x + r, center.y + i));
+    }
+}
+
+bool OreIndex::patchAt(ChunkPos pos, TileType type, int32_t absX, int32_t absY,
+                       int minResource, OrePatch& out) const {
+    auto it = chunks.find(pos);
+    if (it == chunks.end()) return false;
+
+    const OreStats& s = it->second.of(type);
+    if (s.empty() || s.resource < static_cast<uint32_t>(std::max(minResource, 0))) return false;
+
+    out.chunk    = pos;
+    out.type     = type;
+    out.tiles    = s.tiles;
+    out.resource = static_cast<int>(s.resource);
+    out.minX     = pos.x * CHUNK_SIZE + s.minX;
+    out.minY     = pos.y * CHUNK_SIZE + s.minY;
+    out.maxX     = pos.x * CHUNK_SIZE + s.maxX;
+    out.maxY     = pos.y * CHUNK_SIZE + s.maxY;
+    out.distance = distanceToBox(absX, absY, out);
+    return true;
+}
+
+std::optional<OrePatch> OreIndex::nearest(TileType type, int32_t absX, int32_t absY,
+                                          int minResource, int maxRadius) const {
+    if (oreSlot(type) < 0) return std::nullopt;
+
+    const ChunkPos          center(floorDiv(absX, CHUNK_SIZE), floorDiv(absY, CHUNK_SIZE));
+    std::optional<OrePatch> best;
+
+    for (int r = 0; r <= maxRadius; r++) {
+        forEachInRing(center, r, [&](ChunkPos pos) {
+            OrePatch patch;
+            if (patchAt(pos, type, absX, absY, minResource, patch) && (!best || patch.distance < best->distance))
+                best = patch;
+        });
+
+        // Ring r + 1 is at least r whole chunks away from any point of the center chunk
+        if (best && best->distance <= static_cast<float>(r * CHUNK_SIZE))
+            break;
+    }
+    return best;
+}
+
+void OreIndex::withinRadius(TileType type, int32_t absX, int32_t absY, float radius,
+                            int minResource, std::vector<OrePatch>& out) const {
+    out.clear();
+    if (oreSlot(type) < 0 || radius < 0.0f) return;
+
+    const ChunkPos center(floorDiv(absX, CHUNK_SIZE), floorDiv(absY, CHUNK_SIZE));
+    const int      rings = static_cast<int>(std::ceil(radius / CHUNK_SIZE)) + 1;
+
+    for (int r = 0; r <= rings; r++)
+        forEachInRing(center, r, [&](ChunkPos pos) {
+            OrePatch patch;
+            if (patchAt(pos, type, absX, absY, minResource, patch) && patch.distance <= radius)
+                out.push_back(patch);
+        });
+
+    std::sort(out.begin(), out.end(), [](const OrePatch& a, const OrePatch& b) { return a.distance < b.distance; });
+}
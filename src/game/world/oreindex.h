@@ -0,0 +1,58 @@
+#ifndef OREINDEX_H
+#define OREINDEX_H
+
+#include "chunk.h"
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+// =====================
+// ORE PATCH
+// =====================
+// Ore of one type inside one chunk, as seen by index queries
+struct OrePatch {
+    ChunkPos chunk;
+    TileType type     = TileType::NONE;
+    int      tiles    = 0;
+    int      resource = 0;
+    int32_t  minX = 0, minY = 0, maxX = 0, maxY = 0;  // absolute tile coords, inclusive
+    float    distance = 0.0f;                          // tiles from the query point to the box
+};
+
+// =====================
+// ORE INDEX
+// =====================
+// World-level index over the ore summaries of every chunk generated this
+// session (loaded or not). Queries walk square rings of chunks outward
+// from the query point, so they only touch chunks near the answer.
+class OreIndex {
+public:
+    // Replace the summary of a chunk (dropped when it holds no ore)
+    void set(ChunkPos pos, const OreSummary& summary);
+    void erase(ChunkPos pos) { chunks.erase(pos); }
+
+    const OreSummary* find(ChunkPos pos) const;
+    size_t            size() const { return chunks.size(); }
+
+    // Closest patch of `type` holding at least minResource, searching up to
+    // maxRadius chunks away from the query tile
+    std::optional<OrePatch> nearest(TileType type, int32_t absX, int32_t absY,
+                                    int minResource, int maxRadius) const;
+
+    // Every patch of `type` with at least minResource whose box is within
+    // radius tiles of the query tile, nearest first
+    void withinRadius(TileType type, int32_t absX, int32_t absY, float radius,
+                      int minResource, std::vector<OrePatch>& out) const;
+
+private:
+    std::unordered_map<ChunkPos, OreSummary, ChunkPosHash> chunks;
+
+    // Patch of `type` in the chunk at pos, false if absent / too poor
+    bool patchAt(ChunkPos pos, TileType type, int32_t absX, int32_t absY,
+                 int minResource, OrePatch& out) const;
+
+    template<typename Fn>
+    static void forEachInRing(ChunkPos center, int r, Fn&& fn);
+};
+
+#endif // OREINDEX_H
@@ -0,0 +1,462 @@
+#include "regionfile.h"
+#include "../../utils/compression.h"
+#include "../../utils/log.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+
+// =====================
+// FORMAT
+// =====================
+
+namespace {
+    constexpr char     REGION_MAGIC[4] = { 'S', 'G', 'R', 'G' };
+    constexpr uint32_t REGION_VERSION  = 1;
+
+    // v1: full planes only, v2: storage mode + palette, v3: edits over the generator
+    constexpr uint8_t CHUNK_VERSION_PLANES  = 1;
+    constexpr uint8_t CHUNK_VERSION_PALETTE = 2;
+    constexpr uint8_t CHUNK_VERSION_DELTA   = 3;
+
+    constexpr size_t DELTA_ENTRY_SIZE = 5;
+
+    // v1 raw layout: types, flags, resources, elevation low bytes, elevation high bytes
+    constexpr size_t RAW_V1_SIZE = CHUNK_AREA * 5;
+
+    struct RegionHeader {
+        char     magic[4];
+        uint32_t version;
+        uint32_t regionSize;
+        uint32_t reserved;
+    };
+
+    struct RegionIndexEntry {
+        uint32_t offset;
+        uint32_t size;
+    };
+
+    constexpr size_t INDEX_OFFSET = sizeof(RegionHeader);
+    constexpr size_t DATA_OFFSET  = INDEX_OFFSET + sizeof(RegionIndexEntry) * RegionStore::REGION_AREA;
+
+    // Blob offsets are 32 bit, a region file never grows past this
+    constexpr uint64_t MAX_REGION_BYTES = std::numeric_limits<uint32_t>::max();
+    // Rewrite the region once dead blobs take more than this and more than the live ones
+    constexpr uint64_t COMPACT_MIN_DEAD = 1024 * 1024;
+
+    // An entry naming blob bytes: nothing in the header or index, nothing
+    // past the end. Anything else reads as absent
+    bool blobInFile(const RegionIndexEntry& entry, uint64_t fileSize) {
+        return entry.size != 0 && entry.offset >= DATA_OFFSET && uint64_t(entry.offset) + entry.size <= fileSize;
+    }
+
+    int32_t floorDiv(int32_t v, int32_t d) {
+        return v >= 0 ? v / d : (v - d + 1) / d;
+    }
+
+    // Elevation split in low / high byte planes so the high bytes (which
+    // barely change across a chunk) form long runs
+    void writeElevation(const Chunk& chunk, std::vector<uint8_t>& raw) {
+        const size_t base = raw.size();
+        raw.resize(base + CHUNK_AREA * 2);
+        const auto elevations = chunk.elevations();
+        for (int i = 0; i < CHUNK_AREA; i++) {
+            const auto e = static_cast<uint16_t>(elevations[i]);
+            raw[base + i]              = static_cast<uint8_t>(e & 0xFF);
+            raw[base + i + CHUNK_AREA] = static_cast<uint8_t>(e >> 8);
+        }
+    }
+
+    void readElevation(const uint8_t* src, Chunk& out) {
+        auto elevations = out.elevations();
+        for (int i = 0; i < CHUNK_AREA; i++)
+            elevations[i] = static_cast<int16_t>(src[i] | (src[i + CHUNK_AREA] << 8));
+    }
+
+    // Copy the live blobs of `file` into a fresh region file, `blob` in place
+    // of the one at `slot`, and swap it in. The file is only replaced once
+    // the copy is complete
+    bool compactRegion(const std::string& path, std::fstream& file, uint64_t fileSize,
+                       const std::vector<RegionIndexEntry>& index, int slot, const std::vector<uint8_t>& blob) {
+        const std::string tmpPath = path + ".tmp";
+        std::ofstream     out(tmpPath, std::ios::binary | std::ios::trunc);
+
+        RegionHeader header{};
+        std::memcpy(header.magic, REGION_MAGIC, 4);
+        header.version    = REGION_VERSION;
+        header.regionSize = RegionStore::REGION_SIZE;
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+        std::vector<RegionIndexEntry> packed(RegionStore::REGION_AREA, RegionIndexEntry{ 0, 0 });
+        out.write(reinterpret_cast<const char*>(packed.data()), packed.size() * sizeof(RegionIndexEntry));
+
+        uint64_t             end = DATA_OFFSET;
+        std::vector<uint8_t> copy;
+        for (int i = 0; i < RegionStore::REGION_AREA && out; i++) {
+            const RegionIndexEntry& entry = index[i];
+            if (i != slot && !blobInFile(entry, fileSize)) continue;
+
+            const uint64_t size = i == slot ? blob.size() : entry.size;
+            if (end + size > MAX_REGION_BYTES) {
+                LOG_ERROR(World, "Region file {} is full, chunk not saved", path);
+                out.close();
+                std::filesystem::remove(tmpPath);
+                return false;
+            }
+            if (i == slot) {
+                out.write(reinterpret_cast<const char*>(blob.data()), blob.size());
+            } else {
+                copy.resize(entry.size);
+                file.seekg(entry.offset);
+                file.read(reinterpret_cast<char*>(copy.data()), entry.size);
+                if (!file) break;
+                out.write(reinterpret_cast<const char*>(copy.data()), copy.size());
+            }
+            packed[i] = { static_cast<uint32_t>(end), static_cast<uint32_t>(size) };
+            end += size;
+        }
+
+        out.seekp(INDEX_OFFSET);
+        out.write(reinterpret_cast<const char*>(packed.data()), packed.size() * sizeof(RegionIndexEntry));
+        out.close();
+        file.close();
+
+        std::error_code ec;
+        if (out.fail() || file.fail()) {
+            LOG_ERROR(World, "Cannot compact region file {}", path);
+            std::filesystem::remove(tmpPath, ec);
+            return false;
+        }
+        std::filesystem::rename(tmpPath, path, ec);
+        if (ec) {
+            LOG_ERROR(World, "Cannot replace region file {}: {}", path, ec.message());
+            std::filesystem::remove(tmpPath, ec);
+            return false;
+        }
+        LOG_DEBUG(World, "Compacted region file {}: {} -> {} bytes", path, fileSize, end);
+        return true;
+    }
+}
+
+// =====================
+// CHUNK CODEC
+// =====================
+// Blob: [u8 version][u32 raw size][RLE(raw)]
+// v2 raw: [u8 storage][u8 bits][u16 palette size]
+//         Single / Palette: palette cells (3 bytes each), packed indices
+//         Full:             type, flag and resource planes
+//         then the two elevation byte planes
+
+void RegionStore::encodeChunk(const Chunk& chunk, std::vector<uint8_t>& out) {
+    std::vector<uint8_t> raw;
+    raw.reserve(CHUNK_AREA * 5 + 8);
+
+    const auto palette = chunk.paletteCells();
+    raw.push_back(static_cast<uint8_t>(chunk.storageMode()));
+    raw.push_back(static_cast<uint8_t>(chunk.indexBits()));
+    raw.push_back(static_cast<uint8_t>(palette.size() & 0xFF));
+    raw.push_back(static_cast<uint8_t>(palette.size() >> 8));
+
+    if (chunk.storageMode() == ChunkStorage::Full) {
+        const auto types = chunk.types();
+        raw.insert(raw.end(), reinterpret_cast<const uint8_t*>(types.data()),
+                   reinterpret_cast<const uint8_t*>(types.data()) + CHUNK_AREA);
+        for (int8_t f : chunk.flags())     raw.push_back(static_cast<uint8_t>(f));
+        for (int8_t r : chunk.resources()) raw.push_back(static_cast<uint8_t>(r));
+    } else {
+        for (const TileCell& c : palette) {
+            raw.push_back(static_cast<uint8_t>(c.type));
+            raw.push_back(static_cast<uint8_t>(c.flags));
+            raw.push_back(static_cast<uint8_t>(c.resource));
+        }
+        const auto indices = chunk.paletteIndices();
+        raw.insert(raw.end(), indices.begin(), indices.end());
+    }
+    writeElevation(chunk, raw);
+
+    const auto rawSize = static_cast<uint32_t>(raw.size());
+    out.push_back(CHUNK_VERSION_PALETTE);
+    out.insert(out.end(), reinterpret_cast<const uint8_t*>(&rawSize),
+               reinterpret_cast<const uint8_t*>(&rawSize) + sizeof(rawSize));
+    Compression::packRLE(raw, out);
+}
+
+bool RegionStore::decodeChunk(std::span<const uint8_t> blob, Chunk& out) {
+    if (blob.empty()) return false;
+
+    TileCell cells[CHUNK_AREA];
+
+    if (blob[0] == CHUNK_VERSION_PLANES) {
+        uint8_t raw[RAW_V1_SIZE];
+        if (!Compression::unpackRLE(blob.subspan(1), raw)) return false;
+
+        for (int i = 0; i < CHUNK_AREA; i++) {
+            cells[i].type     = static_cast<TileType>(raw[i]);
+            cells[i].flags    = static_cast<int8_t>(raw[i + CHUNK_AREA]);
+            cells[i].resource = static_cast<int8_t>(raw[i + CHUNK_AREA * 2]);
+        }
+        out.assignCells(cells);
+        readElevation(raw + CHUNK_AREA * 3, out);
+        return true;
+    }
+
+    if (blob[0] != CHUNK_VERSION_PALETTE || blob.size() < 5) return false;
+
+    uint32_t rawSize = 0;
+    std::memcpy(&rawSize, blob.data() + 1, sizeof(rawSize));
+    if (rawSize < 4 || rawSize > RAW_V1_SIZE + 4) return false;
+
+    std::vector<uint8_t> raw(rawSize);
+    if (!Compression::unpackRLE(blob.subspan(5), raw)) return false;
+
+    const auto   storage     = static_cast<ChunkStorage>(raw[0]);
+    const int    bits        = raw[1];
+    const size_t paletteSize = raw[2] | (raw[3] << 8);
+    size_t       at          = 4;
+
+    if (storage == ChunkStorage::Full) {
+        if (rawSize != 4 + CHUNK_AREA * 5) return false;
+        for (int i = 0; i < CHUNK_AREA; i++) {
+            cells[i].type     = static_cast<TileType>(raw[at + i]);
+            cells[i].flags    = static_cast<int8_t>(raw[at + i + CHUNK_AREA]);
+            cells[i].resource = static_cast<int8_t>(raw[at + i + CHUNK_AREA * 2]);
+        }
+        at += CHUNK_AREA * 3;
+    } else {
+        const size_t indexBytes = CHUNK_AREA * bits / 8;
+        if (paletteSize == 0 || bits > 8 || rawSize != 4 + paletteSize * 3 + indexBytes + CHUNK_AREA * 2)
+            return false;
+
+        std::vector<TileCell> palette(paletteSize);
+        for (size_t p = 0; p < paletteSize; p++, at += 3)
+            palette[p] = { static_cast<TileType>(raw[at]), static_cast<int8_t>(raw[at + 1]),
+                           static_cast<int8_t>(raw[at + 2]) };
+
+        for (int i = 0; i < CHUNK_AREA; i++) {
+            size_t idx = 0;
+            if (bits > 0) {
+                const int bit = i * bits;
+                idx = (raw[at + (bit >> 3)] >> (bit & 7)) & ((1 << bits) - 1);
+            }
+            if (idx >= paletteSize) return false;
+            cells[i] = palette[idx];
+        }
+        at += indexBytes;
+    }
+
+    out.assignCells(cells);
+    readElevation(raw.data() + at, out);
+    return true;
+}
+
+// =====================
+// DELTA CODEC
+// =====================
+// Blob: [u8 version][u16 count] then per entry [u16 index][u8 type][u8 flags][u8 resource]
+// Deltas are a handful of entries, not worth compressing.
+
+void RegionStore::encodeDelta(const ChunkDelta& delta, std::vector<uint8_t>& out) {
+    const auto count = static_cast<uint16_t>(delta.size());
+    out.push_back(CHUNK_VERSION_DELTA);
+    out.push_back(static_cast<uint8_t>(count & 0xFF));
+    out.push_back(static_cast<uint8_t>(count >> 8));
+
+    for (const ChunkDelta::Entry& e : delta.entries()) {
+        out.push_back(static_cast<uint8_t>(e.index & 0xFF));
+        out.push_back(static_cast<uint8_t>(e.index >> 8));
+        out.push_back(static_cast<uint8_t>(e.cell.type));
+        out.push_back(static_cast<uint8_t>(e.cell.flags));
+        out.push_back(static_cast<uint8_t>(e.cell.resource));
+    }
+}
+
+bool RegionStore::decodeDelta(std::span<const uint8_t> blob, ChunkDelta& out) {
+    if (blob.size() < 3 || blob[0] != CHUNK_VERSION_DELTA) return false;
+
+    const size_t count = blob[1] | (blob[2] << 8);
+    if (count > CHUNK_AREA || blob.size() != 3 + count * DELTA_ENTRY_SIZE) return false;
+
+    out.clear();
+    for (size_t i = 0, at = 3; i < count; i++, at += DELTA_ENTRY_SIZE) {
+        const int index = blob[at] | (blob[at + 1] << 8);
+        if (index >= CHUNK_AREA) return false;
+        out.set(index, { static_cast<TileType>(blob[at + 2]), static_cast<int8_t>(blob[at + 3]),
+                         static_cast<int8_t>(blob[at + 4]) });
+    }
+    return true;
+}
+
+// =====================
+// REGION STORE
+// =====================
+
+RegionStore::RegionStore(std::string directory) : directory(std::move(directory)) {
+    std::error_code ec;
+    std::filesystem::create_directories(this->directory, ec);
+    if (ec)
+        LOG_ERROR(World, "Cannot create region directory {}: {}", this->directory, ec.message());
+}
+
+ChunkPos RegionStore::regionOf(ChunkPos pos) {
+    return { floorDiv(pos.x, REGION_SIZE), floorDiv(pos.y, REGION_SIZE) };
+}
+
+int RegionStore::slotOf(ChunkPos pos) {
+    const int lx = pos.x - floorDiv(pos.x, REGION_SIZE) * REGION_SIZE;
+    const int ly = pos.y - floorDiv(pos.y, REGION_SIZE) * REGION_SIZE;
+    return ly * REGION_SIZE + lx;
+}
+
+std::string RegionStore::regionPath(ChunkPos region) const {
+    return (std::filesystem::path(directory) /
+            ("r." + std::to_string(region.x) + "." + std::to_string(region.y) + ".bin")).string();
+}
+
+const RegionStore::Region& RegionStore::mapRegion(ChunkPos region) const {
+    auto it = regions.find(region);
+    if (it != regions.end())
+        return it->second;
+
+    Region& r = regions[region];
+    if (r.file.open(regionPath(region))) {
+        const auto bytes = r.file.bytes();
+        RegionHeader header{};
+        if (bytes.size() < DATA_OFFSET) {
+            r.file.close();
+        } else {
+            std::memcpy(&header, bytes.data(), sizeof(header));
+            if (std::memcmp(header.magic, REGION_MAGIC, 4) != 0 ||
+                header.version != REGION_VERSION || header.regionSize != REGION_SIZE) {
+                LOG_WARN(World, "Ignoring incompatible region file {}", regionPath(region));
+                r.file.close();
+            }
+        }
+    }
+    return r;
+}
+
+std::span<const uint8_t> RegionStore::findBlob(ChunkPos pos) const {
+    const Region& region = mapRegion(regionOf(pos));
+    if (!region.file.isOpen()) return {};
+
+    const auto bytes = region.file.bytes();
+    RegionIndexEntry entry{};
+    std::memcpy(&entry, bytes.data() + INDEX_OFFSET + slotOf(pos) * sizeof(RegionIndexEntry), sizeof(entry));
+
+    if (!blobInFile(entry, bytes.size())) return {};
+    return bytes.subspan(entry.offset, entry.size);
+}
+
+bool RegionStore::contains(ChunkPos pos) const {
+    std::lock_guard lock(mutex);
+    return !findBlob(pos).empty();
+}
+
+bool RegionStore::load(ChunkPos pos, Chunk& out) const {
+    std::lock_guard lock(mutex);
+    const auto blob = findBlob(pos);
+    if (blob.empty() || !decodeChunk(blob, out)) return false;
+
+    out.summarizeOres();
+    out.pos       = pos;
+    out.generated = true;
+    out.modified  = false;
+    out.dirty     = true;
+    return true;
+}
+
+bool RegionStore::loadDelta(const Chunk& generated, ChunkDelta& out) const {
+    std::lock_guard lock(mutex);
+    const auto blob = findBlob(generated.pos);
+    if (blob.empty()) return false;
+
+    if (blob[0] == CHUNK_VERSION_DELTA)
+        return decodeDelta(blob, out);
+
+    // Full chunk written before deltas existed: keep only what differs
+    Chunk stored(generated.pos);
+    if (!decodeChunk(blob, stored)) return false;
+    out = ChunkDelta::diff(generated, stored);
+    return true;
+}
+
+bool RegionStore::save(const Chunk& chunk) {
+    std::vector<uint8_t> blob;
+    encodeChunk(chunk, blob);
+    return writeBlob(chunk.pos, blob);
+}
+
+bool RegionStore::saveDelta(ChunkPos pos, const ChunkDelta& delta) {
+    std::vector<uint8_t> blob;
+    encodeDelta(delta, blob);
+    return writeBlob(pos, blob);
+}
+
+bool RegionStore::writeBlob(ChunkPos pos, const std::vector<uint8_t>& blob) {
+    const ChunkPos    region = regionOf(pos);
+    const std::string path   = regionPath(region);
+
+    std::lock_guard lock(mutex);
+    regions.erase(region); // unmapped here, remapped by the next read
+
+    if (!std::filesystem::exists(path)) {
+        std::ofstream create(path, std::ios::binary);
+        RegionHeader header{};
+        std::memcpy(header.magic, REGION_MAGIC, 4);
+        header.version    = REGION_VERSION;
+        header.regionSize = REGION_SIZE;
+        create.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+        const std::vector<RegionIndexEntry> index(REGION_AREA, RegionIndexEntry{ 0, 0 });
+        create.write(reinterpret_cast<const char*>(index.data()), index.size() * sizeof(RegionIndexEntry));
+        if (!create) return false;
+    }
+
+    std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+    if (!file.is_open()) {
+        LOG_ERROR(World, "Cannot open region file {} for writing", path);
+        return false;
+    }
+
+    std::vector<RegionIndexEntry> index(REGION_AREA);
+    file.seekg(INDEX_OFFSET);
+    file.read(reinterpret_cast<char*>(index.data()), index.size() * sizeof(RegionIndexEntry));
+    file.seekg(0, std::ios::end);
+    const uint64_t fileSize = static_cast<uint64_t>(file.tellg());
+    if (!file) {
+        LOG_ERROR(World, "Cannot read region file {}", path);
+        return false;
+    }
+
+    const int         slot  = slotOf(pos);
+    RegionIndexEntry& entry = index[slot];
+
+    if (entry.size >= blob.size() && blobInFile(entry, fileSize)) {
+        // Fits where the old blob was, overwrite it. Its unused tail is dead
+        // space until the region is compacted
+        file.seekp(entry.offset);
+        entry.size = static_cast<uint32_t>(blob.size());
+    } else {
+        // Append, the old blob (if any) becomes dead space. Compact instead
+        // once that is mostly what the file holds, or when the new end would
+        // not fit a 32 bit offset
+        uint64_t kept = 0;
+        for (int i = 0; i < REGION_AREA; i++)
+            if (i != slot && blobInFile(index[i], fileSize)) kept += index[i].size;
+        const uint64_t used = fileSize - std::min<uint64_t>(fileSize, DATA_OFFSET);
+        const uint64_t dead = used - std::min(used, kept);
+
+        if ((dead > COMPACT_MIN_DEAD && dead > kept + blob.size()) || fileSize + blob.size() > MAX_REGION_BYTES)
+            return compactRegion(path, file, fileSize, index, slot, blob);
+
+        file.seekp(0, std::ios::end);
+        entry = { static_cast<uint32_t>(fileSize), static_cast<uint32_t>(blob.size()) };
+    }
+    file.write(reinterpret_cast<const char*>(blob.data()), blob.size());
+
+    file.seekp(INDEX_OFFSET + slot * sizeof(RegionIndexEntry));
+    file.write(reinterpret_cast<const char*>(&entry), sizeof(entry));
+    return static_cast<bool>(file);
+}
@@ -0,0 +1,79 @@
+#ifndef REGIONFILE_H
+#define REGIONFILE_H
+
+#include "chunk.h"
+#include "chunkdelta.h"
+#include "../../utils/mappedfile.h"
+#include <mutex>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// =====================
+// REGION STORE
+// =====================
+// Persists chunks on disk, REGION_SIZE x REGION_SIZE chunks per file.
+//
+// File layout (little-endian):
+//   RegionHeader                       magic, version, region size
+//   RegionIndexEntry[REGION_AREA]      offset / size of each chunk blob, 0 = absent
+//   chunk blobs                        full chunk or edit delta
+//
+// A rewritten chunk reuses its old blob's bytes when the new blob fits and
+// is appended otherwise. When dead bytes outgrow the live ones the region
+// is rewritten packed; a write that would take the file past 4 GiB fails.
+//
+// Reads go through a read-only memory mapping of the region file and are
+// safe from any thread. Writes happen on the owning (main) thread and drop
+// the mapping of the region they touch.
+class RegionStore {
+public:
+    static constexpr int REGION_SIZE = 32;
+    static constexpr int REGION_AREA = REGION_SIZE * REGION_SIZE;
+
+    explicit RegionStore(std::string directory);
+
+    // Fill `out` from disk, false if the chunk was never saved as a full chunk
+    bool load(ChunkPos pos, Chunk& out) const;
+    bool contains(ChunkPos pos) const;
+
+    // Write (or rewrite) a chunk, returns false on I/O error
+    bool save(const Chunk& chunk);
+
+    // Edits of a chunk relative to `generated` (its generator output, pos
+    // set). Full chunk blobs are diffed against it. False if never saved.
+    bool loadDelta(const Chunk& generated, ChunkDelta& out) const;
+    // Write (or rewrite) the edits of a chunk in place of a full blob
+    bool saveDelta(ChunkPos pos, const ChunkDelta& delta);
+
+    const std::string& getDirectory() const { return directory; }
+
+    // Chunk blob codec, also usable for other containers
+    static void encodeChunk(const Chunk& chunk, std::vector<uint8_t>& out);
+    static bool decodeChunk(std::span<const uint8_t> blob, Chunk& out);
+    static void encodeDelta(const ChunkDelta& delta, std::vector<uint8_t>& out);
+    static bool decodeDelta(std::span<const uint8_t> blob, ChunkDelta& out);
+
+private:
+    struct Region {
+        MappedFile file;    // not open when the file does not exist yet
+    };
+
+    std::string directory;
+
+    mutable std::mutex                                           mutex;
+    mutable std::unordered_map<ChunkPos, Region, ChunkPosHash>   regions; // by region coords
+
+    static ChunkPos regionOf(ChunkPos pos);
+    static int      slotOf(ChunkPos pos);
+    std::string     regionPath(ChunkPos region) const;
+
+    // Requires `mutex`
+    const Region&                 mapRegion(ChunkPos region) const;
+    std::span<const uint8_t>      findBlob(ChunkPos pos) const;
+
+    bool writeBlob(ChunkPos pos, const std::vector<uint8_t>& blob);
+};
+
+#endif // REGIONFILE_H
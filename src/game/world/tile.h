@@ -6,6 +6,7 @@
 #include <functional>
 
 static const int8_t CHUNK_SIZE = 32;
+static const int    CHUNK_AREA = CHUNK_SIZE * CHUNK_SIZE;
 
 // =====================
 // TILE FLAGS
@@ -165,34 +166,6 @@ struct WorldPos {
     }
 };
 
-// =====================
-// CHUNK
-// =====================
-struct Chunk {
-    ChunkPos pos;
-    Tile     tiles[CHUNK_SIZE][CHUNK_SIZE];
-    bool     dirty     = true;
-    bool     generated = false;
-
-    Chunk() = default;
-    explicit Chunk(ChunkPos pos) : pos(pos) {}
-
-    Tile&       getTile(TilePos p)             { return tiles[p.y][p.x]; }
-    const Tile& getTile(TilePos p)       const { return tiles[p.y][p.x]; }
-    Tile&       getTile(int8_t x, int8_t y)             { return tiles[y][x]; }
-    const Tile& getTile(int8_t x, int8_t y)       const { return tiles[y][x]; }
-
-    void fill(TileType type, int8_t flags = 0) {
-        for (int y = 0; y < CHUNK_SIZE; y++)
-            for (int x = 0; x < CHUNK_SIZE; x++) {
-                tiles[y][x].type  = type;
-                tiles[y][x].flags = flags == 0
-                    ? Tile::defaultFlags(type)
-                    : flags;
-            }
-    }
-};
-
 // =====================
 // TILESET UV
 // =====================
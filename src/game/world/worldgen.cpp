@@ -1,5 +1,7 @@
 #include "worldgen.h"
+#include <algorithm>
 #include <cmath>
+#include <cstring>
 #include <iostream>
 
 // =====================
@@ -8,113 +10,153 @@
 
 WorldGen::WorldGen(int32_t seed) : seed(seed) {
     auto elevSimplex = FastNoise::New<FastNoise::Simplex>();
-    elevationNoise   = FastNoise::New<FastNoise::FractalFBm>();
-    elevationNoise->SetSource(elevSimplex);
-    elevationNoise->SetOctaveCount(4);
-    elevationNoise->SetGain(0.4f);
-    elevationNoise->SetLacunarity(2.0f);
+    auto elevFractal = FastNoise::New<FastNoise::FractalFBm>();
+    elevFractal->SetSource(elevSimplex);
+    elevFractal->SetOctaveCount(4);
+    elevFractal->SetGain(0.4f);
+    elevFractal->SetLacunarity(2.0f);
+    elevationNoise = FastNoise::New<FastNoise::DomainScale>();
+    elevationNoise->SetSource(elevFractal);
+    elevationNoise->SetScale(ELEVATION_FREQUENCY);
 
     auto resSimplex = FastNoise::New<FastNoise::Simplex>();
-    resourceNoise   = FastNoise::New<FastNoise::FractalFBm>();
-    resourceNoise->SetSource(resSimplex);
-    resourceNoise->SetOctaveCount(3);
-    resourceNoise->SetGain(0.6f);
-    resourceNoise->SetLacunarity(2.5f);
+    auto resFractal = FastNoise::New<FastNoise::FractalFBm>();
+    resFractal->SetSource(resSimplex);
+    resFractal->SetOctaveCount(3);
+    resFractal->SetGain(0.6f);
+    resFractal->SetLacunarity(2.5f);
+    resourceNoise = FastNoise::New<FastNoise::DomainScale>();
+    resourceNoise->SetSource(resFractal);
+    resourceNoise->SetScale(RESOURCE_FREQUENCY);
 
     auto forSimplex = FastNoise::New<FastNoise::Simplex>();
-    forestNoise     = FastNoise::New<FastNoise::FractalFBm>();
-    forestNoise->SetSource(forSimplex);
-    forestNoise->SetOctaveCount(4);
-    forestNoise->SetGain(0.5f);
-    forestNoise->SetLacunarity(2.0f);
+    auto forFractal = FastNoise::New<FastNoise::FractalFBm>();
+    forFractal->SetSource(forSimplex);
+    forFractal->SetOctaveCount(4);
+    forFractal->SetGain(0.5f);
+    forFractal->SetLacunarity(2.0f);
+    forestNoise = FastNoise::New<FastNoise::DomainScale>();
+    forestNoise->SetSource(forFractal);
+    forestNoise->SetScale(FOREST_FREQUENCY);
 }
 
 void WorldGen::generateChunk(Chunk& chunk) const {
-    const int     size         = CHUNK_SIZE;
-    const int     area         = size * size;
-    const int32_t worldOffsetX = chunk.pos.x * size;
-    const int32_t worldOffsetY = chunk.pos.y * size;
+    Chunk* chunks[1] = { &chunk };
+    generateRegion(chunk.pos, 1, 1, chunks);
+}
+
+void WorldGen::generateRegion(ChunkPos origin, int w, int h,
+                              std::span<Chunk* const> chunks) const {
+    const int size    = CHUNK_SIZE;
+    const int regionW = w * size;
+    const int regionH = h * size;
+    const int area    = regionW * regionH;
 
-    std::vector<float> elevationMap(area);
-    std::vector<float> resourceMap(area);
-    std::vector<float> forestMap(area);
+    // Scratch grids are reused per thread, only grow when a bigger region comes in
+    thread_local std::vector<float> elevationMap;
+    thread_local std::vector<float> resourceMap;
+    thread_local std::vector<float> forestMap;
+    elevationMap.resize(area);
+    resourceMap.resize(area);
+    forestMap.resize(area);
 
-    const float stepSize = 0.2f;
-    const float noiseOffsetX = chunk.pos.x * CHUNK_SIZE * stepSize;
-    const float noiseOffsetY = chunk.pos.y * CHUNK_SIZE * stepSize;
+    // Integer tile coordinates are exact in float, so the samples of a
+    // tile do not depend on the region origin (frequency is in the nodes)
+    const float startX = static_cast<float>(origin.x * CHUNK_SIZE);
+    const float startY = static_cast<float>(origin.y * CHUNK_SIZE);
 
     elevationNoise->GenUniformGrid2D(
         elevationMap.data(),
-        noiseOffsetX, noiseOffsetY,
-        size, size,
-        stepSize, stepSize,
+        startX, startY,
+        regionW, regionH,
+        1.0f, 1.0f,
         seed
     );
 
     resourceNoise->GenUniformGrid2D(
         resourceMap.data(),
-        chunk.pos.x * CHUNK_SIZE * 0.05f,
-        chunk.pos.y * CHUNK_SIZE * 0.05f,
-        size, size,
-        0.05f, 0.05f,
+        startX, startY,
+        regionW, regionH,
+        1.0f, 1.0f,
         seed + 1
     );
 
     forestNoise->GenUniformGrid2D(
         forestMap.data(),
-        chunk.pos.x * CHUNK_SIZE * 0.03f,
-        chunk.pos.y * CHUNK_SIZE * 0.03f,
-        size, size,
-        0.03f, 0.03f,
+        startX, startY,
+        regionW, regionH,
+        1.0f, 1.0f,
         seed + 2
     );
 
-    for (int y = 0; y < size; y++) {
-        for (int x = 0; x < size; x++) {
-            int   idx      = y * size + x;
-            float elev     = elevationMap[idx];
-            float resource = resourceMap[idx];
-            float forest   = forestMap[idx];
-
-            Tile& tile = chunk.getTile(x, y);
-
-            // Store raw elevation for height rendering
-            tile.elevation = elev;
-
-            // Base type from elevation
-            tile.type  = elevationToType(elev);
-            tile.flags = Tile::defaultFlags(tile.type);
-
-            // Skip resource placement on water
-            if (tile.type == TileType::WARM_WATER ||
-                tile.type == TileType::WATER       ||
-                tile.type == TileType::DEEP_WATER)
-                continue;
-
-            // Ore placement
-            if (resource > IRON_THRESHOLD) {
-                tile.type  = TileType::IRON_ORE;
-                tile.flags = Tile::defaultFlags(tile.type);
-                tile.resource = static_cast<int8_t>(
-                    (resource - IRON_THRESHOLD) / (1.0f - IRON_THRESHOLD) * 127.0f
-                );
-            } else if (resource < -COPPER_THRESHOLD) {
-                tile.type  = TileType::COPPER_ORE;
-                tile.flags = Tile::defaultFlags(tile.type);
-                tile.resource = static_cast<int8_t>(
-                    (-resource - COPPER_THRESHOLD) / (1.0f - COPPER_THRESHOLD) * 127.0f
-                );
-            } else if (resource > AMETHYST_THRESHOLD * 0.8f &&
-                       forest   > AMETHYST_THRESHOLD * 0.6f) {
-                tile.type  = TileType::AMETHYST;
-                tile.flags = Tile::defaultFlags(tile.type);
-                tile.resource = static_cast<int8_t>(resource * 60.0f + 60.0f);
+    // Scatter the region grid back into its chunks (row-major, w x h)
+    for (int cy = 0; cy < h; cy++) {
+        for (int cx = 0; cx < w; cx++) {
+            Chunk& chunk = *chunks[cy * w + cx];
+            chunk.pos = ChunkPos(origin.x + cx, origin.y + cy);
+
+            // Classify into a flat cell buffer first so the chunk can pick
+            // its compact storage (single value / palette) in one go
+            TileCell   cells[CHUNK_AREA];
+            OreSummary ores;
+            auto       elevations = chunk.elevations();
+
+            for (int y = 0; y < size; y++) {
+                const int row = (cy * size + y) * regionW + cx * size;
+                for (int x = 0; x < size; x++) {
+                    const int  idx  = row + x;
+                    const Tile tile = classifyTile(elevationMap[idx], resourceMap[idx], forestMap[idx]);
+                    const int  i    = Chunk::index(x, y);
+                    cells[i]      = { tile.type, tile.flags, tile.resource };
+                    elevations[i] = Chunk::quantizeElevation(tile.elevation);
+                    ores.add(x, y, cells[i]);
+                }
             }
+            chunk.assignCells(cells);
+            chunk.ores = ores;
+
+            chunk.generated = true;
+            chunk.dirty     = true;
         }
     }
+}
+
+Tile WorldGen::classifyTile(float elev, float resource, float forest) const {
+    Tile tile;
+
+    // Store raw elevation for height rendering
+    tile.elevation = elev;
+
+    // Base type from elevation
+    tile.type  = elevationToType(elev);
+    tile.flags = Tile::defaultFlags(tile.type);
+
+    // Skip resource placement on water
+    if (tile.type == TileType::WARM_WATER ||
+        tile.type == TileType::WATER       ||
+        tile.type == TileType::DEEP_WATER)
+        return tile;
 
-    chunk.generated = true;
-    chunk.dirty     = true;
+    // Ore placement
+    if (resource > IRON_THRESHOLD) {
+        tile.type  = TileType::IRON_ORE;
+        tile.flags = Tile::defaultFlags(tile.type);
+        tile.resource = static_cast<int8_t>(
+            (resource - IRON_THRESHOLD) / (1.0f - IRON_THRESHOLD) * 127.0f
+        );
+    } else if (resource < -COPPER_THRESHOLD) {
+        tile.type  = TileType::COPPER_ORE;
+        tile.flags = Tile::defaultFlags(tile.type);
+        tile.resource = static_cast<int8_t>(
+            (-resource - COPPER_THRESHOLD) / (1.0f - COPPER_THRESHOLD) * 127.0f
+        );
+    } else if (resource > AMETHYST_THRESHOLD * 0.8f &&
+               forest   > AMETHYST_THRESHOLD * 0.6f) {
+        tile.type  = TileType::AMETHYST;
+        tile.flags = Tile::defaultFlags(tile.type);
+        tile.resource = static_cast<int8_t>(resource * 60.0f + 60.0f);
+    }
+    return tile;
 }
 
 TileType WorldGen::elevationToType(float e) const {
@@ -131,21 +173,197 @@ TileType WorldGen::elevationToType(float e) const {
 // CHUNK MANAGER
 // =====================
 
-ChunkManager::ChunkManager(int32_t seed) : worldGen(seed) {}
+ChunkManager::ChunkManager(int32_t seed)
+    : ChunkManager(ChunkManagerConfig{ seed }) {}
+
+ChunkManager::ChunkManager(const ChunkManagerConfig& config)
+    : worldGen(config.seed),
+      store(config.saveDirectory.empty() ? nullptr : std::make_unique<RegionStore>(config.saveDirectory)),
+      genService(std::make_unique<ChunkGenService>(worldGen, config.workerCount)) {}
+
+ChunkManager::~ChunkManager() {
+    saveModifiedChunks();
+}
 
 Chunk& ChunkManager::getChunk(ChunkPos pos) {
-    auto it = chunks.find(pos);
-    if (it != chunks.end())
-        return it->second;
+    ChunkHandle handle = chunks.find(pos);
+    if (handle == INVALID_CHUNK)
+        handle = chunks.acquire(pos);
+
+    Chunk& chunk = chunks.get(handle);
+    if (!chunk.isReady()) {
+        // Caller needs the tiles now, don't wait for the pool
+        genService->cancel(pos);
+        worldGen.generateChunk(chunk);
+        finishChunk(chunk);
+    }
+    return chunk;
+}
+
+Tile ChunkManager::getTile(int32_t absX, int32_t absY) {
+    const WorldPos wp = WorldPos::fromAbs(absX, absY);
+    return getChunk(wp.chunk).getTile(wp.tile);
+}
+
+void ChunkManager::setTile(int32_t absX, int32_t absY, const Tile& tile) {
+    const WorldPos wp     = WorldPos::fromAbs(absX, absY);
+    Chunk&         chunk  = getChunk(wp.chunk);
+    const int      i      = Chunk::index(wp.tile.x, wp.tile.y);
+    const TileCell before = chunk.getCell(i);
+    const TileCell after{ tile.type, tile.flags, tile.resource };
 
-    Chunk chunk(pos);
-    worldGen.generateChunk(chunk);
-    chunks.emplace(pos, std::move(chunk));
-    return chunks.at(pos);
+    chunk.setTile(wp.tile, tile);
+    chunk.modified = true;
+    chunk.dirty    = true;
+    deltas[wp.chunk].set(i, after);
+
+    if (oreSlot(before.type) < 0 && oreSlot(after.type) < 0) return;
+
+    if (before.type == after.type) {
+        // Depletion / refill: only the amount moves
+        OreStats& s = chunk.ores.ores[oreSlot(after.type)];
+        s.resource = s.resource - static_cast<uint8_t>(before.resource) + static_cast<uint8_t>(after.resource);
+    } else if (oreSlot(before.type) < 0) {
+        chunk.ores.add(wp.tile.x, wp.tile.y, after);
+    } else {
+        // An ore tile went away, its box may shrink
+        chunk.summarizeOres();
+    }
+    ores.set(wp.chunk, chunk.ores);
+}
+
+const ChunkDelta* ChunkManager::findDelta(ChunkPos pos) const {
+    auto it = deltas.find(pos);
+    return it != deltas.end() ? &it->second : nullptr;
+}
+
+void ChunkManager::finishChunk(Chunk& chunk) {
+    restoreEdits(chunk);
+    ores.set(chunk.pos, chunk.ores);
+    chunk.state = ChunkState::Ready;
+    chunk.dirty = true;
+}
+
+void ChunkManager::restoreEdits(Chunk& chunk) {
+    auto it = deltas.find(chunk.pos);
+    if (it == deltas.end()) {
+        // First time this chunk is seen this session, edits may be on disk
+        ChunkDelta delta;
+        if (!store || !store->loadDelta(chunk, delta)) return;
+        it = deltas.emplace(chunk.pos, std::move(delta)).first;
+    }
+    if (it->second.empty()) return;
+
+    // The generator summary no longer matches once edits are applied
+    it->second.apply(chunk);
+    chunk.summarizeOres();
+}
+
+void ChunkManager::saveModifiedChunks() {
+    if (!store) return;
+    for (ChunkHandle handle : chunks.live()) {
+        Chunk& chunk = chunks.get(handle);
+        if (!chunk.modified) continue;
+        if (store->saveDelta(chunk.pos, deltas[chunk.pos]))
+            chunk.modified = false;
+    }
+}
+
+void ChunkManager::saveDeltas(std::vector<uint8_t>& out) const {
+    auto put = [&](const void* data, size_t size) {
+        const auto* bytes = static_cast<const uint8_t*>(data);
+        out.insert(out.end(), bytes, bytes + size);
+    };
+
+    uint32_t count = 0;
+    for (const auto& [pos, delta] : deltas)
+        count += delta.empty() ? 0 : 1;
+    put(&count, sizeof(count));
+
+    std::vector<uint8_t> blob;
+    for (const auto& [pos, delta] : deltas) {
+        if (delta.empty()) continue;
+        blob.clear();
+        RegionStore::encodeDelta(delta, blob);
+        const auto size = static_cast<uint32_t>(blob.size());
+        put(&pos.x, sizeof(pos.x));
+        put(&pos.y, sizeof(pos.y));
+        put(&size, sizeof(size));
+        put(blob.data(), blob.size());
+    }
+}
+
+bool ChunkManager::loadDeltas(std::span<const uint8_t> blob) {
+    size_t at   = 0;
+    auto   take = [&](void* out, size_t size) {
+        if (size > blob.size() - at) return false;
+        std::memcpy(out, blob.data() + at, size);
+        at += size;
+        return true;
+    };
+
+    uint32_t count = 0;
+    if (!take(&count, sizeof(count))) return false;
+
+    std::unordered_map<ChunkPos, ChunkDelta, ChunkPosHash> loaded;
+    for (uint32_t i = 0; i < count; i++) {
+        ChunkPos pos;
+        uint32_t size = 0;
+        if (!take(&pos.x, sizeof(pos.x)) || !take(&pos.y, sizeof(pos.y)) || !take(&size, sizeof(size))) return false;
+        if (size > blob.size() - at) return false;
+        if (!RegionStore::decodeDelta(blob.subspan(at, size), loaded[pos])) return false;
+        at += size;
+    }
+    if (at != blob.size()) return false;
+
+    deltas = std::move(loaded);
+
+    // Loaded chunks carry the old edits: drop them, the next update requests them again
+    std::span<const ChunkHandle> live = chunks.live();
+    for (size_t i = live.size(); i-- > 0;) {
+        const Chunk& chunk = chunks.get(live[i]);
+        if (!chunk.isReady())
+            genService->cancel(chunk.pos);
+        chunks.release(live[i]);
+        live = chunks.live();
+        streaming.chunksUnloaded++;
+    }
+    streamRadius = -1;
+    return true;
+}
+
+size_t ChunkManager::residentBytes() const {
+    size_t bytes = 0;
+    for (ChunkHandle handle : chunks.live())
+        bytes += chunks.get(handle).memoryUsage();
+    return bytes;
+}
+
+size_t ChunkManager::deltaBytes() const {
+    size_t bytes = 0;
+    for (const auto& [pos, delta] : deltas)
+        bytes += delta.memoryUsage();
+    return bytes;
 }
 
 bool ChunkManager::hasChunk(ChunkPos pos) const {
-    return chunks.find(pos) != chunks.end();
+    return chunks.contains(pos);
+}
+
+void ChunkManager::collectFinishedChunks() {
+    genService->poll(finished);
+
+    for (auto& buffer : finished) {
+        const ChunkHandle handle = chunks.find(buffer->pos);
+        // Unloaded or generated synchronously while in flight — drop it
+        if (handle != INVALID_CHUNK && !chunks.get(handle).isReady()) {
+            Chunk& chunk = chunks.get(handle);
+            chunk        = std::move(*buffer);
+            finishChunk(chunk);
+        }
+        genService->recycle(std::move(buffer));
+    }
+    finished.clear();
 }
 
 void ChunkManager::updateLoadedChunks(float gridX, float gridY,
@@ -154,26 +372,119 @@ void ChunkManager::updateLoadedChunks(float gridX, float gridY,
         std::floor(gridX / CHUNK_SIZE));
     int32_t camChunkY = static_cast<int32_t>(
         std::floor(gridY / CHUNK_SIZE));
+    const ChunkPos center(camChunkX, camChunkY);
+
+    streaming.updates++;
+    collectFinishedChunks();
+
+    // Same chunk as last frame: the wanted set did not change
+    if (center == streamCenter && renderDistance == streamRadius) return;
 
-    for (int dy = -renderDistance; dy <= renderDistance; dy++)
-        for (int dx = -renderDistance; dx <= renderDistance; dx++) {
-            ChunkPos pos(camChunkX + dx, camChunkY + dy);
-            if (!hasChunk(pos))
-                getChunk(pos);
+    streamCenter = center;
+    streamRadius = renderDistance;
+    streaming.recomputes++;
+
+    genService->setFocus(center);
+    queueMissingChunks(center, renderDistance);
+
+    streaming.lastUnloads     = static_cast<uint32_t>(unloadDistantChunks(center, renderDistance + UNLOAD_MARGIN));
+    streaming.chunksUnloaded += streaming.lastUnloads;
+}
+
+void ChunkManager::queueMissingChunks(ChunkPos center, int renderDistance) {
+    auto want = [&](int32_t x, int32_t y) {
+        const ChunkPos pos(x, y);
+        if (hasChunk(pos)) return;
+
+        // Placeholder stays Pending until a worker hands the chunk back
+        chunks.acquire(pos);
+        missing.push_back(pos);
+    };
+
+    // Square spiral: ring 0 is the camera chunk, each ring walked edge by edge
+    want(center.x, center.y);
+    for (int r = 1; r <= renderDistance; r++) {
+        for (int i = -r; i < r; i++) want(center.x + i, center.y - r);    // bottom, west -> east
+        for (int i = -r; i < r; i++) want(center.x + r, center.y + i);    // right, south -> north
+        for (int i = r; i > -r; i--) want(center.x + i, center.y + r);    // top, east -> west
+        for (int i = r; i > -r; i--) want(center.x - r, center.y + i);    // left, north -> south
+    }
+
+    streaming.lastLoads        = static_cast<uint32_t>(missing.size());
+    streaming.chunksRequested += missing.size();
+    requestMissingChunks();
+}
+
+void ChunkManager::requestMissingChunks() {
+    if (missing.size() < static_cast<size_t>(REGION_MIN_MISSING)) {
+        for (const ChunkPos& pos : missing)
+            genService->request(pos);
+        missing.clear();
+        return;
+    }
+
+    auto blockOf = [](int32_t v) {
+        return v >= 0 ? v / REGION_BLOCK : (v - REGION_BLOCK + 1) / REGION_BLOCK;
+    };
+
+    // Sort so every aligned block is a contiguous run
+    std::sort(missing.begin(), missing.end(), [&](const ChunkPos& a, const ChunkPos& b) {
+        const int32_t ay = blockOf(a.y), by = blockOf(b.y);
+        if (ay != by) return ay < by;
+        return blockOf(a.x) < blockOf(b.x);
+    });
+
+    size_t begin = 0;
+    while (begin < missing.size()) {
+        const int32_t bx  = blockOf(missing[begin].x);
+        const int32_t by  = blockOf(missing[begin].y);
+        size_t        end = begin;
+
+        ChunkPos lo = missing[begin];
+        ChunkPos hi = missing[begin];
+        while (end < missing.size() && blockOf(missing[end].x) == bx && blockOf(missing[end].y) == by) {
+            lo.x = std::min(lo.x, missing[end].x); hi.x = std::max(hi.x, missing[end].x);
+            lo.y = std::min(lo.y, missing[end].y); hi.y = std::max(hi.y, missing[end].y);
+            end++;
         }
 
-    unloadDistantChunks(ChunkPos(camChunkX, camChunkY), renderDistance + 2);
+        if (end - begin >= static_cast<size_t>(REGION_MIN_MISSING)) {
+            // Chunks of the bounding box that are already loaded are generated
+            // with the block but not handed back; cancel drops the others one by one
+            const int w      = hi.x - lo.x + 1;
+            uint64_t  wanted = 0;
+            for (size_t i = begin; i < end; i++)
+                wanted |= uint64_t{ 1 } << ((missing[i].y - lo.y) * w + (missing[i].x - lo.x));
+            genService->requestRegion(lo, w, hi.y - lo.y + 1, wanted);
+        } else {
+            for (size_t i = begin; i < end; i++)
+                genService->request(missing[i]);
+        }
+        begin = end;
+    }
+    missing.clear();
 }
 
-void ChunkManager::unloadDistantChunks(ChunkPos center, int renderDistance) {
+size_t ChunkManager::unloadDistantChunks(ChunkPos center, int renderDistance) {
     // Also cleanup GPU data for unloaded chunks
-    auto it = chunks.begin();
-    while (it != chunks.end()) {
-        int32_t dx = std::abs(it->first.x - center.x);
-        int32_t dy = std::abs(it->first.y - center.y);
-        if (dx > renderDistance || dy > renderDistance)
-            it = chunks.erase(it);
-        else
-            ++it;
+    // Walk backwards: release() swaps the last live handle into the freed spot
+    size_t                       dropped = 0;
+    std::span<const ChunkHandle> live    = chunks.live();
+    for (size_t i = live.size(); i-- > 0;) {
+        const ChunkHandle handle = live[i];
+        Chunk&            chunk  = chunks.get(handle);
+        int32_t dx = std::abs(chunk.pos.x - center.x);
+        int32_t dy = std::abs(chunk.pos.y - center.y);
+        if (dx > renderDistance || dy > renderDistance) {
+            if (!chunk.isReady())
+                genService->cancel(chunk.pos);
+            // Only the delta outlives the chunk, written out if it changed
+            if (chunk.modified && store)
+                store->saveDelta(chunk.pos, deltas[chunk.pos]);
+            chunks.release(handle);
+            live = chunks.live();
+            dropped++;
+        }
     }
-}
\ No newline at end of file
+    return dropped;
+}
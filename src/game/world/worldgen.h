@@ -1,10 +1,18 @@
 #ifndef WORLDGEN_H
 #define WORLDGEN_H
 
-#include "tile.h"
+#include "chunk.h"
+#include "chunkdelta.h"
+#include "chunkgen.h"
+#include "chunkpool.h"
+#include "oreindex.h"
+#include "regionfile.h"
 #include <FastNoise/FastNoise.h>
 #include <unordered_map>
 #include <memory>
+#include <span>
+#include <string>
+#include <vector>
 
 class WorldGen {
 public:
@@ -13,13 +21,24 @@ public:
     // Generate a chunk at the given position
     void generateChunk(Chunk& chunk) const;
 
+    // Generate a w x h block of chunks starting at origin with one noise
+    // call per layer. chunks is row-major (w * h entries), positions are set.
+    void generateRegion(ChunkPos origin, int w, int h,
+                        std::span<Chunk* const> chunks) const;
+
 private:
     int32_t seed;
 
-    // Noise nodes
-    FastNoise::SmartNode<FastNoise::FractalFBm> elevationNoise;
-    FastNoise::SmartNode<FastNoise::FractalFBm> resourceNoise;
-    FastNoise::SmartNode<FastNoise::FractalFBm> forestNoise;
+    // Noise nodes, sampled at integer tile coordinates. Each fractal sits
+    // behind a DomainScale holding its frequency so a tile gets the exact
+    // same input whichever region it is generated with.
+    FastNoise::SmartNode<FastNoise::DomainScale> elevationNoise;
+    FastNoise::SmartNode<FastNoise::DomainScale> resourceNoise;
+    FastNoise::SmartNode<FastNoise::DomainScale> forestNoise;
+
+    static constexpr float ELEVATION_FREQUENCY = 0.2f;
+    static constexpr float RESOURCE_FREQUENCY  = 0.05f;
+    static constexpr float FOREST_FREQUENCY    = 0.03f;
 
     // In worldgen.h private section
     static constexpr float IRON_THRESHOLD     = 0.6f;
@@ -28,36 +47,123 @@ private:
 
     // Internal helpers
     TileType   elevationToType(float elevation)                    const;
-    void       applyResources(Chunk& chunk,
-                              const std::vector<float>& resourceMap,
-                              const std::vector<float>& elevationMap) const;
+    Tile       classifyTile(float elevation, float resource,
+                            float forest)                          const;
 };
 
 // =====================
 // CHUNK MANAGER
 // =====================
+struct ChunkManagerConfig {
+    int32_t     seed          = 1337;
+    int         workerCount   = 0;  // generation threads, <= 0 picks hardware_concurrency - 1
+    std::string saveDirectory;      // region files for chunk edits, empty = no persistence
+};
+
+// Streaming counters, the wanted set is only recomputed when the camera
+// enters another chunk (or the render distance changes)
+struct ChunkStreamStats {
+    uint64_t updates         = 0;   // updateLoadedChunks calls
+    uint64_t recomputes      = 0;   // of which crossed a chunk boundary
+    uint64_t chunksRequested = 0;   // total load deltas
+    uint64_t chunksUnloaded  = 0;   // total unload deltas
+    uint32_t lastLoads       = 0;   // deltas of the most recent recompute
+    uint32_t lastUnloads     = 0;
+};
+
 class ChunkManager {
 public:
     explicit ChunkManager(int32_t seed = 1337);
+    explicit ChunkManager(const ChunkManagerConfig& config);
+    ~ChunkManager();
 
-    // Get or generate a chunk
+    // Get or generate a chunk (synchronously if still pending), edits reapplied
     Chunk& getChunk(ChunkPos pos);
     bool   hasChunk(ChunkPos pos) const;
 
-    // Load chunks around a world position (camera)
+    // Tile access in absolute tile coordinates. setTile records the cell in
+    // the chunk's delta; elevation edits are not kept across reloads.
+    Tile getTile(int32_t absX, int32_t absY);
+    void setTile(int32_t absX, int32_t absY, const Tile& tile);
+
+    // Edits of a chunk since generation (loaded or not), null if untouched
+    const ChunkDelta* findDelta(ChunkPos pos) const;
+
+    // Ore summaries of every chunk generated so far, kept current by setTile
+    const OreIndex& oreIndex() const { return ores; }
+
+    // Write the delta of every loaded modified chunk to the region store
+    void saveModifiedChunks();
+
+    // Every edit known this session, for world snapshots. Blob layout:
+    // [u32 count] then [i32 x][i32 y][u32 size][delta blob] per edited chunk
+    void saveDeltas(std::vector<uint8_t>& out) const;
+    // Replace the known edits and drop the loaded chunks, streamed back in
+    // with the new edits. Chunks without a delta in the blob still read
+    // theirs from the region store. False (nothing changed) if malformed
+    bool loadDeltas(std::span<const uint8_t> blob);
+
+    // Load chunks around a world position (camera). Missing chunks are
+    // requested from the worker pool (nearest ring first) and show up as
+    // Pending until ready. Only finished chunks are collected while the
+    // camera stays in the same chunk.
     void updateLoadedChunks(float worldX, float worldY,
                             float tileSize, int renderDistance);
 
-    // Unload chunks far from camera
-    void unloadDistantChunks(ChunkPos center, int renderDistance);
+    // Unload chunks far from camera, returns how many were dropped
+    size_t unloadDistantChunks(ChunkPos center, int renderDistance);
+
+    const ChunkStreamStats& streamStats() const { return streaming; }
+
+    // Handles of every loaded chunk (Pending included), densely packed.
+    // Handles stay valid until the chunk is unloaded.
+    std::span<const ChunkHandle> loadedChunks() const { return chunks.live(); }
+    const Chunk&                 chunkAt(ChunkHandle handle) const { return chunks.get(handle); }
+    Chunk&                       chunkAt(ChunkHandle handle) { return chunks.get(handle); }
+    ChunkHandle                  findChunk(ChunkPos pos) const { return chunks.find(pos); }
 
-    const std::unordered_map<ChunkPos, Chunk, ChunkPosHash>& getChunks() const {
-        return chunks;
-    }
+    ChunkGenStats genStats() const { return genService->stats(); }
+
+    // Bytes held by loaded chunks (headers + tile storage)
+    size_t residentBytes() const;
+    // Bytes held by the deltas of every edited chunk
+    size_t deltaBytes() const;
 
 private:
     WorldGen worldGen;
-    std::unordered_map<ChunkPos, Chunk, ChunkPosHash> chunks;
+    ChunkPool                    chunks;
+    std::unique_ptr<RegionStore> store;   // null without a save directory
+
+    // Authoritative edits: chunk = generator output + delta. Kept for
+    // unloaded chunks too, filled lazily from the store on first load.
+    std::unordered_map<ChunkPos, ChunkDelta, ChunkPosHash> deltas;
+    OreIndex                                               ores;
+
+    // Missing chunks are grouped into aligned REGION_BLOCK x REGION_BLOCK
+    // blocks, a block with at least REGION_MIN_MISSING holes is generated
+    // in one batched noise pass (startup, teleports)
+    static constexpr int REGION_BLOCK       = 4;
+    static constexpr int REGION_MIN_MISSING = 6;
+
+    // Chunks are loaded within renderDistance but only dropped beyond
+    // renderDistance + UNLOAD_MARGIN, so a camera going back and forth
+    // over a border does not reload the same row
+    static constexpr int UNLOAD_MARGIN = 2;
+
+    ChunkPos         streamCenter;
+    int              streamRadius = -1;     // -1 until the first update
+    ChunkStreamStats streaming;
+
+    // Declared last: workers reference worldGen and must stop first
+    std::unique_ptr<ChunkGenService>    genService;
+    std::vector<std::unique_ptr<Chunk>> finished;
+    std::vector<ChunkPos>               missing;
+
+    void collectFinishedChunks();
+    void finishChunk(Chunk& chunk);     // edits + ore index, then Ready
+    void restoreEdits(Chunk& chunk);
+    void queueMissingChunks(ChunkPos center, int renderDistance);
+    void requestMissingChunks();
 };
 
 #endif // WORLDGEN_H
\ No newline at end of file
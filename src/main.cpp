@@ -2,7 +2,7 @@
 
 int main(int argc, char* argv[]) {
 
-    std::cerr << "MAIN STARTED" << std::endl; // add this
+    LOG_INFO(Core, "Main started");
 
     FileManager::SetBasePath(
         std::filesystem::canonical(argv[0]).parent_path().string()
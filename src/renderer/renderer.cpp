@@ -35,7 +35,7 @@ Renderer::~Renderer() {
 
 int Renderer::init() {
     if (!glfwInit()) {
-        std::cerr << "failed to Init GLFW" << std::endl;
+        LOG_ERROR(Renderer, "Failed to initialize GLFW");
         return false;
     }
 
@@ -45,7 +45,7 @@ int Renderer::init() {
 
     window = glfwCreateWindow(width, height, "My Game", nullptr, nullptr);
     if (!window) {
-        std::cerr << "failed to Create window" << std::endl;
+        LOG_ERROR(Renderer, "Failed to create the window");
         glfwTerminate();
         return false;
     }
@@ -53,7 +53,7 @@ int Renderer::init() {
     glfwMakeContextCurrent(window);
 
     if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
-        std::cerr << "failed to Load Glad" << std::endl;
+        LOG_ERROR(Renderer, "Failed to load GL functions (glad)");
         return false;
     }
 
@@ -129,9 +129,9 @@ void Renderer::initPixelFBO() {
     glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depthRBO);
 
     if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
-        std::cerr << "[PIXEL FBO] Not complete!" << std::endl;
+        LOG_ERROR(Renderer, "Pixel FBO not complete");
     else
-        std::cerr << "[PIXEL FBO] Complete OK" << std::endl;
+        LOG_DEBUG(Renderer, "Pixel FBO complete");
 
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
@@ -155,9 +155,9 @@ void Renderer::initPixelFBO() {
     glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, maskDepthRBO);
 
     if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
-        std::cerr << "[MASK FBO] Not complete!" << std::endl;
+        LOG_ERROR(Renderer, "Mask FBO not complete");
     else
-        std::cerr << "[MASK FBO] Complete OK - maskFBO=" << maskFBO << " maskTexture=" << maskTexture << std::endl;
+        LOG_DEBUG(Renderer, "Mask FBO complete, maskFBO={} maskTexture={}", maskFBO, maskTexture);
 
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
@@ -470,21 +470,21 @@ void Renderer::initTileQuad() {
     glBindVertexArray(0);
 }
 
-void Renderer::uploadChunk(const Chunk& chunk) {
+void Renderer::uploadChunk(const ChunkView& chunk) {
     // Build instance data for every tile in chunk
     std::vector<TileInstance> instances;
     instances.reserve(CHUNK_SIZE * CHUNK_SIZE);
 
     for (int y = 0; y < CHUNK_SIZE; y++) {
         for (int x = 0; x < CHUNK_SIZE; x++) {
-            const Tile& tile = chunk.getTile(x, y);
-            if (tile.type == TileType::NONE) continue;
+            const TileType type = chunk.types[Chunk::index(x, y)];
+            if (type == TileType::NONE) continue;
 
             float worldX = chunk.pos.x * CHUNK_SIZE + x;
             float worldY = chunk.pos.y * CHUNK_SIZE + y;
 
             // UV from atlas
-            TileUV uv = getUVForType(tile.type);
+            TileUV uv = getUVForType(type);
 
             TileInstance inst;
             inst.tilePos  = Vec3(worldX, worldY, 0.0f);
@@ -549,9 +549,10 @@ void Renderer::uploadChunk(const Chunk& chunk) {
 
     rd.instanceCount = static_cast<int>(instances.size());
     rd.uploaded = true;
+    rd.version = chunk.version;
 }
 
-void Renderer::renderChunks(const ChunkManager& chunkManager) {
+void Renderer::renderChunks(const RenderSnapshot& snapshot) {
     tileShader->use();
 
     // Camera
@@ -570,17 +571,15 @@ void Renderer::renderChunks(const ChunkManager& chunkManager) {
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 
-    // Draw each loaded chunk
-    for (auto& [pos, chunk] : chunkManager.getChunks()) {
-        // Upload if dirty
-        if (chunk.dirty) {
-            uploadChunk(chunk);
-            const_cast<Chunk&>(chunk).dirty = false;
+    // Draw each ready chunk of the snapshot
+    for (const auto& chunk : snapshot.chunks) {
+        // Upload if changed since the last upload
+        auto it = chunkRenderData.find(chunk->pos);
+        if (it == chunkRenderData.end() || it->second.version != chunk->version) {
+            uploadChunk(*chunk);
+            it = chunkRenderData.find(chunk->pos);
         }
 
-        auto it = chunkRenderData.find(pos);
-        if (it == chunkRenderData.end()) continue;
-
         ChunkRenderData& rd = it->second;
         if (!rd.uploaded || rd.instanceCount == 0) continue;
 
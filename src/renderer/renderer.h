@@ -7,7 +7,7 @@
 #include "shader/shader.h"
 #include "../utils/utils.h"
 #include "texture/texture.h"
-#include "../game/world/worldgen.h"
+#include "../game/rendersnapshot.h"
 #include "tiny_gltf.h"
 
 struct ChunkRenderData {
@@ -15,6 +15,7 @@ struct ChunkRenderData {
     GLuint instanceVBO = 0; // per instance data
     int    instanceCount = 0;
     bool   uploaded = false;
+    uint64_t version = 0;   // ChunkView::version of the uploaded tiles
 };
 
 struct TileInstance {
@@ -99,8 +100,8 @@ public:
     bool fullscreen = false;
 
     void initTileQuad();
-    void uploadChunk(const Chunk& chunk);
-    void renderChunks(const ChunkManager& chunkManager);
+    void uploadChunk(const ChunkView& chunk);
+    void renderChunks(const RenderSnapshot& snapshot);
     Vec2 tileTypeToUV(TileType type) const;
 
 private:
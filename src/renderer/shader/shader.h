@@ -3,7 +3,6 @@
 
 #include <glad/glad.h>
 #include <string>
-#include <iostream>
 #include "../../utils/utils.h" // pour la fonction LoadTextFile
 
 class Shader {
@@ -105,17 +104,17 @@ private:
             glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
             if (!success) {
                 glGetShaderInfoLog(shader, 1024, nullptr, infoLog);
-                std::cerr << "❌ Shader compile error (" << type << "):\n" << infoLog << std::endl;
+                LOG_ERROR(Renderer, "Shader compile error ({}):\n{}", type, infoLog);
             } else {
-                std::cerr << "✅ Shader OK: " << type << " (ID=" << shader << ")" << std::endl;
+                LOG_DEBUG(Renderer, "Shader compiled: {} (ID={})", type, shader);
             }
         } else {
             glGetProgramiv(shader, GL_LINK_STATUS, &success);
             if (!success) {
                 glGetProgramInfoLog(shader, 1024, nullptr, infoLog);
-                std::cerr << "❌ Program link error:\n" << infoLog << std::endl;
+                LOG_ERROR(Renderer, "Program link error:\n{}", infoLog);
             } else {
-                std::cerr << "✅ Program linked OK (ID=" << shader << ")" << std::endl;
+                LOG_DEBUG(Renderer, "Program linked (ID={})", shader);
             }
         }
     }
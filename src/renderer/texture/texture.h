@@ -1,6 +1,5 @@
 #include <unordered_map>
 #include <string>
-#include <iostream>
 #include <vector>
 #include <filesystem>
 #include <glad/glad.h>
@@ -68,7 +67,7 @@ private:
         int width, height, channels;
 
         if (!FileManager::LoadPNG(path, imageData, width, height, channels)) {
-            std::cerr << "[TextureManager] Failed to load " << path << std::endl;
+            LOG_ERROR(Renderer, "Failed to load texture {}", path);
             return 0;
         }
 
@@ -0,0 +1,65 @@
+#include "compression.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+    constexpr size_t MIN_RUN     = 3;
+    constexpr size_t MAX_RUN     = 130;
+    constexpr size_t MAX_LITERAL = 128;
+}
+
+void Compression::packRLE(std::span<const std::uint8_t> in, std::vector<std::uint8_t>& out) {
+    out.reserve(out.size() + in.size() + in.size() / MAX_LITERAL + 1);
+
+    size_t i = 0;
+    size_t literalStart = 0;
+
+    auto flushLiterals = [&](size_t end) {
+        while (literalStart < end) {
+            const size_t n = std::min(end - literalStart, MAX_LITERAL);
+            out.push_back(static_cast<std::uint8_t>(n - 1));
+            out.insert(out.end(), in.begin() + literalStart, in.begin() + literalStart + n);
+            literalStart += n;
+        }
+    };
+
+    while (i < in.size()) {
+        size_t run = 1;
+        while (i + run < in.size() && run < MAX_RUN && in[i + run] == in[i])
+            run++;
+
+        if (run >= MIN_RUN) {
+            flushLiterals(i);
+            out.push_back(static_cast<std::uint8_t>(run + 125));
+            out.push_back(in[i]);
+            i += run;
+            literalStart = i;
+        } else {
+            i += run;
+        }
+    }
+    flushLiterals(in.size());
+}
+
+bool Compression::unpackRLE(std::span<const std::uint8_t> in, std::span<std::uint8_t> out) {
+    size_t src = 0;
+    size_t dst = 0;
+
+    while (src < in.size() && dst < out.size()) {
+        const std::uint8_t c = in[src++];
+        if (c < 128) {
+            const size_t n = size_t(c) + 1;
+            if (src + n > in.size() || dst + n > out.size()) return false;
+            std::memcpy(out.data() + dst, in.data() + src, n);
+            src += n;
+            dst += n;
+        } else {
+            const size_t n = size_t(c) - 125;
+            if (src >= in.size() || dst + n > out.size()) return false;
+            std::memset(out.data() + dst, in[src++], n);
+            dst += n;
+        }
+    }
+    return dst == out.size();
+}
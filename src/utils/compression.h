@@ -0,0 +1,28 @@
+#ifndef COMPRESSION_H
+#define COMPRESSION_H
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// ------------------------
+//   COMPRESSION
+// ------------------------
+// Byte-oriented run-length coding (PackBits style). Cheap enough to run
+// per chunk, and very effective on planar tile data where long runs of the
+// same type / flag byte are the norm.
+//
+// Stream: control byte c
+//   c <  128 : c + 1 literal bytes follow
+//   c >= 128 : next byte repeated (c - 125) times (3..130)
+class Compression {
+public:
+    // Appends the packed form of `in` to `out`
+    static void packRLE(std::span<const std::uint8_t> in, std::vector<std::uint8_t>& out);
+
+    // Unpacks exactly out.size() bytes, false on malformed / short input
+    static bool unpackRLE(std::span<const std::uint8_t> in, std::span<std::uint8_t> out);
+};
+
+#endif // COMPRESSION_H
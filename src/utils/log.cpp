@@ -0,0 +1,278 @@
+#include "log.h"
+
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+std::atomic<LogLevel> Log::s_levels[static_cast<size_t>(LogCategory::Count)] = {
+    LogLevel::Info, LogLevel::Info, LogLevel::Info, LogLevel::Info, LogLevel::Info,
+};
+
+namespace {
+    constexpr size_t RING_BYTES = 256 * 1024;
+    constexpr auto   DRAIN_INTERVAL = std::chrono::milliseconds(5);
+
+    // Records of one thread. head and tail only grow, the byte offset is
+    // their value modulo RING_BYTES. A record never wraps: when it does not
+    // fit before the end, the producer writes a size 0 record there and
+    // starts again at offset 0
+    struct LogRing {
+        alignas(64) std::atomic<uint64_t> head{ 0 };   // written by the writer thread
+        alignas(64) std::atomic<uint64_t> tail{ 0 };   // written by the owning thread
+        uint64_t                          pending = 0; // tail once the reserved record is published
+
+        std::atomic<uint64_t> dropped{ 0 };
+        std::atomic<bool>     retired{ false };        // owning thread exited
+        LogRing*              next = nullptr;          // set once, before the ring is listed
+
+        alignas(64) uint8_t data[RING_BYTES];
+    };
+
+    // Every ring ever registered, newest first. Threads only push; the
+    // writer unlinks retired rings behind the head
+    std::atomic<LogRing*> s_rings{ nullptr };
+
+    class LogWriter {
+    public:
+        LogWriter() : start(std::chrono::steady_clock::now().time_since_epoch().count()) {
+            thread = std::thread([this] { run(); });
+        }
+
+        ~LogWriter() {
+            {
+                std::lock_guard lock(stopMutex);
+                stopping = true;
+            }
+            stopCv.notify_one();
+            thread.join();
+            drain();
+            if (out != stderr) std::fclose(out);
+        }
+
+        bool setFile(const std::string& path) {
+            FILE* file = std::fopen(path.c_str(), "a");
+            if (!file) return false;
+
+            std::lock_guard lock(drainMutex);
+            if (out != stderr) std::fclose(out);
+            out = file;
+            return true;
+        }
+
+        void drain() {
+            std::lock_guard lock(drainMutex);
+
+            pending.clear();
+            drained.clear();
+            uint64_t dropped = 0;
+
+            for (LogRing* ring = s_rings.load(std::memory_order_acquire); ring; ring = ring->next) {
+                const uint64_t tail = ring->tail.load(std::memory_order_acquire);
+                uint64_t       at   = ring->head.load(std::memory_order_relaxed);
+                while (at < tail) {
+                    // A wrap marker can sit less than a whole LogRecord before
+                    // the end: read its size alone first
+                    const size_t offset = at % RING_BYTES;
+                    uint32_t     size   = 0;
+                    std::memcpy(&size, ring->data + offset, sizeof(size));
+                    if (size == 0) {
+                        at += RING_BYTES - offset;
+                        continue;
+                    }
+                    LogRecord record;
+                    std::memcpy(&record, ring->data + offset, sizeof(record));
+                    pending.push_back({ record.time, ring->data + offset });
+                    at += size;
+                }
+                drained.push_back({ ring, tail });
+                dropped += ring->dropped.exchange(0, std::memory_order_relaxed);
+            }
+
+            // Rings are each in time order already, a stable sort merges them
+            std::stable_sort(pending.begin(), pending.end(),
+                             [](const Pending& a, const Pending& b) { return a.time < b.time; });
+
+            batch.clear();
+            for (const Pending& p : pending) {
+                LogRecord record;
+                std::memcpy(&record, p.at, sizeof(record));
+                appendLine(record.time, *record.site, [&](std::string& line) {
+                    record.format(line, record.site->format, p.at + sizeof(record));
+                });
+            }
+            if (dropped > 0) {
+                static constexpr LogSite site{ "", LogLevel::Warn, LogCategory::Core };
+                appendLine(std::chrono::steady_clock::now().time_since_epoch().count(), site, [&](std::string& line) {
+                    line.append(std::to_string(dropped)).append(" log records dropped, ring full");
+                });
+            }
+
+            // The records are copied out, hand the space back
+            for (const Drained& d : drained)
+                d.ring->head.store(d.tail, std::memory_order_release);
+
+            if (!batch.empty()) {
+                std::fwrite(batch.data(), 1, batch.size(), out);
+                std::fflush(out);
+            }
+            unlinkRetired();
+        }
+
+    private:
+        const int64_t start;
+        FILE*         out = stderr;
+
+        std::thread             thread;
+        std::mutex              stopMutex;
+        std::condition_variable stopCv;
+        bool                    stopping = false;
+
+        // Held for a whole drain: the writer thread and Log::flush can both drain
+        std::mutex drainMutex;
+        struct Pending {
+            int64_t        time;
+            const uint8_t* at;
+        };
+        struct Drained {
+            LogRing* ring;
+            uint64_t tail;
+        };
+        std::vector<Pending> pending;
+        std::vector<Drained> drained;
+        std::string          batch;
+
+        void run() {
+            std::unique_lock lock(stopMutex);
+            while (!stopping) {
+                stopCv.wait_for(lock, DRAIN_INTERVAL, [this] { return stopping; });
+                lock.unlock();
+                drain();
+                lock.lock();
+            }
+        }
+
+        //  12.345 I [ECS] message
+        template<typename FormatFn>
+        void appendLine(int64_t time, const LogSite& site, FormatFn&& formatMessage) {
+            static constexpr char LEVELS[] = "TDIWE";
+            const double seconds =
+                std::chrono::duration<double>(std::chrono::steady_clock::duration(time - start)).count();
+
+            char prefix[64];
+            const int n = std::snprintf(prefix, sizeof(prefix), "%9.3f %c [%s] ", seconds,
+                                        LEVELS[static_cast<size_t>(site.level)], Log::name(site.category));
+            batch.append(prefix, static_cast<size_t>(n));
+            formatMessage(batch);
+            batch.push_back('\n');
+        }
+
+        // Producers only ever push in front of the head, so anything behind
+        // it can be unlinked without racing them
+        void unlinkRetired() {
+            LogRing* prev = s_rings.load(std::memory_order_acquire);
+            if (!prev) return;
+            for (LogRing* ring = prev->next; ring; ring = prev->next) {
+                const bool empty = ring->head.load(std::memory_order_relaxed) ==
+                                   ring->tail.load(std::memory_order_acquire);
+                if (ring->retired.load(std::memory_order_acquire) && empty) {
+                    prev->next = ring->next;
+                    delete ring;
+                } else {
+                    prev = ring;
+                }
+            }
+        }
+    };
+
+    LogWriter& writer() {
+        static LogWriter instance;
+        return instance;
+    }
+
+    // The calling thread's ring, registered on first use and retired when
+    // the thread exits (the writer frees it once drained)
+    struct ThreadRing {
+        LogRing* ring = nullptr;
+
+        LogRing* get() {
+            if (!ring) {
+                (void)writer();
+                ring       = new LogRing();
+                ring->next = s_rings.load(std::memory_order_relaxed);
+                while (!s_rings.compare_exchange_weak(ring->next, ring, std::memory_order_release,
+                                                      std::memory_order_relaxed)) {}
+            }
+            return ring;
+        }
+
+        ~ThreadRing() {
+            if (ring) ring->retired.store(true, std::memory_order_release);
+            ring = nullptr;
+        }
+    };
+
+    thread_local ThreadRing t_ring;
+}
+
+// =====================
+// Log
+// =====================
+
+uint8_t* Log::reserve(size_t size) noexcept {
+    LogRing* ring = t_ring.get();
+    if (size > RING_BYTES / 2) {
+        ring->dropped.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    const uint64_t tail   = ring->tail.load(std::memory_order_relaxed);
+    const uint64_t used   = tail - ring->head.load(std::memory_order_acquire);
+    const size_t   offset = tail % RING_BYTES;
+    const size_t   skip   = offset + size > RING_BYTES ? RING_BYTES - offset : 0;
+
+    if (used + skip + size > RING_BYTES) {
+        ring->dropped.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+    if (skip) {
+        const uint32_t wrap = 0;
+        std::memcpy(ring->data + offset, &wrap, sizeof(wrap));
+    }
+    ring->pending = tail + skip + size;
+    return ring->data + (skip ? 0 : offset);
+}
+
+void Log::publish() noexcept {
+    LogRing* ring = t_ring.get();
+    ring->tail.store(ring->pending, std::memory_order_release);
+}
+
+void Log::setLevel(LogLevel level) noexcept {
+    for (auto& categoryLevel : s_levels)
+        categoryLevel.store(level, std::memory_order_relaxed);
+}
+
+void Log::setLevel(LogCategory category, LogLevel level) noexcept {
+    s_levels[static_cast<size_t>(category)].store(level, std::memory_order_relaxed);
+}
+
+bool Log::setFile(const std::string& path) {
+    return writer().setFile(path);
+}
+
+void Log::flush() {
+    writer().drain();
+}
+
+const char* Log::name(LogCategory category) noexcept {
+    switch (category) {
+    case LogCategory::Core:       return "Core";
+    case LogCategory::ECS:        return "ECS";
+    case LogCategory::Simulation: return "Simulation";
+    case LogCategory::World:      return "World";
+    case LogCategory::Renderer:   return "Renderer";
+    default:                      return "?";
+    }
+}
@@ -0,0 +1,227 @@
+#ifndef LOG_H
+#define LOG_H
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+// ------------------------
+//   LOG
+// ------------------------
+// Levelled, categorised logging kept off the hot path. A call site only
+// takes a timestamp and copies its arguments, unformatted, into a ring
+// owned by its thread (lock-free, one producer, one consumer). A
+// background thread formats the records, merges the rings of every
+// thread in time order and writes them to stderr or a file.
+//
+//   LOG_INFO(ECS, "Loaded {} recipes from {}", count, path);
+//
+// Each {} takes the next argument: integers, floating point (as %g),
+// bool, char, enums (underlying value), pointers and strings (char*,
+// std::string, std::string_view: the characters are copied, up to
+// MAX_STRING_BYTES). Levels below LOG_MIN_LEVEL are compiled out,
+// arguments included; the others are filtered at run time per category.
+// A full ring drops the record, counted and reported by the writer,
+// rather than blocking the caller.
+enum class LogLevel : uint8_t { Trace, Debug, Info, Warn, Error, Off };
+enum class LogCategory : uint8_t { Core, ECS, Simulation, World, Renderer, Count };
+
+// Lowest level compiled in, as a LogLevel value: Debug in debug builds, Info otherwise
+#ifndef LOG_MIN_LEVEL
+    #ifdef NDEBUG
+        #define LOG_MIN_LEVEL 2
+    #else
+        #define LOG_MIN_LEVEL 1
+    #endif
+#endif
+
+// One per call site, static: records point at it
+struct LogSite {
+    std::string_view format;
+    LogLevel         level;
+    LogCategory      category;
+};
+
+// Formats a record's arguments into out, following format
+using LogFormatFn = void (*)(std::string& out, std::string_view pattern, const uint8_t* args);
+
+// Fixed part of a record, its arguments follow
+struct LogRecord {
+    uint32_t       size     = 0;    // whole record, a multiple of 8; 0 skips to the end of the ring
+    uint32_t       argBytes = 0;
+    int64_t        time     = 0;    // steady_clock ticks
+    const LogSite* site     = nullptr;
+    LogFormatFn    format   = nullptr;
+};
+
+namespace logdetail {
+    inline constexpr size_t MAX_STRING_BYTES = 4096;
+
+    // How an argument is copied into a record and read back: values byte
+    // for byte, strings as [u32 length][characters]
+    template<typename T>
+    struct Arg {
+        static_assert(std::is_arithmetic_v<T> || std::is_enum_v<T> || std::is_pointer_v<T>,
+                      "unsupported log argument type");
+        using Stored = T;
+
+        static size_t size(const T&) noexcept { return sizeof(T); }
+        static uint8_t* put(uint8_t* at, const T& value) noexcept {
+            std::memcpy(at, &value, sizeof(T));
+            return at + sizeof(T);
+        }
+        static const uint8_t* get(const uint8_t* at, T& value) noexcept {
+            std::memcpy(&value, at, sizeof(T));
+            return at + sizeof(T);
+        }
+    };
+
+    struct StringArg {
+        using Stored = std::string_view;
+
+        static size_t size(std::string_view s) noexcept {
+            return sizeof(uint32_t) + std::min(s.size(), MAX_STRING_BYTES);
+        }
+        static uint8_t* put(uint8_t* at, std::string_view s) noexcept {
+            const auto length = static_cast<uint32_t>(std::min(s.size(), MAX_STRING_BYTES));
+            std::memcpy(at, &length, sizeof(length));
+            std::memcpy(at + sizeof(length), s.data(), length);
+            return at + sizeof(length) + length;
+        }
+        static const uint8_t* get(const uint8_t* at, std::string_view& s) noexcept {
+            uint32_t length = 0;
+            std::memcpy(&length, at, sizeof(length));
+            s = { reinterpret_cast<const char*>(at + sizeof(length)), length };
+            return at + sizeof(length) + length;
+        }
+    };
+
+    template<> struct Arg<const char*> : StringArg {
+        static size_t   size(const char* s) noexcept { return StringArg::size(s ? s : "(null)"); }
+        static uint8_t* put(uint8_t* at, const char* s) noexcept { return StringArg::put(at, s ? s : "(null)"); }
+    };
+    template<> struct Arg<char*> : Arg<const char*> {};
+    template<> struct Arg<std::string> : StringArg {};
+    template<> struct Arg<std::string_view> : StringArg {};
+
+    template<typename T>
+    void append(std::string& out, const T& value) {
+        char buffer[32];
+        if constexpr (std::is_same_v<T, std::string_view>) {
+            out.append(value);
+        } else if constexpr (std::is_same_v<T, bool>) {
+            out.append(value ? "true" : "false");
+        } else if constexpr (std::is_same_v<T, char>) {
+            out.push_back(value);
+        } else if constexpr (std::is_enum_v<T>) {
+            append(out, static_cast<std::underlying_type_t<T>>(value));
+        } else if constexpr (std::is_pointer_v<T>) {
+            const auto result = std::to_chars(buffer, buffer + sizeof(buffer), reinterpret_cast<uintptr_t>(value), 16);
+            out.append("0x").append(buffer, result.ptr);
+        } else if constexpr (std::is_floating_point_v<T>) {
+            const auto result = std::to_chars(buffer, buffer + sizeof(buffer), value, std::chars_format::general, 6);
+            out.append(buffer, result.ptr);
+        } else {
+            const auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+            out.append(buffer, result.ptr);
+        }
+    }
+
+    // Next argument in place of the next {}, extra arguments are dropped
+    template<typename T>
+    const uint8_t* appendNext(std::string& out, std::string_view pattern, size_t& at, const uint8_t* args) {
+        typename Arg<T>::Stored value{};
+        args = Arg<T>::get(args, value);
+
+        const size_t open = pattern.find("{}", at);
+        if (open == std::string_view::npos) return args;
+        out.append(pattern.substr(at, open - at));
+        append(out, value);
+        at = open + 2;
+        return args;
+    }
+
+    template<typename... Args>
+    void format(std::string& out, std::string_view pattern, [[maybe_unused]] const uint8_t* args) {
+        size_t at = 0;
+        ((args = appendNext<Args>(out, pattern, at, args)), ...);
+        out.append(pattern.substr(at));
+    }
+}
+
+class Log {
+public:
+    [[nodiscard]] static bool enabled(LogLevel level, LogCategory category) noexcept {
+        return level >= s_levels[static_cast<size_t>(category)].load(std::memory_order_relaxed);
+    }
+
+    // Use the LOG_* macros, they skip the arguments when the level is off
+    template<typename... Args>
+    static void write(const LogSite& site, const Args&... args);
+
+    // Lowest level written, for every category or one; Info by default
+    static void setLevel(LogLevel level) noexcept;
+    static void setLevel(LogCategory category, LogLevel level) noexcept;
+
+    // Append to path instead of stderr; false (and stderr kept) if it cannot be opened
+    static bool setFile(const std::string& path);
+
+    // Block until every record logged so far is written out
+    static void flush();
+
+    [[nodiscard]] static const char* name(LogCategory category) noexcept;
+
+private:
+    static std::atomic<LogLevel> s_levels[static_cast<size_t>(LogCategory::Count)];
+
+    // Room for size bytes in the calling thread's ring, nullptr (and a
+    // drop counted) when full; publish makes them visible to the writer
+    static uint8_t* reserve(size_t size) noexcept;
+    static void     publish() noexcept;
+};
+
+template<typename... Args>
+void Log::write(const LogSite& site, const Args&... args) {
+    const size_t argBytes = (size_t{ 0 } + ... + logdetail::Arg<std::decay_t<Args>>::size(args));
+    const size_t size     = (sizeof(LogRecord) + argBytes + 7) & ~size_t{ 7 };
+
+    uint8_t* at = reserve(size);
+    if (!at) return;
+
+    LogRecord record;
+    record.size     = static_cast<uint32_t>(size);
+    record.argBytes = static_cast<uint32_t>(argBytes);
+    record.time     = std::chrono::steady_clock::now().time_since_epoch().count();
+    record.site     = &site;
+    record.format   = &logdetail::format<std::decay_t<Args>...>;
+    std::memcpy(at, &record, sizeof(record));
+
+    [[maybe_unused]] uint8_t* cursor = at + sizeof(record);
+    ((cursor = logdetail::Arg<std::decay_t<Args>>::put(cursor, args)), ...);
+    publish();
+}
+
+#define LOG_AT(LEVEL, CATEGORY, FORMAT, ...)                                                                  \
+    do {                                                                                                      \
+        if constexpr (static_cast<int>(LogLevel::LEVEL) >= LOG_MIN_LEVEL) {                                    \
+            if (Log::enabled(LogLevel::LEVEL, LogCategory::CATEGORY)) {                                        \
+                static constexpr LogSite logSite_{ FORMAT, LogLevel::LEVEL, LogCategory::CATEGORY };           \
+                Log::write(logSite_ __VA_OPT__(, ) __VA_ARGS__);                                               \
+            }                                                                                                 \
+        }                                                                                                     \
+    } while (0)
+
+#define LOG_TRACE(CATEGORY, ...) LOG_AT(Trace, CATEGORY, __VA_ARGS__)
+#define LOG_DEBUG(CATEGORY, ...) LOG_AT(Debug, CATEGORY, __VA_ARGS__)
+#define LOG_INFO(CATEGORY, ...)  LOG_AT(Info, CATEGORY, __VA_ARGS__)
+#define LOG_WARN(CATEGORY, ...)  LOG_AT(Warn, CATEGORY, __VA_ARGS__)
+#define LOG_ERROR(CATEGORY, ...) LOG_AT(Error, CATEGORY, __VA_ARGS__)
+
+#endif // LOG_H
@@ -0,0 +1,39 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+
+// ------------------------
+//   MAPPED FILE (read-only)
+// ------------------------
+// Maps a whole file into memory. POSIX mmap on Linux, file mapping
+// objects on Windows. An empty or missing file gives an empty view.
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile() { close(); }
+
+    MappedFile(const MappedFile&)            = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    bool open(const std::string& path);
+    void close();
+
+    [[nodiscard]] bool                          isOpen() const { return data != nullptr; }
+    [[nodiscard]] std::span<const std::uint8_t> bytes()  const { return { data, length }; }
+
+private:
+    const std::uint8_t* data   = nullptr;
+    std::size_t         length = 0;
+#ifdef _WIN32
+    void* fileHandle    = nullptr;
+    void* mappingHandle = nullptr;
+#endif
+};
+
+#endif // MAPPEDFILE_H
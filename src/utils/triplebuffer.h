@@ -0,0 +1,45 @@
+#ifndef TRIPLEBUFFER_H
+#define TRIPLEBUFFER_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+// ------------------------
+//   TRIPLE BUFFER
+// ------------------------
+// Lock-free hand-over of the latest value from one producer thread to one
+// consumer thread. The producer fills back() and publishes it, the
+// consumer picks up the most recent publication with update() and reads
+// front(). Neither side ever waits; publications the consumer did not get
+// to are overwritten. Buffers are reused, so T can keep its capacity.
+template<typename T>
+class TripleBuffer {
+public:
+    // Producer side
+    T&   back() { return buffers[backIndex]; }
+    void publish() {
+        const uint8_t previous = middle.exchange(static_cast<uint8_t>(backIndex | FRESH), std::memory_order_acq_rel);
+        backIndex              = previous & INDEX_MASK;
+    }
+
+    // Consumer side: swap in the latest publication, false if nothing new
+    bool update() {
+        if (!(middle.load(std::memory_order_relaxed) & FRESH)) return false;
+        const uint8_t previous = middle.exchange(frontIndex, std::memory_order_acq_rel);
+        frontIndex             = previous & INDEX_MASK;
+        return true;
+    }
+    const T& front() const { return buffers[frontIndex]; }
+
+private:
+    static constexpr uint8_t INDEX_MASK = 0x3;
+    static constexpr uint8_t FRESH      = 0x4;   // middle holds a publication the consumer has not taken
+
+    std::array<T, 3>     buffers;
+    std::atomic<uint8_t> middle{ 1 };
+    uint8_t              backIndex  = 0;    // producer only
+    uint8_t              frontIndex = 2;    // consumer only
+};
+
+#endif // TRIPLEBUFFER_H
@@ -11,6 +11,8 @@
 #include <stdexcept>
 #include <iostream>
 
+#include "log.h"
+
 // ------------------------
 //   TEMPLATE VECTOR CLASS
 // ------------------------
@@ -270,7 +272,7 @@ public:
         namespace fs = std::filesystem;
         fs::path execPath = fs::current_path();
         basePath = execPath.string();
-        std::cout << "[FileManager] Base path: " << basePath << std::endl;
+        LOG_INFO(Core, "Base path: {}", basePath);
     }
 
     static void SetBasePath(const std::string& path) { basePath = path; }
@@ -0,0 +1,61 @@
+// Moving a building re-targets the transport lines around it: the line
+// that fed its old tile stops delivering into it, a line ending next to
+// its new tile starts. Two lines heading east, each carrying its own item,
+// and a chest moved from the end of one to the end of the other.
+//
+// usage: BeltMoveTest
+
+#include "game/ECS/ecs.h"
+
+#include <cstdio>
+#include <initializer_list>
+
+static int failures = 0;
+
+static void check(bool ok, const char* what) {
+    std::printf("%-52s %s\n", what, ok ? "ok" : "FAILED");
+    if (!ok) failures++;
+}
+
+// First belt of a line of length tiles heading east from (0, y)
+static entt::entity buildLine(ECSWorld& world, float y, int length) {
+    entt::entity first = entt::null;
+    for (int x = 0; x < length; x++) {
+        const auto belt = world.createBelt(static_cast<float>(x), y, Direction::East);
+        if (x == 0) first = belt;
+    }
+    return first;
+}
+
+// Ten seconds of ticks, one item on each feed every half second
+static void run(ECSWorld& world, std::initializer_list<std::pair<entt::entity, ItemId>> feeds) {
+    const float dt = 1.0f / ECSWorld::TICKS_PER_SECOND;
+    for (int t = 0; t < 10 * ECSWorld::TICKS_PER_SECOND; t++) {
+        if (t % (ECSWorld::TICKS_PER_SECOND / 2) == 0)
+            for (const auto& [belt, item] : feeds) (void)world.insertOnBelt(belt, item);
+        world.updateBelts(dt);
+    }
+}
+
+int main() {
+    ECSWorld     world;
+    const ItemId iron   = ItemRegistry::intern("iron_ore");
+    const ItemId copper = ItemRegistry::intern("copper_ore");
+
+    const auto lineA = buildLine(world, 0.0f, 4);   // ends at (4, 0)
+    const auto lineB = buildLine(world, 3.0f, 4);   // ends at (4, 3)
+    const auto chest = world.createBuilding("models/chest.gltf", 4.0f, 0.0f);
+
+    run(world, { { lineA, iron }, { lineB, copper } });
+    const auto& inv       = world.get<CInventory>(chest);
+    const int   ironFirst = inv.count(iron);
+    check(ironFirst > 0, "line A delivers into the chest");
+    check(inv.count(copper) == 0, "line B, ending on an empty tile, does not");
+
+    world.move(chest, 4.0f, 3.0f);
+    run(world, { { lineA, iron }, { lineB, copper } });
+    check(world.get<CInventory>(chest).count(iron) == ironFirst, "after the move, line A no longer delivers");
+    check(world.get<CInventory>(chest).count(copper) > 0, "after the move, line B delivers");
+
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,87 @@
+// Chunks saved over and over keep their region file bounded: a blob that
+// fits is rewritten in place, a growing one is appended and the region is
+// compacted once dead blobs outweigh the live ones. Every chunk still
+// loads back what was saved last, and an index entry pointing into the
+// header or index is ignored.
+//
+// usage: RegionRewriteTest
+
+#include "game/world/regionfile.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+
+static int failures = 0;
+
+static void check(bool ok, const char* what) {
+    std::printf("%-52s %s\n", what, ok ? "ok" : "FAILED");
+    if (!ok) failures++;
+}
+
+// count cells edited, the values depending on `seed`
+static ChunkDelta makeDelta(int count, int seed) {
+    ChunkDelta delta;
+    for (int i = 0; i < count; i++)
+        delta.set(i, { TileType::WATER, static_cast<int8_t>(seed), static_cast<int8_t>(i) });
+    return delta;
+}
+
+static bool loadsBack(const RegionStore& store, ChunkPos pos, const ChunkDelta& expected) {
+    ChunkDelta loaded;
+    if (!store.loadDelta(Chunk(pos), loaded) || loaded.size() != expected.size()) return false;
+    for (const ChunkDelta::Entry& e : expected.entries()) {
+        const TileCell* cell = loaded.find(e.index);
+        if (!cell || !(*cell == e.cell)) return false;
+    }
+    return true;
+}
+
+int main() {
+    const auto dir = std::filesystem::temp_directory_path() / "region_rewrite_test";
+    std::filesystem::remove_all(dir);
+
+    RegionStore    store(dir.string());
+    const ChunkPos a{ 0, 0 };
+    const ChunkPos b{ 1, 0 };
+    const auto     path = dir / "r.0.0.bin";
+
+    store.saveDelta(a, makeDelta(4, 1));
+    store.saveDelta(b, makeDelta(4, 1));
+    const auto size = std::filesystem::file_size(path);
+
+    // Same size and smaller blobs go where the old one was
+    ChunkDelta last = makeDelta(4, 2);
+    store.saveDelta(a, last);
+    store.saveDelta(a, last = makeDelta(2, 3));
+    check(std::filesystem::file_size(path) == size, "rewrite that fits does not grow the file");
+    check(loadsBack(store, a, last), "rewritten in place loads back");
+
+    // Growing by one cell each time appends every save: ~2.6 MB written
+    uintmax_t largest = 0;
+    for (int count = 3; count <= CHUNK_AREA; count++) {
+        if (!store.saveDelta(a, last = makeDelta(count, count))) break;
+        largest = std::max(largest, std::filesystem::file_size(path));
+    }
+    check(loadsBack(store, a, last), "grown chunk loads back");
+    check(loadsBack(store, b, makeDelta(4, 1)), "neighbour survives compaction");
+    check(largest < 2 * 1024 * 1024, "dead blobs are reclaimed");
+    check(!std::filesystem::exists(path.string() + ".tmp"), "no compaction leftovers");
+
+    // Point a's index entry (the first, after the 16 byte header) at the
+    // index itself: a is absent, saving it must not write over the index
+    {
+        const uint32_t entry[2] = { 16, 4096 };
+        std::fstream   file(path, std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp(16);
+        file.write(reinterpret_cast<const char*>(entry), sizeof(entry));
+    }
+    RegionStore reopened(dir.string());
+    check(!reopened.contains(a), "entry inside the index reads as absent");
+    check(reopened.saveDelta(a, last = makeDelta(1, 4)), "chunk with such an entry saves");
+    check(loadsBack(reopened, a, last) && loadsBack(reopened, b, makeDelta(4, 1)), "index intact after the save");
+
+    std::filesystem::remove_all(dir);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,135 @@
+// Malformed world snapshots are rejected: ECSWorld::load returns false and
+// leaves an empty world instead of handing bad input to the registry. A
+// valid snapshot of two buildings and a belt line carrying an item is
+// saved, then corrupted one way at a time.
+//
+// usage: SnapshotLoadTest
+
+#include "game/ECS/snapshot.h"
+
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+
+static int failures = 0;
+
+static void check(bool ok, const char* what) {
+    std::printf("%-52s %s\n", what, ok ? "ok" : "FAILED");
+    if (!ok) failures++;
+}
+
+// Payload offset of the first section tagged tag, 0 if there is none
+static size_t findSection(const std::vector<uint8_t>& bytes, uint32_t tag) {
+    size_t at = sizeof(SnapshotHeader);
+    while (at + sizeof(uint32_t) + sizeof(uint64_t) <= bytes.size()) {
+        uint32_t sectionTag  = 0;
+        uint64_t sectionSize = 0;
+        std::memcpy(&sectionTag, bytes.data() + at, sizeof(sectionTag));
+        std::memcpy(&sectionSize, bytes.data() + at + sizeof(sectionTag), sizeof(sectionSize));
+        at += sizeof(sectionTag) + sizeof(sectionSize);
+        if (sectionTag == tag) return at;
+        at += sectionSize;
+    }
+    return 0;
+}
+
+static size_t positions(ECSWorld& world) {
+    size_t n = 0;
+    world.forEach<CPosition>([&](entt::entity, CPosition&) { n++; });
+    return n;
+}
+
+// Load the saved snapshot after corrupt edited it, true if rejected with an empty world
+static bool rejects(const std::vector<uint8_t>& saved, const std::function<void(std::vector<uint8_t>&)>& corrupt) {
+    std::vector<uint8_t> bytes = saved;
+    corrupt(bytes);
+    ECSWorld world;
+    return !world.load(bytes) && positions(world) == 0;
+}
+
+int main() {
+    std::vector<uint8_t> saved;
+    {
+        ECSWorld world;
+        (void)world.createBuilding("models/chest.gltf", 0.0f, 0.0f);
+        (void)world.createBuilding("models/chest.gltf", 2.0f, 0.0f);
+
+        // One line of four belts, an item at its start
+        entt::entity first = entt::null;
+        for (int x = 3; x >= 0; x--)
+            first = world.createBelt(static_cast<float>(x), 5.0f, Direction::East);
+        (void)world.insertOnBelt(first, ItemRegistry::intern("iron-ore"));
+        world.save(saved);
+    }
+
+    ECSWorld copy;
+    check(copy.load(saved) && positions(copy) == 6, "valid snapshot loads");
+
+    const size_t cpos = findSection(saved, snapshotTag("CPOS"));
+    const size_t ents = findSection(saved, snapshotTag("ENTS"));
+    const size_t line = findSection(saved, snapshotTag("LINE"));
+    const size_t cblt = findSection(saved, snapshotTag("CBLT"));
+    check(cpos != 0 && ents != 0 && line != 0 && cblt != 0, "sections found");
+    if (cpos == 0 || ents == 0 || line == 0 || cblt == 0) return 1;
+
+    // [u32 slots][u32 free] then the one line: 21 bytes of placement,
+    // [u32 items][u32 active][u32 tail]
+    const size_t lineActive = line + 2 * sizeof(uint32_t) + 21 + sizeof(uint32_t);
+    const size_t lineTail   = lineActive + sizeof(uint32_t);
+
+    check(rejects(saved, [&](std::vector<uint8_t>& bytes) {
+        // [u32 count][entities]: the second entity becomes the first
+        std::memcpy(bytes.data() + cpos + sizeof(uint32_t) + sizeof(entt::entity),
+                    bytes.data() + cpos + sizeof(uint32_t), sizeof(entt::entity));
+    }), "entity repeated in a column is rejected");
+
+    check(rejects(saved, [&](std::vector<uint8_t>& bytes) {
+        // [u32 size][u32 in use]: more in use than stored
+        uint32_t size = 0;
+        std::memcpy(&size, bytes.data() + ents, sizeof(size));
+        const uint32_t inUse = size + 1;
+        std::memcpy(bytes.data() + ents + sizeof(size), &inUse, sizeof(inUse));
+    }), "entity storage with in use > size is rejected");
+
+    check(rejects(saved, [&](std::vector<uint8_t>& bytes) {
+        const uint32_t tail = 100000;
+        std::memcpy(bytes.data() + lineTail, &tail, sizeof(tail));
+    }), "line tail past its end is rejected");
+
+    check(rejects(saved, [&](std::vector<uint8_t>& bytes) {
+        // The item is still moving: nothing is compressed
+        const uint32_t active = 1;
+        std::memcpy(bytes.data() + lineActive, &active, sizeof(active));
+    }), "line active not matching the gaps is rejected");
+
+    check(rejects(saved, [&](std::vector<uint8_t>& bytes) {
+        // The line lists its first belt twice, the second one points past the
+        // lines: [u32 items][u32 active][u32 tail][one 6 byte item][u32 belts]
+        const size_t lineBelts = lineTail + sizeof(uint32_t) + 6 + sizeof(uint32_t);
+        entt::entity dropped;
+        std::memcpy(&dropped, bytes.data() + lineBelts + sizeof(entt::entity), sizeof(dropped));
+        std::memcpy(bytes.data() + lineBelts + sizeof(entt::entity), bytes.data() + lineBelts,
+                    sizeof(entt::entity));
+
+        // [u32 count][entities][values]
+        uint32_t count = 0;
+        std::memcpy(&count, bytes.data() + cblt, sizeof(count));
+        for (uint32_t i = 0; i < count; i++) {
+            entt::entity e;
+            std::memcpy(&e, bytes.data() + cblt + sizeof(count) + i * sizeof(entt::entity), sizeof(e));
+            if (e != dropped) continue;
+            const LineId missing = 7;
+            std::memcpy(bytes.data() + cblt + sizeof(count) + count * sizeof(entt::entity) + i * sizeof(CBelt) +
+                            offsetof(CBelt, line),
+                        &missing, sizeof(missing));
+        }
+    }), "belt on a missing line is rejected");
+
+    check(rejects(saved, [&](std::vector<uint8_t>& bytes) {
+        // [u32 tag][u64 size][payload]: an unknown tag is skipped
+        std::memcpy(bytes.data() + line - sizeof(uint64_t) - sizeof(uint32_t), "XXXX", sizeof(uint32_t));
+    }), "belts without a line section are rejected");
+
+    return failures == 0 ? 0 : 1;
+}